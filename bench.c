@@ -0,0 +1,1062 @@
+#include "src/abb.h"
+#include "src/abb_archivo.h"
+#include "src/abb_concurrente.h"
+#include "src/abb_congelado.h"
+#include "src/abb_estructura_privada.h"
+#include "src/abb_paralelo.h"
+#include "src/abb_persistente.h"
+#include "src/abb_tipado.h"
+#include <math.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define CONSULTAS 1000000
+#define CONSULTAS_POR_HILO 200000
+#define HILOS_MAXIMOS 32
+#define TRABAJO_POR_ELEMENTO 200
+#define SUITE_ARCHIVO "bench_output.txt"
+#define SUITE_OPERACIONES_MINIMAS 1000000
+#define SUITE_CUADRATICO 10000
+#define SUITE_UMBRAL 10.0
+#define SUITE_ZIPF_THETA 0.99
+
+ABB_DEFINIR(abb_i64, int64_t, ABB_COMPARAR_NUMEROS)
+
+/**
+ * Recibe dos void pointer, y los compara como si fueran enteros.
+*/
+int comparador(void *elemento1, void *elemento2)
+{
+	int numero1 = *(int *)elemento1, numero2 = *(int *)elemento2;
+	return (numero1 > numero2) - (numero1 < numero2);
+}
+
+/**
+ * Recibe un void pointer a un entero y devuelve una clave que respeta su
+ * orden (invertir el bit de signo lleva los negativos antes que los
+ * positivos).
+*/
+uint64_t clave_entero(void *elemento)
+{
+	return (uint32_t)*(int *)elemento ^ UINT32_C(0x80000000);
+}
+
+/**
+ * Devuelve el tiempo actual en nanosegundos.
+*/
+double ahora_ns()
+{
+	struct timespec tiempo;
+	clock_gettime(CLOCK_MONOTONIC, &tiempo);
+	return (double)tiempo.tv_sec * 1e9 + (double)tiempo.tv_nsec;
+}
+
+/**
+ * Recibe el estado de un generador xorshift64 y devuelve el siguiente número
+ * pseudo-aleatorio. Se usa en vez de rand() para que los resultados sean
+ * reproducibles en cualquier plataforma.
+*/
+uint64_t aleatorio(uint64_t *estado)
+{
+	*estado ^= *estado << 13;
+	*estado ^= *estado >> 7;
+	*estado ^= *estado << 17;
+	return *estado;
+}
+
+/**
+ * Recibe un array de enteros y su tamaño, y lo mezcla (Fisher-Yates).
+*/
+void mezclar(int *numeros, size_t cantidad, uint64_t *estado)
+{
+	for (size_t i = cantidad - 1; i > 0; i--) {
+		size_t j = aleatorio(estado) % (i + 1);
+		int auxiliar = numeros[i];
+		numeros[i] = numeros[j];
+		numeros[j] = auxiliar;
+	}
+}
+
+/**
+ * Recibe una función de búsqueda, la estructura donde buscar y un array de
+ * consultas, y devuelve cuántos nanosegundos tarda en promedio cada búsqueda.
+*/
+double medir_busquedas(void *(*buscar)(void *, void *), void *estructura,
+		       int *consultas, size_t cantidad_consultas)
+{
+	size_t encontrados = 0;
+	double inicio = ahora_ns();
+	for (size_t i = 0; i < cantidad_consultas; i++)
+		encontrados += buscar(estructura, &consultas[i]) != NULL;
+	double fin = ahora_ns();
+	if (encontrados != cantidad_consultas)
+		fprintf(stderr, "Faltaron elementos al buscar.\n");
+	return (fin - inicio) / (double)cantidad_consultas;
+}
+
+/**
+ * Igual que medir_busquedas, pero busca todas las consultas con una sola
+ * llamada a abb_buscar_lote.
+*/
+double medir_busquedas_lote(abb_t *arbol, int *consultas,
+			    size_t cantidad_consultas)
+{
+	void **claves = malloc(cantidad_consultas * sizeof(void *));
+	void **resultados = malloc(cantidad_consultas * sizeof(void *));
+	if (!claves || !resultados) {
+		fprintf(stderr, "No hay memoria para las consultas.\n");
+		exit(1);
+	}
+	for (size_t i = 0; i < cantidad_consultas; i++)
+		claves[i] = &consultas[i];
+	double inicio = ahora_ns();
+	size_t encontrados = abb_buscar_lote(arbol, claves, cantidad_consultas,
+					     resultados);
+	double fin = ahora_ns();
+	if (encontrados != cantidad_consultas)
+		fprintf(stderr, "Faltaron elementos al buscar.\n");
+	free(claves);
+	free(resultados);
+	return (fin - inicio) / (double)cantidad_consultas;
+}
+
+void *buscar_en_abb(void *arbol, void *elemento)
+{
+	return abb_buscar(arbol, elemento);
+}
+
+void *buscar_en_tipado(void *arbol, void *elemento)
+{
+	return abb_i64_buscar(arbol, *(int *)elemento);
+}
+
+void *buscar_en_congelado(void *congelado, void *elemento)
+{
+	return abb_congelado_buscar(congelado, elemento);
+}
+
+/**
+ * Compara abb_buscar en un arbol balanceado (armado con inserciones en orden
+ * aleatorio, así los nodos quedan dispersos como en un arbol real) con
+ * abb_buscar_lote en el mismo arbol, con abb_buscar en un arbol con las claves
+ * en los nodos (ver abb_crear_con_clave), con un arbol tipado de int64_t (ver
+ * abb_tipado.h), con abb_buscar en un arbol multiclave armado con las mismas
+ * inserciones, y con abb_congelado_buscar sobre fotos del arbol balanceado, con
+ * la disposición de Eytzinger y con la de van Emde Boas.
+*/
+void bench_busqueda(size_t cantidad)
+{
+	uint64_t estado = 0x9e3779b97f4a7c15;
+	int *numeros = malloc(cantidad * sizeof(int));
+	int *consultas = malloc(CONSULTAS * sizeof(int));
+	abb_t *arbol = abb_crear_balanceado(comparador);
+	abb_t *multiclave = abb_crear_multiclave(comparador);
+	abb_t *con_clave = abb_crear_con_clave(comparador, clave_entero);
+	abb_i64_t *tipado = abb_i64_crear();
+	if (!numeros || !consultas || !arbol || !multiclave || !con_clave ||
+	    !tipado) {
+		fprintf(stderr, "No hay memoria para %zu elementos.\n",
+			cantidad);
+		exit(1);
+	}
+	for (size_t i = 0; i < cantidad; i++)
+		numeros[i] = (int)i;
+	mezclar(numeros, cantidad, &estado);
+	for (size_t i = 0; i < cantidad; i++) {
+		abb_insertar(arbol, &numeros[i]);
+		abb_insertar(multiclave, &numeros[i]);
+		abb_insertar(con_clave, &numeros[i]);
+		abb_i64_insertar(tipado, numeros[i]);
+	}
+	for (size_t i = 0; i < CONSULTAS; i++)
+		consultas[i] = (int)(aleatorio(&estado) % cantidad);
+	abb_congelado_t *congelado = abb_congelar(arbol);
+	abb_congelado_t *congelado_veb = abb_congelar_veb(arbol);
+
+	printf("buscar n=%zu\n", cantidad);
+	printf("  abb_buscar            %8.1f ns/op\n",
+	       medir_busquedas(buscar_en_abb, arbol, consultas, CONSULTAS));
+	printf("  abb_buscar_lote       %8.1f ns/op\n",
+	       medir_busquedas_lote(arbol, consultas, CONSULTAS));
+	printf("  abb_buscar con clave  %8.1f ns/op\n",
+	       medir_busquedas(buscar_en_abb, con_clave, consultas,
+			       CONSULTAS));
+	printf("  abb_i64_buscar        %8.1f ns/op\n",
+	       medir_busquedas(buscar_en_tipado, tipado, consultas, CONSULTAS));
+	printf("  abb_buscar multiclave %8.1f ns/op\n",
+	       medir_busquedas(buscar_en_abb, multiclave, consultas,
+			       CONSULTAS));
+	printf("  congelado eytzinger   %8.1f ns/op\n",
+	       medir_busquedas(buscar_en_congelado, congelado, consultas,
+			       CONSULTAS));
+	printf("  congelado veb         %8.1f ns/op\n",
+	       medir_busquedas(buscar_en_congelado, congelado_veb, consultas,
+			       CONSULTAS));
+
+	abb_congelado_destruir(congelado);
+	abb_congelado_destruir(congelado_veb);
+	abb_destruir(arbol);
+	abb_destruir(multiclave);
+	abb_destruir(con_clave);
+	abb_i64_destruir(tipado);
+	free(consultas);
+	free(numeros);
+}
+
+/**
+ * Lo que recibe cada hilo del benchmark concurrente: dónde buscar, y si
+ * tiene que hacerlo a través del envoltorio concurrente o del arbol con un
+ * mutex global.
+*/
+struct hilo_lector {
+	abb_concurrente_t *concurrente;
+	abb_t *arbol;
+	pthread_mutex_t *mutex;
+	int *consultas;
+	size_t encontrados;
+};
+
+void *leer_con_envoltorio(void *hilo)
+{
+	struct hilo_lector *lector = hilo;
+	for (size_t i = 0; i < CONSULTAS_POR_HILO; i++)
+		lector->encontrados += abb_concurrente_buscar(
+					       lector->concurrente,
+					       &lector->consultas[i]) != NULL;
+	return NULL;
+}
+
+void *leer_con_mutex(void *hilo)
+{
+	struct hilo_lector *lector = hilo;
+	for (size_t i = 0; i < CONSULTAS_POR_HILO; i++) {
+		pthread_mutex_lock(lector->mutex);
+		lector->encontrados +=
+			abb_buscar(lector->arbol, &lector->consultas[i]) !=
+			NULL;
+		pthread_mutex_unlock(lector->mutex);
+	}
+	return NULL;
+}
+
+/**
+ * Lanza la cantidad de hilos recibida, cada uno haciendo CONSULTAS_POR_HILO
+ * búsquedas con la función recibida, y devuelve cuántos millones de
+ * búsquedas por segundo se hicieron entre todos.
+*/
+double medir_hilos(void *(*leer)(void *), struct hilo_lector *lectores,
+		   size_t hilos)
+{
+	pthread_t ids[HILOS_MAXIMOS];
+	double inicio = ahora_ns();
+	for (size_t i = 0; i < hilos; i++)
+		pthread_create(&ids[i], NULL, leer, &lectores[i]);
+	for (size_t i = 0; i < hilos; i++)
+		pthread_join(ids[i], NULL);
+	double fin = ahora_ns();
+	return (double)(hilos * CONSULTAS_POR_HILO) / (fin - inicio) * 1e3;
+}
+
+/**
+ * Compara búsquedas desde varios hilos a la vez en un arbol balanceado
+ * protegido con un mutex global, y envuelto con abb_concurrente_crear. Solo
+ * escala si la máquina tiene varios núcleos.
+*/
+void bench_concurrente(size_t cantidad)
+{
+	uint64_t estado = 0x2545f4914f6cdd1d;
+	int *numeros = malloc(cantidad * sizeof(int));
+	int *consultas = malloc(HILOS_MAXIMOS * CONSULTAS_POR_HILO *
+				sizeof(int));
+	abb_t *arbol = abb_crear_balanceado(comparador);
+	if (!numeros || !consultas || !arbol) {
+		fprintf(stderr, "No hay memoria para %zu elementos.\n",
+			cantidad);
+		exit(1);
+	}
+	for (size_t i = 0; i < cantidad; i++)
+		numeros[i] = (int)i;
+	mezclar(numeros, cantidad, &estado);
+	for (size_t i = 0; i < cantidad; i++)
+		abb_insertar(arbol, &numeros[i]);
+	for (size_t i = 0; i < HILOS_MAXIMOS * CONSULTAS_POR_HILO; i++)
+		consultas[i] = (int)(aleatorio(&estado) % cantidad);
+	abb_concurrente_t *concurrente = abb_concurrente_crear(arbol);
+	pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+	struct hilo_lector lectores[HILOS_MAXIMOS];
+	for (size_t i = 0; i < HILOS_MAXIMOS; i++)
+		lectores[i] = (struct hilo_lector){
+			.concurrente = concurrente,
+			.arbol = arbol,
+			.mutex = &mutex,
+			.consultas = consultas + i * CONSULTAS_POR_HILO
+		};
+
+	printf("buscar concurrente n=%zu (millones de búsquedas por segundo)\n",
+	       cantidad);
+	for (size_t hilos = 1; hilos <= HILOS_MAXIMOS; hilos *= 2) {
+		double con_mutex = medir_hilos(leer_con_mutex, lectores, hilos);
+		double con_envoltorio =
+			medir_hilos(leer_con_envoltorio, lectores, hilos);
+		printf("  %2zu hilos  mutex %7.2f  abb_concurrente %7.2f\n",
+		       hilos, con_mutex, con_envoltorio);
+	}
+
+	abb_concurrente_destruir(concurrente, NULL);
+	free(consultas);
+	free(numeros);
+}
+
+struct copia {
+	void **array;
+	size_t cantidad;
+};
+
+/**
+ * Recibe un elemento y un struct copia, y copia el elemento en la siguiente
+ * posición del array, como lo hacía abb_recorrer antes de tener su propio
+ * recorrido.
+*/
+bool copiar_elemento(void *elemento, void *copia)
+{
+	struct copia *estado = copia;
+	estado->array[estado->cantidad++] = elemento;
+	return true;
+}
+
+/**
+ * Recibe un nodo y un struct copia, y copia los elementos del sub-árbol en
+ * inorden con la recursión escrita a mano, como referencia.
+*/
+void copiar_a_mano(struct nodo_abb *nodo, struct copia *copia)
+{
+	if (!nodo)
+		return;
+	copiar_a_mano(nodo->izquierda, copia);
+	copia->array[copia->cantidad++] = nodo->elemento;
+	copiar_a_mano(nodo->derecha, copia);
+}
+
+/**
+ * Compara copiar un arbol a un array en inorden con abb_recorrer, con
+ * abb_con_cada_elemento y una función que copia, y con una recursión escrita
+ * a mano.
+*/
+void bench_recorrer(size_t cantidad)
+{
+	uint64_t estado = 0x853c49e6748fea9b;
+	int *numeros = malloc(cantidad * sizeof(int));
+	void **array = malloc(cantidad * sizeof(void *));
+	abb_t *arbol = abb_crear_balanceado(comparador);
+	if (!numeros || !array || !arbol) {
+		fprintf(stderr, "No hay memoria para %zu elementos.\n",
+			cantidad);
+		exit(1);
+	}
+	for (size_t i = 0; i < cantidad; i++)
+		numeros[i] = (int)i;
+	mezclar(numeros, cantidad, &estado);
+	for (size_t i = 0; i < cantidad; i++)
+		abb_insertar(arbol, &numeros[i]);
+
+	printf("recorrer inorden n=%zu (ns/elemento)\n", cantidad);
+	double inicio = ahora_ns();
+	abb_recorrer(arbol, INORDEN, array, cantidad);
+	printf("  abb_recorrer          %8.2f\n",
+	       (ahora_ns() - inicio) / (double)cantidad);
+	struct copia copia = { .array = array };
+	inicio = ahora_ns();
+	abb_con_cada_elemento(arbol, INORDEN, copiar_elemento, &copia);
+	printf("  abb_con_cada_elemento %8.2f\n",
+	       (ahora_ns() - inicio) / (double)cantidad);
+	copia.cantidad = 0;
+	inicio = ahora_ns();
+	copiar_a_mano(arbol->nodo_raiz, &copia);
+	printf("  recursión a mano      %8.2f\n",
+	       (ahora_ns() - inicio) / (double)cantidad);
+
+	abb_destruir(arbol);
+	free(array);
+	free(numeros);
+}
+
+/**
+ * Compara agregar a un arbol los elementos de otro con un décimo de su
+ * tamaño, insertándolos de a uno y con abb_union.
+*/
+void bench_union(size_t cantidad)
+{
+	uint64_t estado = 0xda942042e4dd58b5;
+	size_t delta = cantidad / 10;
+	int *numeros = malloc((cantidad + delta) * sizeof(int));
+	abb_t *base = abb_crear_balanceado(comparador);
+	abb_t *nuevos = abb_crear_balanceado(comparador);
+	if (!numeros || !base || !nuevos) {
+		fprintf(stderr, "No hay memoria para %zu elementos.\n",
+			cantidad);
+		exit(1);
+	}
+	for (size_t i = 0; i < cantidad + delta; i++)
+		numeros[i] = (int)i;
+	mezclar(numeros, cantidad + delta, &estado);
+	for (size_t i = 0; i < cantidad; i++)
+		abb_insertar(base, &numeros[i]);
+	for (size_t i = cantidad; i < cantidad + delta; i++)
+		abb_insertar(nuevos, &numeros[i]);
+
+	printf("agregar %zu elementos a n=%zu (ms)\n", delta, cantidad);
+	double inicio = ahora_ns();
+	abb_t *union_ab = abb_union(base, nuevos);
+	printf("  abb_union             %8.2f\n",
+	       (ahora_ns() - inicio) / 1e6);
+	inicio = ahora_ns();
+	for (size_t i = cantidad; i < cantidad + delta; i++)
+		abb_insertar(base, &numeros[i]);
+	printf("  abb_insertar          %8.2f\n",
+	       (ahora_ns() - inicio) / 1e6);
+
+	abb_destruir(union_ab);
+	abb_destruir(base);
+	abb_destruir(nuevos);
+	free(numeros);
+}
+
+/**
+ * Compara quitar el décimo más chico de un arbol con abb_dividir y con
+ * abb_quitar de a uno, y mide volver a unir las partes con abb_unir.
+*/
+void bench_dividir(size_t cantidad)
+{
+	int *numeros = malloc(cantidad * sizeof(int));
+	abb_t *arbol = abb_crear_balanceado(comparador);
+	abb_t *copia = abb_crear_balanceado(comparador);
+	if (!numeros || !arbol || !copia) {
+		fprintf(stderr, "No hay memoria para %zu elementos.\n",
+			cantidad);
+		exit(1);
+	}
+	for (size_t i = 0; i < cantidad; i++) {
+		numeros[i] = (int)i;
+		abb_insertar(arbol, &numeros[i]);
+		abb_insertar(copia, &numeros[i]);
+	}
+	int pivote = (int)(cantidad / 10);
+
+	printf("quitar los %d menores de n=%zu (us)\n", pivote, cantidad);
+	abb_t *menores, *mayores;
+	double inicio = ahora_ns();
+	abb_dividir(arbol, &pivote, &menores, &mayores);
+	printf("  abb_dividir           %10.2f\n",
+	       (ahora_ns() - inicio) / 1e3);
+	inicio = ahora_ns();
+	arbol = abb_unir(menores, mayores);
+	printf("  abb_unir              %10.2f\n",
+	       (ahora_ns() - inicio) / 1e3);
+	inicio = ahora_ns();
+	for (int i = 0; i < pivote; i++)
+		abb_quitar(copia, &numeros[i]);
+	printf("  abb_quitar            %10.2f\n",
+	       (ahora_ns() - inicio) / 1e3);
+
+	abb_destruir(arbol);
+	abb_destruir(copia);
+	free(numeros);
+}
+
+/**
+ * Recibe un void pointer a un entero, un buffer y su tamaño, y copia el
+ * entero al buffer si entra. Devuelve el tamaño de un entero.
+*/
+size_t serializar_entero(void *elemento, void *buffer, size_t tamanio)
+{
+	if (tamanio >= sizeof(int))
+		memcpy(buffer, elemento, sizeof(int));
+	return sizeof(int);
+}
+
+/**
+ * Compara volver a armar un arbol insertando sus elementos con cargarlo de un
+ * archivo escrito con abb_guardar, y mide las búsquedas en el mapeado.
+*/
+void bench_archivo(size_t cantidad)
+{
+	uint64_t estado = 0x6a09e667f3bcc909;
+	int *numeros = malloc(cantidad * sizeof(int));
+	int *consultas = malloc(CONSULTAS * sizeof(int));
+	if (!numeros || !consultas) {
+		fprintf(stderr, "No hay memoria para %zu elementos.\n",
+			cantidad);
+		exit(1);
+	}
+	for (size_t i = 0; i < cantidad; i++)
+		numeros[i] = (int)i;
+	mezclar(numeros, cantidad, &estado);
+	for (size_t i = 0; i < CONSULTAS; i++)
+		consultas[i] = (int)(aleatorio(&estado) % cantidad);
+
+	printf("arrancar con n=%zu (ms)\n", cantidad);
+	double inicio = ahora_ns();
+	abb_t *arbol = abb_crear_balanceado(comparador);
+	for (size_t i = 0; i < cantidad; i++)
+		abb_insertar(arbol, &numeros[i]);
+	printf("  insertar              %8.2f\n", (ahora_ns() - inicio) / 1e6);
+	char ruta[] = "/tmp/bench_abb_XXXXXX";
+	int fd = mkstemp(ruta);
+	inicio = ahora_ns();
+	bool guardado = fd >= 0 && abb_guardar(arbol, fd, serializar_entero);
+	printf("  abb_guardar           %8.2f\n", (ahora_ns() - inicio) / 1e6);
+	if (fd >= 0)
+		close(fd);
+	inicio = ahora_ns();
+	abb_t *cargado = guardado ? abb_cargar_mmap(ruta, comparador) : NULL;
+	printf("  abb_cargar_mmap       %8.2f\n", (ahora_ns() - inicio) / 1e6);
+	inicio = ahora_ns();
+	bool verificado = cargado && abb_verificar_mmap(cargado);
+	printf("  abb_verificar_mmap    %8.2f%s\n", (ahora_ns() - inicio) / 1e6,
+	       verificado ? "" : " (falló)");
+	if (cargado)
+		printf("  buscar en el mapeado  %8.1f ns/op\n",
+		       medir_busquedas(buscar_en_abb, cargado, consultas,
+				       CONSULTAS));
+
+	abb_destruir(cargado);
+	abb_destruir(arbol);
+	unlink(ruta);
+	free(consultas);
+	free(numeros);
+}
+
+/**
+ * Recibe un elemento y la suma de un hilo, y le suma un hash del elemento
+ * que cuesta TRABAJO_POR_ELEMENTO rondas de xorshift, para simular una
+ * función que hace algo más que leer el elemento.
+*/
+bool trabajar_elemento(void *elemento, void *suma)
+{
+	uint64_t estado = (uint64_t)*(int *)elemento + 1;
+	for (int i = 0; i < TRABAJO_POR_ELEMENTO; i++)
+		aleatorio(&estado);
+	*(uint64_t *)suma += estado;
+	return true;
+}
+
+/**
+ * Compara el armado desde un array ordenado y el recorrido con una función
+ * cara, secuenciales y con abb_paralelo, para distintas cantidades de hilos.
+ * Como bench_concurrente, solo muestra una mejora si la máquina tiene varios
+ * núcleos.
+*/
+void bench_paralelo(size_t cantidad)
+{
+	int *numeros = malloc(cantidad * sizeof(int));
+	void **elementos = malloc(cantidad * sizeof(void *));
+	if (!numeros || !elementos) {
+		fprintf(stderr, "No hay memoria para %zu elementos.\n",
+			cantidad);
+		exit(1);
+	}
+	for (size_t i = 0; i < cantidad; i++) {
+		numeros[i] = (int)i;
+		elementos[i] = &numeros[i];
+	}
+	uint64_t sumas[HILOS_MAXIMOS];
+	void *aux[HILOS_MAXIMOS];
+	for (size_t i = 0; i < HILOS_MAXIMOS; i++)
+		aux[i] = &sumas[i];
+
+	printf("paralelo n=%zu (ms)\n", cantidad);
+	double inicio = ahora_ns();
+	abb_t *arbol = abb_crear_desde_ordenado(comparador, elementos, cantidad);
+	double armado = (ahora_ns() - inicio) / 1e6;
+	inicio = ahora_ns();
+	abb_con_cada_elemento(arbol, INORDEN, trabajar_elemento, aux[0]);
+	double recorrido = (ahora_ns() - inicio) / 1e6;
+	abb_destruir(arbol);
+	printf("  secuencial  armar %8.2f  recorrer %8.2f\n", armado,
+	       recorrido);
+	for (size_t hilos = 2; hilos <= HILOS_MAXIMOS; hilos *= 2) {
+		inicio = ahora_ns();
+		arbol = abb_crear_desde_ordenado_paralelo(comparador, elementos,
+							  cantidad, hilos);
+		armado = (ahora_ns() - inicio) / 1e6;
+		inicio = ahora_ns();
+		abb_con_cada_elemento_paralelo(arbol, trabajar_elemento, aux,
+					       hilos);
+		recorrido = (ahora_ns() - inicio) / 1e6;
+		abb_destruir(arbol);
+		printf("  %2zu hilos    armar %8.2f  recorrer %8.2f\n", hilos,
+		       armado, recorrido);
+	}
+
+	free(elementos);
+	free(numeros);
+}
+
+/**
+ * Compara tomar una foto de un arbol persistente con copiar los elementos de
+ * un AVL común con abb_recorrer, y mide insertar creando versiones contra
+ * insertar en el AVL.
+*/
+void bench_persistente(size_t cantidad)
+{
+	int *numeros = malloc(cantidad * sizeof(int));
+	void **copia = malloc(cantidad * sizeof(void *));
+	abb_t *arbol = abb_crear_balanceado(comparador);
+	abb_version_t *version = abb_version_crear(comparador);
+	if (!numeros || !copia || !arbol || !version) {
+		fprintf(stderr, "No hay memoria para %zu elementos.\n",
+			cantidad);
+		exit(1);
+	}
+	uint64_t estado = 42;
+	for (size_t i = 0; i < cantidad; i++)
+		numeros[i] = (int)(aleatorio(&estado) >> 33);
+
+	printf("insertar n=%zu (ns/elem)\n", cantidad);
+	double inicio = ahora_ns();
+	for (size_t i = 0; i < cantidad; i++)
+		abb_insertar(arbol, &numeros[i]);
+	printf("  abb_insertar          %10.1f\n",
+	       (ahora_ns() - inicio) / (double)cantidad);
+	inicio = ahora_ns();
+	for (size_t i = 0; i < cantidad; i++) {
+		abb_version_t *nueva =
+			abb_version_insertar(version, &numeros[i]);
+		abb_version_liberar(version);
+		version = nueva;
+	}
+	printf("  abb_version_insertar  %10.1f\n",
+	       (ahora_ns() - inicio) / (double)cantidad);
+
+	printf("foto de n=%zu (us)\n", cantidad);
+	inicio = ahora_ns();
+	abb_recorrer(arbol, INORDEN, copia, cantidad);
+	printf("  abb_recorrer          %10.2f\n",
+	       (ahora_ns() - inicio) / 1e3);
+	inicio = ahora_ns();
+	abb_version_t *foto = abb_version_tomar(version);
+	printf("  abb_version_tomar     %10.2f\n",
+	       (ahora_ns() - inicio) / 1e3);
+
+	abb_version_liberar(foto);
+	abb_version_liberar(version);
+	abb_destruir(arbol);
+	free(copia);
+	free(numeros);
+}
+
+/**
+ * Inserta cantidad copias de un mismo elemento entre cantidad elementos
+ * distintos y mide insertar, buscar los elementos distintos y contar las
+ * copias en un arbol común, uno balanceado y un multiconjunto.
+*/
+void bench_multiconjunto(size_t cantidad)
+{
+	int *numeros = malloc(2 * cantidad * sizeof(int));
+	if (!numeros) {
+		fprintf(stderr, "No hay memoria para %zu elementos.\n",
+			cantidad);
+		exit(1);
+	}
+	for (size_t i = 0; i < cantidad; i++) {
+		numeros[2 * i] = (int)(cantidad / 2);
+		numeros[2 * i + 1] = (int)i;
+	}
+	const char *nombres[3] = { "abb_crear", "abb_crear_balanceado",
+				   "abb_crear_multiconjunto" };
+	abb_t *(*crear[3])(abb_comparador) = { abb_crear, abb_crear_balanceado,
+					       abb_crear_multiconjunto };
+	printf("%zu copias de un elemento entre %zu distintos (ms)\n",
+	       cantidad, cantidad);
+	printf("  %-24s %10s %10s %10s\n", "", "insertar", "buscar",
+	       "contar");
+	for (int tipo = 0; tipo < 3; tipo++) {
+		abb_t *arbol = crear[tipo](comparador);
+		if (!arbol) {
+			fprintf(stderr, "No hay memoria.\n");
+			exit(1);
+		}
+		double inicio = ahora_ns();
+		for (size_t i = 0; i < 2 * cantidad; i++)
+			abb_insertar(arbol, &numeros[i]);
+		double insertar = ahora_ns() - inicio;
+		inicio = ahora_ns();
+		size_t encontrados = 0;
+		for (size_t i = 0; i < cantidad; i++)
+			encontrados += abb_buscar(arbol, &numeros[2 * i + 1]) !=
+				       NULL;
+		double buscar = ahora_ns() - inicio;
+		inicio = ahora_ns();
+		size_t copias = abb_contar(arbol, &numeros[0]);
+		double contar = ahora_ns() - inicio;
+		printf("  %-24s %10.2f %10.2f %10.3f\n", nombres[tipo],
+		       insertar / 1e6, buscar / 1e6, contar / 1e6);
+		if (encontrados != cantidad || copias != cantidad + 1)
+			fprintf(stderr, "Resultados incorrectos.\n");
+		abb_destruir(arbol);
+	}
+	free(numeros);
+}
+
+enum distribucion { ORDENADA, INVERSA, UNIFORME, ZIPF, DISTRIBUCIONES };
+
+const char *NOMBRES_DISTRIBUCION[DISTRIBUCIONES] = { "ordenada", "inversa",
+						     "uniforme", "zipf" };
+
+enum operacion_suite {
+	SUITE_INSERTAR,
+	SUITE_BUSCAR,
+	SUITE_QUITAR,
+	SUITE_CON_CADA_ELEMENTO,
+	SUITE_RECORRER,
+	SUITE_OPERACIONES
+};
+
+const char *NOMBRES_OPERACION[SUITE_OPERACIONES] = {
+	"abb_insertar", "abb_buscar", "abb_quitar", "abb_con_cada_elemento",
+	"abb_recorrer"
+};
+
+/**
+ * Generador de claves con distribución de Zipf sobre [0, n) (el de YCSB): la
+ * clave k sale con probabilidad proporcional a 1 / (k + 1)^theta.
+*/
+struct zipf {
+	double n;
+	double theta;
+	double zeta_n;
+	double eta;
+};
+
+void zipf_iniciar(struct zipf *zipf, size_t n, double theta)
+{
+	double zeta_2 = 1 + pow(0.5, theta);
+	zipf->n = (double)n;
+	zipf->theta = theta;
+	zipf->zeta_n = 0;
+	for (size_t i = 1; i <= n; i++)
+		zipf->zeta_n += pow((double)i, -theta);
+	zipf->eta = (1 - pow(2.0 / zipf->n, 1 - theta)) /
+		    (1 - zeta_2 / zipf->zeta_n);
+}
+
+size_t zipf_siguiente(struct zipf *zipf, uint64_t *estado)
+{
+	double u = (double)(aleatorio(estado) >> 11) / 9007199254740992.0;
+	double uz = u * zipf->zeta_n;
+	if (uz < 1)
+		return 0;
+	if (uz < 1 + pow(0.5, zipf->theta))
+		return 1;
+	double clave = zipf->n * pow(zipf->eta * u - zipf->eta + 1,
+				     1 / (1 - zipf->theta));
+	return clave < zipf->n ? (size_t)clave : (size_t)zipf->n - 1;
+}
+
+/**
+ * Recibe una distribución y un array de n enteros, y lo llena con las claves
+ * en el orden en que se insertan: 0..n-1, n-1..0, enteros uniformes de 31
+ * bits, o claves de Zipf sobre [0, n) (con muchas repetidas).
+*/
+void suite_generar(enum distribucion distribucion, int *claves, size_t n,
+		   uint64_t *estado)
+{
+	struct zipf zipf;
+	if (distribucion == ZIPF)
+		zipf_iniciar(&zipf, n, SUITE_ZIPF_THETA);
+	for (size_t i = 0; i < n; i++) {
+		if (distribucion == ORDENADA)
+			claves[i] = (int)i;
+		else if (distribucion == INVERSA)
+			claves[i] = (int)(n - 1 - i);
+		else if (distribucion == UNIFORME)
+			claves[i] = (int)(aleatorio(estado) >> 33);
+		else
+			claves[i] = (int)zipf_siguiente(&zipf, estado);
+	}
+}
+
+bool sumar_elemento(void *elemento, void *suma)
+{
+	*(uint64_t *)suma += (uint64_t)*(int *)elemento;
+	return true;
+}
+
+/**
+ * Recibe una función que crea arboles, las n claves y un array de n punteros,
+ * y mide cada operación de la suite: insertar las claves en orden, buscarlas
+ * en el mismo orden, recorrer el arbol con abb_con_cada_elemento y con
+ * abb_recorrer, y quitarlas en el mismo orden. Repite todo (con un arbol
+ * nuevo) hasta hacer al menos SUITE_OPERACIONES_MINIMAS de cada una, y guarda
+ * en ns los nanosegundos por operación (por elemento, en los recorridos).
+ * Devuelve false si algún resultado es incorrecto.
+*/
+bool suite_medir(abb_t *(*crear)(abb_comparador), int *claves, void **array,
+		 size_t n, double ns[SUITE_OPERACIONES])
+{
+	size_t repeticiones = (SUITE_OPERACIONES_MINIMAS + n - 1) / n;
+	double total[SUITE_OPERACIONES] = { 0 };
+	bool correcto = true;
+	for (size_t repeticion = 0; repeticion < repeticiones; repeticion++) {
+		abb_t *arbol = crear(comparador);
+		if (!arbol) {
+			fprintf(stderr, "No hay memoria.\n");
+			exit(1);
+		}
+		double inicio = ahora_ns();
+		for (size_t i = 0; i < n; i++)
+			abb_insertar(arbol, &claves[i]);
+		total[SUITE_INSERTAR] += ahora_ns() - inicio;
+
+		size_t encontrados = 0;
+		inicio = ahora_ns();
+		for (size_t i = 0; i < n; i++)
+			encontrados += abb_buscar(arbol, &claves[i]) != NULL;
+		total[SUITE_BUSCAR] += ahora_ns() - inicio;
+
+		uint64_t suma = 0;
+		inicio = ahora_ns();
+		size_t visitados = abb_con_cada_elemento(arbol, INORDEN,
+							 sumar_elemento, &suma);
+		total[SUITE_CON_CADA_ELEMENTO] += ahora_ns() - inicio;
+
+		inicio = ahora_ns();
+		size_t copiados = abb_recorrer(arbol, INORDEN, array, n);
+		total[SUITE_RECORRER] += ahora_ns() - inicio;
+
+		size_t quitados = 0;
+		inicio = ahora_ns();
+		for (size_t i = 0; i < n; i++)
+			quitados += abb_quitar(arbol, &claves[i]) != NULL;
+		total[SUITE_QUITAR] += ahora_ns() - inicio;
+
+		correcto = correcto && encontrados == n && visitados == n &&
+			   copiados == n && quitados == n &&
+			   abb_vacio(arbol);
+		abb_destruir(arbol);
+	}
+	for (int operacion = 0; operacion < SUITE_OPERACIONES; operacion++)
+		ns[operacion] = total[operacion] / (double)(n * repeticiones);
+	return correcto;
+}
+
+/**
+ * Mide las operaciones de la suite con cada distribución de claves, en un
+ * arbol común y en uno balanceado, para cada una de las cantidades, y guarda
+ * los resultados en SUITE_ARCHIVO, una medición por línea:
+ * operación, distribución, arbol, n, ns por operación y operaciones por
+ * segundo. El arbol común con claves ordenadas, inversas o de Zipf (que
+ * repiten mucho las más chicas) tarda O(n^2), así que se mide solo hasta
+ * SUITE_CUADRATICO elementos.
+*/
+void bench_suite(size_t *cantidades, size_t n_cantidades)
+{
+	const char *nombres_arbol[2] = { "abb", "avl" };
+	abb_t *(*crear[2])(abb_comparador) = { abb_crear,
+					       abb_crear_balanceado };
+	FILE *salida = fopen(SUITE_ARCHIVO, "w");
+	if (!salida) {
+		perror(SUITE_ARCHIVO);
+		exit(1);
+	}
+	fprintf(salida, "# operacion distribucion arbol n ns_por_op "
+			"ops_por_s\n");
+	printf("%-22s %-9s %-4s %9s %10s %14s\n", "operacion", "claves",
+	       "tipo", "n", "ns/op", "ops/s");
+	for (size_t c = 0; c < n_cantidades; c++) {
+		size_t n = cantidades[c];
+		int *claves = malloc(n * sizeof(int));
+		void **array = malloc(n * sizeof(void *));
+		if (n == 0 || !claves || !array) {
+			fprintf(stderr, "No hay memoria para %zu elementos.\n",
+				n);
+			exit(1);
+		}
+		for (int distribucion = 0; distribucion < DISTRIBUCIONES;
+		     distribucion++) {
+			uint64_t estado = 0x9e3779b97f4a7c15;
+			suite_generar(distribucion, claves, n, &estado);
+			for (int tipo = 0; tipo < 2; tipo++) {
+				if (tipo == 0 && distribucion != UNIFORME &&
+				    n > SUITE_CUADRATICO)
+					continue;
+				double ns[SUITE_OPERACIONES];
+				if (!suite_medir(crear[tipo], claves, array, n,
+						 ns))
+					fprintf(stderr,
+						"Resultados incorrectos.\n");
+				for (int operacion = 0;
+				     operacion < SUITE_OPERACIONES;
+				     operacion++) {
+					fprintf(salida, "%s %s %s %zu %.2f %.0f\n",
+						NOMBRES_OPERACION[operacion],
+						NOMBRES_DISTRIBUCION[distribucion],
+						nombres_arbol[tipo], n,
+						ns[operacion],
+						1e9 / ns[operacion]);
+					printf("%-22s %-9s %-4s %9zu %10.1f "
+					       "%14.0f\n",
+					       NOMBRES_OPERACION[operacion],
+					       NOMBRES_DISTRIBUCION[distribucion],
+					       nombres_arbol[tipo], n,
+					       ns[operacion],
+					       1e9 / ns[operacion]);
+				}
+				fflush(salida);
+			}
+		}
+		free(array);
+		free(claves);
+	}
+	fclose(salida);
+	printf("Resultados en %s\n", SUITE_ARCHIVO);
+}
+
+struct medicion {
+	char operacion[32];
+	char distribucion[16];
+	char arbol[8];
+	size_t n;
+	double ns;
+};
+
+/**
+ * Recibe la ruta de un archivo escrito por bench_suite y devuelve sus
+ * mediciones (guardando su cantidad en cantidad), o NULL si no se pudo leer.
+*/
+struct medicion *leer_mediciones(const char *ruta, size_t *cantidad)
+{
+	FILE *archivo = fopen(ruta, "r");
+	if (!archivo) {
+		perror(ruta);
+		return NULL;
+	}
+	struct medicion *mediciones = NULL;
+	size_t capacidad = 0;
+	char linea[256];
+	*cantidad = 0;
+	while (fgets(linea, sizeof(linea), archivo)) {
+		struct medicion medicion;
+		if (linea[0] == '#' ||
+		    sscanf(linea, "%31s %15s %7s %zu %lf", medicion.operacion,
+			   medicion.distribucion, medicion.arbol, &medicion.n,
+			   &medicion.ns) != 5)
+			continue;
+		if (*cantidad == capacidad) {
+			capacidad = capacidad ? 2 * capacidad : 64;
+			struct medicion *nuevas = realloc(
+				mediciones, capacidad * sizeof(struct medicion));
+			if (!nuevas) {
+				free(mediciones);
+				fclose(archivo);
+				return NULL;
+			}
+			mediciones = nuevas;
+		}
+		mediciones[(*cantidad)++] = medicion;
+	}
+	fclose(archivo);
+	return mediciones;
+}
+
+/**
+ * Compara las mediciones de dos archivos escritos por bench_suite, una a una
+ * (las que están en los dos), y marca como regresión las que en el nuevo
+ * tardan más de umbral por ciento que en el base.
+ * Devuelve la cantidad de regresiones, o -1 si no pudo leer los archivos.
+*/
+int bench_comparar(const char *ruta_base, const char *ruta_nueva,
+		   double umbral)
+{
+	size_t n_base, n_nuevas;
+	struct medicion *base = leer_mediciones(ruta_base, &n_base);
+	struct medicion *nuevas = leer_mediciones(ruta_nueva, &n_nuevas);
+	if (!base || !nuevas) {
+		free(base);
+		free(nuevas);
+		return -1;
+	}
+	int regresiones = 0;
+	printf("%-22s %-9s %-4s %9s %10s %10s %8s\n", "operacion", "claves",
+	       "tipo", "n", "base", "nuevo", "cambio");
+	for (size_t i = 0; i < n_nuevas; i++) {
+		struct medicion *nueva = &nuevas[i];
+		for (size_t j = 0; j < n_base; j++) {
+			struct medicion *anterior = &base[j];
+			if (anterior->n != nueva->n ||
+			    strcmp(anterior->operacion, nueva->operacion) != 0 ||
+			    strcmp(anterior->distribucion,
+				   nueva->distribucion) != 0 ||
+			    strcmp(anterior->arbol, nueva->arbol) != 0)
+				continue;
+			double cambio = (nueva->ns / anterior->ns - 1) * 100;
+			bool regresion = cambio > umbral;
+			regresiones += regresion;
+			printf("%-22s %-9s %-4s %9zu %10.1f %10.1f %+7.1f%%%s\n",
+			       nueva->operacion, nueva->distribucion,
+			       nueva->arbol, nueva->n, anterior->ns, nueva->ns,
+			       cambio, regresion ? "  REGRESION" : "");
+			break;
+		}
+	}
+	printf("%d regresiones (umbral %.1f%%)\n", regresiones, umbral);
+	free(base);
+	free(nuevas);
+	return regresiones;
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc >= 2 && strcmp(argv[1], "--suite") == 0) {
+		size_t cantidades[] = { 1000, 10000, 100000, 1000000,
+					10000000 };
+		if (argc == 2) {
+			bench_suite(cantidades,
+				    sizeof(cantidades) / sizeof(size_t));
+			return 0;
+		}
+		size_t *elegidas = malloc((size_t)(argc - 2) * sizeof(size_t));
+		if (!elegidas)
+			return 1;
+		for (int i = 2; i < argc; i++)
+			elegidas[i - 2] = strtoull(argv[i], NULL, 10);
+		bench_suite(elegidas, (size_t)(argc - 2));
+		free(elegidas);
+		return 0;
+	}
+	if (argc >= 3 && strcmp(argv[1], "--comparar") == 0) {
+		int regresiones = bench_comparar(
+			argv[2], argc > 3 ? argv[3] : SUITE_ARCHIVO,
+			argc > 4 ? strtod(argv[4], NULL) : SUITE_UMBRAL);
+		return regresiones != 0;
+	}
+	if (argc < 2) {
+		bench_busqueda(1000000);
+		bench_concurrente(1000000);
+		bench_recorrer(1000000);
+		bench_union(1000000);
+		bench_dividir(1000000);
+		bench_archivo(1000000);
+		bench_paralelo(1000000);
+		bench_persistente(1000000);
+		bench_multiconjunto(20000);
+		return 0;
+	}
+	for (int i = 1; i < argc; i++) {
+		bench_busqueda(strtoull(argv[i], NULL, 10));
+		bench_concurrente(strtoull(argv[i], NULL, 10));
+		bench_recorrer(strtoull(argv[i], NULL, 10));
+		bench_union(strtoull(argv[i], NULL, 10));
+		bench_dividir(strtoull(argv[i], NULL, 10));
+		bench_archivo(strtoull(argv[i], NULL, 10));
+		bench_paralelo(strtoull(argv[i], NULL, 10));
+		bench_persistente(strtoull(argv[i], NULL, 10));
+		bench_multiconjunto(strtoull(argv[i], NULL, 10));
+	}
+	return 0;
+}
@@ -1,7 +1,21 @@
 #include "pa2m.h"
 #include "src/abb.h"
+#include "src/abb_archivo.h"
+#include "src/abb_concurrente.h"
+#include "src/abb_congelado.h"
+#include "src/abb_estadisticas.h"
+#include "src/abb_paralelo.h"
+#include "src/abb_persistente.h"
 #include "src/abb_estructura_privada.h"
+#include "src/abb_pool.h"
+#include "src/abb_rcu.h"
+#include "src/abb_tipado.h"
+#include <pthread.h>
+#include <stdint.h>
 #include <string.h>
+#include <unistd.h>
+
+ABB_DEFINIR(abb_i64, int64_t, ABB_COMPARAR_NUMEROS)
 
 /**
  * Recibe dos void pointer, y los compara como si fueran enteros.
@@ -430,6 +444,1981 @@ void prueba_recorrer_postorden()
 	abb_destruir(abb);
 }
 
+/**
+ * Recibe un puntero a un struct nodo_abb y verifica recursivamente que el
+ * sub-árbol cumpla las condiciones de un AVL: que la altura guardada en cada
+ * nodo sea correcta y que las alturas de los hijos difieran en 1 como máximo.
+ * Devuelve la altura del sub-árbol, o -1 si no cumple las condiciones.
+*/
+int validar_avl(struct nodo_abb *nodo)
+{
+	if (!nodo)
+		return 0;
+	int altura_izquierda = validar_avl(nodo->izquierda);
+	int altura_derecha = validar_avl(nodo->derecha);
+	if (altura_izquierda < 0 || altura_derecha < 0 ||
+	    altura_izquierda - altura_derecha > 1 ||
+	    altura_derecha - altura_izquierda > 1)
+		return -1;
+	int altura = (altura_izquierda > altura_derecha ? altura_izquierda :
+							  altura_derecha) +
+		     1;
+	if ((int)nodo->altura != altura)
+		return -1;
+	return altura;
+}
+
+/**
+ * Prueba si al insertar elementos ordenados en un arbol balanceado, este se
+ * rebalancea en vez de convertirse en una lista.
+*/
+void prueba_insertar_balanceado()
+{
+	abb_t *abb = abb_crear_balanceado(comparador);
+	int numeros[7] = { 1, 2, 3, 4, 5, 6, 7 };
+	for (int i = 0; i < 7; i++)
+		abb = abb_insertar(abb, &numeros[i]);
+	pa2m_afirmar(
+		abb->tamanio == 7 && *(int *)abb->nodo_raiz->elemento == 4 &&
+			*(int *)abb->nodo_raiz->izquierda->elemento == 2 &&
+			*(int *)abb->nodo_raiz->derecha->elemento == 6 &&
+			abb->nodo_raiz->altura == 3,
+		"Insertar elementos ordenados en un abb balanceado lo rebalancea.");
+	abb_destruir(abb);
+}
+
+/**
+ * Prueba si al quitar de un arbol balanceado se sigue reemplazando con el
+ * predecesor inorden, y si el arbol se mantiene balanceado después de muchas
+ * inserciones y eliminaciones.
+*/
+void prueba_quitar_balanceado()
+{
+	abb_t *abb = abb_crear_balanceado(comparador);
+	int numeros[1000];
+	for (int i = 0; i < 1000; i++) {
+		numeros[i] = i;
+		abb = abb_insertar(abb, &numeros[i]);
+	}
+	int num_quitar = 511;
+	pa2m_afirmar(*(int *)abb_quitar(abb, &num_quitar) == 511 &&
+			     *(int *)abb->nodo_raiz->elemento == 510,
+		     "Quitar de un abb balanceado reemplaza con el predecesor.");
+	pa2m_afirmar(validar_avl(abb->nodo_raiz) == 10,
+		     "Un abb balanceado con 999 elementos tiene altura 10.");
+	bool quitados_ok = true;
+	for (int i = 0; i < 1000; i += 2) {
+		if (abb_quitar(abb, &numeros[i]) != &numeros[i])
+			quitados_ok = false;
+	}
+	int num_buscar = 3, num_quitado = 4;
+	pa2m_afirmar(quitados_ok && abb->tamanio == 499 &&
+			     validar_avl(abb->nodo_raiz) > 0 &&
+			     abb_buscar(abb, &num_buscar) == &numeros[3] &&
+			     !abb_buscar(abb, &num_quitado),
+		     "Un abb balanceado sigue balanceado después de quitar.");
+	abb_destruir(abb);
+}
+
+/**
+ * Recibe un void pointer que es tratado como un int pointer, y le suma 1.
+*/
+void sumar_uno(void *contador)
+{
+	(*(int *)contador)++;
+}
+
+/**
+ * Enteros que se espera recibir en un recorrido: el siguiente, cuánto cambia
+ * de uno al otro, y si hasta ahora llegaron los esperados.
+*/
+struct secuencia {
+	int siguiente;
+	int paso;
+	bool ok;
+};
+
+/**
+ * Recibe un void pointer a un int y otro a un struct secuencia, y verifica
+ * que el int sea el siguiente de la secuencia. Devuelve siempre true.
+*/
+bool verificar_secuencia(void *elemento, void *secuencia)
+{
+	struct secuencia *esperada = secuencia;
+	if (*(int *)elemento != esperada->siguiente)
+		esperada->ok = false;
+	esperada->siguiente += esperada->paso;
+	return true;
+}
+
+/**
+ * Prueba que insertar, buscar, recorrer, quitar y destruir funcionen sin
+ * desbordar el stack en un arbol degenerado de 10 millones de claves
+ * ordenadas.
+ *
+ * Insertar las claves una por una con abb_insertar tardaría O(n²), así que
+ * se arma a mano la misma lista que dejarían las inserciones ordenadas, y se
+ * inserta con abb_insertar solamente la última clave.
+*/
+void prueba_estres_arbol_degenerado()
+{
+	size_t cantidad = 10000000;
+	int *claves = malloc(cantidad * sizeof(int));
+	abb_t *abb = abb_crear(comparador);
+	struct nodo_abb **siguiente = &abb->nodo_raiz;
+	for (size_t i = 0; i < cantidad - 1; i++) {
+		claves[i] = (int)i;
+		*siguiente = abb_pool_obtener(abb->pool);
+		(*siguiente)->elemento = &claves[i];
+		(*siguiente)->altura = 1;
+		(*siguiente)->cantidad = cantidad - 1 - i;
+		siguiente = &(*siguiente)->derecha;
+	}
+	abb->tamanio = cantidad - 1;
+	claves[cantidad - 1] = (int)cantidad - 1;
+	abb = abb_insertar(abb, &claves[cantidad - 1]);
+	int ultima = (int)cantidad - 1, anteultima = (int)cantidad - 2;
+	pa2m_afirmar(abb_tamanio(abb) == cantidad &&
+			     abb_buscar(abb, &ultima) == &claves[cantidad - 1],
+		     "Se pueden insertar y buscar 10M claves ordenadas.");
+	struct secuencia inorden = { .siguiente = 0, .paso = 1, .ok = true };
+	struct secuencia preorden = inorden;
+	struct secuencia postorden = { .siguiente = ultima,
+				       .paso = -1,
+				       .ok = true };
+	pa2m_afirmar(abb_con_cada_elemento(abb, INORDEN, verificar_secuencia,
+					   &inorden) == cantidad &&
+			     abb_con_cada_elemento(abb, PREORDEN,
+						   verificar_secuencia,
+						   &preorden) == cantidad &&
+			     abb_con_cada_elemento(abb, POSTORDEN,
+						   verificar_secuencia,
+						   &postorden) == cantidad &&
+			     inorden.ok && preorden.ok && postorden.ok,
+		     "Se puede recorrer con una función un abb de 10M claves "
+		     "ordenadas.");
+	pa2m_afirmar(abb_quitar(abb, &anteultima) == &claves[cantidad - 2] &&
+			     !abb_buscar(abb, &anteultima) &&
+			     abb_tamanio(abb) == cantidad - 1,
+		     "Se puede quitar en un abb de 10M claves ordenadas.");
+	abb_destruir_todo(abb, sumar_uno);
+	bool destruidos = true;
+	for (size_t i = 0; i < cantidad && destruidos; i++)
+		destruidos = claves[i] == (int)i + (i != cantidad - 2);
+	pa2m_afirmar(destruidos,
+		     "abb_destruir_todo invoca el destructor una vez con cada "
+		     "una de las 10M claves.");
+	free(claves);
+}
+
+/**
+ * Prueba si los nodos que se quitan del arbol vuelven al pool y se reutilizan
+ * en las siguientes inserciones.
+*/
+void prueba_pool_reutiliza_nodos()
+{
+	abb_t *abb = abb_crear(comparador);
+	int raiz = 4, num1 = 2, num2 = 6, num_quitar = 2;
+	abb = abb_insertar(abb, &raiz);
+	abb = abb_insertar(abb, &num1);
+	struct nodo_abb *nodo_quitado = abb->nodo_raiz->izquierda;
+	abb_quitar(abb, &num_quitar);
+	abb = abb_insertar(abb, &num2);
+	pa2m_afirmar(abb->nodo_raiz->derecha == nodo_quitado &&
+			     !nodo_quitado->izquierda &&
+			     !nodo_quitado->derecha,
+		     "Los nodos quitados se reutilizan al insertar.");
+	abb_destruir(abb);
+}
+
+/**
+ * Prueba si abb_destruir_todo invoca el destructor con cada elemento.
+*/
+void prueba_destruir_todo_invoca_destructor()
+{
+	abb_t *abb = abb_crear(comparador);
+	int contador = 0;
+	for (int i = 0; i < 100; i++)
+		abb = abb_insertar(abb, &contador);
+	abb_destruir_todo(abb, sumar_uno);
+	pa2m_afirmar(contador == 100,
+		     "abb_destruir_todo invoca el destructor con cada elemento.");
+}
+
+/**
+ * Prueba si se puede crear un arbol de altura mínima a partir de un array
+ * ordenado, y si el arbol creado se mantiene balanceado al insertar.
+*/
+void prueba_crear_desde_ordenado()
+{
+	int numeros[8] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+	void *elementos[7];
+	for (int i = 0; i < 7; i++)
+		elementos[i] = &numeros[i];
+	abb_t *abb = abb_crear_desde_ordenado(comparador, elementos, 7);
+	pa2m_afirmar(
+		abb->tamanio == 7 && *(int *)abb->nodo_raiz->elemento == 4 &&
+			*(int *)abb->nodo_raiz->izquierda->elemento == 2 &&
+			*(int *)abb->nodo_raiz->derecha->elemento == 6 &&
+			validar_avl(abb->nodo_raiz) == 3,
+		"Se puede crear un abb de altura mínima desde un array ordenado.");
+	abb = abb_insertar(abb, &numeros[7]);
+	int num_buscar = 8, num_quitar = 4;
+	pa2m_afirmar(abb_buscar(abb, &num_buscar) == &numeros[7] &&
+			     abb_quitar(abb, &num_quitar) == &numeros[3] &&
+			     validar_avl(abb->nodo_raiz) > 0,
+		     "Se puede insertar y quitar en un abb creado desde un array.");
+	abb_destruir(abb);
+	abb = abb_crear_desde_ordenado(comparador, NULL, 0);
+	pa2m_afirmar(abb_vacio(abb) &&
+			     !abb_crear_desde_ordenado(comparador, NULL, 3),
+		     "Se puede crear un abb vacío desde un array vacío.");
+	abb_destruir(abb);
+}
+
+/**
+ * Prueba si se puede crear un arbol a partir de un array desordenado, sin
+ * modificar el array recibido.
+*/
+void prueba_crear_desde_desordenado()
+{
+	int numeros[7] = { 5, 1, 7, 3, 6, 2, 4 };
+	int lista_esperada[7] = { 1, 2, 3, 4, 5, 6, 7 };
+	void *elementos[7];
+	for (int i = 0; i < 7; i++)
+		elementos[i] = &numeros[i];
+	abb_t *abb = abb_crear_desde_desordenado(comparador, elementos, 7);
+	void *lista_inorden[7];
+	abb_recorrer(abb, INORDEN, lista_inorden, 7);
+	pa2m_afirmar(validar_lista(lista_inorden, 7, lista_esperada) &&
+			     elementos[0] == &numeros[0] &&
+			     validar_avl(abb->nodo_raiz) == 3,
+		     "Se puede crear un abb desde un array desordenado.");
+	abb_destruir(abb);
+}
+
+/**
+ * Recibe un iterador, y una lista de enteros con su tamaño. Avanza el
+ * iterador y valida que devuelva los elementos de la lista en orden, y que
+ * después no le queden elementos.
+*/
+bool validar_iterador(abb_iterador_t *iterador, int *lista_esperada,
+		      size_t tamanio_lista)
+{
+	for (size_t i = 0; i < tamanio_lista; i++) {
+		if (!abb_iterador_tiene_siguiente(iterador) ||
+		    *(int *)abb_iterador_siguiente(iterador) != lista_esperada[i])
+			return false;
+	}
+	return !abb_iterador_tiene_siguiente(iterador) &&
+	       !abb_iterador_siguiente(iterador);
+}
+
+/**
+ * Prueba los iteradores externos con los tres recorridos.
+*/
+void prueba_iterador_recorridos()
+{
+	abb_t *abb = abb_crear(comparador);
+	int numeros[7] = { 4, 6, 7, 5, 2, 3, 1 };
+	for (int i = 0; i < 7; i++)
+		abb = abb_insertar(abb, &numeros[i]);
+	int lista_inorden[7] = { 1, 2, 3, 4, 5, 6, 7 };
+	int lista_preorden[7] = { 4, 2, 1, 3, 6, 5, 7 };
+	int lista_postorden[7] = { 1, 3, 2, 5, 7, 6, 4 };
+	abb_iterador_t *iterador = abb_iterador_crear(abb, INORDEN);
+	pa2m_afirmar(validar_iterador(iterador, lista_inorden, 7),
+		     "Se puede iterar un arbol inorden.");
+	abb_iterador_destruir(iterador);
+	iterador = abb_iterador_crear(abb, PREORDEN);
+	pa2m_afirmar(validar_iterador(iterador, lista_preorden, 7),
+		     "Se puede iterar un arbol preorden.");
+	abb_iterador_destruir(iterador);
+	iterador = abb_iterador_crear(abb, POSTORDEN);
+	pa2m_afirmar(validar_iterador(iterador, lista_postorden, 7),
+		     "Se puede iterar un arbol postorden.");
+	abb_iterador_destruir(iterador);
+	abb_destruir(abb);
+}
+
+/**
+ * Prueba si se pueden recorrer dos arboles a la vez con iteradores,
+ * intercalando sus elementos, y si iterar un arbol vacío no devuelve nada.
+*/
+void prueba_iterador_intercalado()
+{
+	abb_t *pares = abb_crear_balanceado(comparador);
+	abb_t *impares = abb_crear(comparador);
+	int numeros[8] = { 0, 1, 2, 3, 4, 5, 6, 7 };
+	for (int i = 0; i < 8; i++)
+		abb_insertar(i % 2 == 0 ? pares : impares, &numeros[i]);
+	abb_iterador_t *iterador_pares = abb_iterador_crear(pares, INORDEN);
+	abb_iterador_t *iterador_impares = abb_iterador_crear(impares, INORDEN);
+	bool intercalado_ok = true;
+	for (int i = 0; i < 8; i++) {
+		abb_iterador_t *iterador = i % 2 == 0 ? iterador_pares :
+							iterador_impares;
+		if (*(int *)abb_iterador_siguiente(iterador) != i)
+			intercalado_ok = false;
+	}
+	pa2m_afirmar(intercalado_ok &&
+			     !abb_iterador_tiene_siguiente(iterador_pares) &&
+			     !abb_iterador_tiene_siguiente(iterador_impares),
+		     "Se pueden intercalar los iteradores de dos arboles.");
+	abb_iterador_destruir(iterador_pares);
+	abb_iterador_destruir(iterador_impares);
+	abb_destruir(pares);
+	abb_destruir(impares);
+
+	abb_t *vacio = abb_crear(comparador);
+	abb_iterador_t *iterador = abb_iterador_crear(vacio, POSTORDEN);
+	pa2m_afirmar(iterador && !abb_iterador_tiene_siguiente(iterador) &&
+			     !abb_iterador_crear(NULL, INORDEN),
+		     "Iterar un arbol vacío no devuelve elementos.");
+	abb_iterador_destruir(iterador);
+	abb_destruir(vacio);
+}
+
+/**
+ * Prueba las consultas por rango: con función, contando y llenando un array.
+*/
+void prueba_rango()
+{
+	int numeros[10];
+	void *elementos[10];
+	for (int i = 0; i < 10; i++) {
+		numeros[i] = i + 1;
+		elementos[i] = &numeros[i];
+	}
+	abb_t *abb = abb_crear_desde_ordenado(comparador, elementos, 10);
+	int minimo = 3, maximo = 7, fuera_minimo = 20, fuera_maximo = 30;
+	void *lista_rango[5];
+	int lista_esperada[5] = { 3, 4, 5, 6, 7 };
+	pa2m_afirmar(abb_rango_recorrer(abb, &minimo, &maximo, lista_rango,
+					5) == 5 &&
+			     validar_lista(lista_rango, 5, lista_esperada),
+		     "Se pueden recorrer los elementos de un rango en orden.");
+	pa2m_afirmar(abb_rango_recorrer(abb, &minimo, &maximo, lista_rango,
+					2) == 2 &&
+			     validar_lista(lista_rango, 2, lista_esperada),
+		     "Recorrer un rango corta si se llena el array.");
+	pa2m_afirmar(abb_rango_contar(abb, &minimo, &maximo) == 5 &&
+			     abb_rango_contar(abb, &maximo, &minimo) == 0 &&
+			     abb_rango_contar(abb, &fuera_minimo,
+					      &fuera_maximo) == 0,
+		     "Se pueden contar los elementos de un rango.");
+	int contexto = 5;
+	pa2m_afirmar(abb_rango(abb, &minimo, &maximo, convertir_numero_en_otro,
+			       &contexto) == 3 &&
+			     numeros[2] == 5 && numeros[3] == 5 &&
+			     numeros[5] == 6,
+		     "abb_rango corta si la función devuelve false.");
+	abb_destruir(abb);
+}
+
+/**
+ * Recibe un arbol y uno de sus nodos, y verifica recursivamente que la
+ * cantidad guardada en cada nodo sea la cantidad de elementos de su
+ * sub-árbol (contando las copias repetidas de los multiconjuntos). Devuelve
+ * esa cantidad, o -1 si alguna es incorrecta.
+*/
+long validar_cantidades(abb_t *abb, struct nodo_abb *nodo)
+{
+	if (!nodo)
+		return 0;
+	long cantidad_izquierda = validar_cantidades(abb, nodo->izquierda);
+	long cantidad_derecha = validar_cantidades(abb, nodo->derecha);
+	struct repetidos *repetidos =
+		abb->multiconjunto ? *nodo_repetidos(nodo) : NULL;
+	if (cantidad_izquierda < 0 || cantidad_derecha < 0 ||
+	    (long)nodo->cantidad !=
+		    cantidad_izquierda + cantidad_derecha + 1 +
+			    (long)(repetidos ? repetidos->cantidad : 0))
+		return -1;
+	return (long)nodo->cantidad;
+}
+
+/**
+ * Recibe un arbol y lo llena con 200 números entre 0 y 49 (con repetidos), y
+ * luego quita algunos de ellos, incluida la raíz.
+*/
+void llenar_arbol_con_repetidos(abb_t *abb, int *numeros)
+{
+	for (int i = 0; i < 200; i++) {
+		numeros[i] = (i * 37) % 50;
+		abb_insertar(abb, &numeros[i]);
+	}
+	for (int i = 0; i < 200; i += 3)
+		abb_quitar(abb, &numeros[i]);
+	abb_quitar(abb, abb->nodo_raiz->elemento);
+}
+
+/**
+ * Prueba si las cantidades de los sub-árboles se mantienen al insertar y
+ * quitar, y las consultas por posición en un arbol con y sin balancear.
+*/
+void prueba_estadisticos_de_orden()
+{
+	for (int balanceado = 0; balanceado < 2; balanceado++) {
+		abb_t *abb = balanceado ? abb_crear_balanceado(comparador) :
+					  abb_crear(comparador);
+		int numeros[200];
+		llenar_arbol_con_repetidos(abb, numeros);
+		void *lista_inorden[200];
+		size_t tamanio = abb_recorrer(abb, INORDEN, lista_inorden, 200);
+		int faltantes[] = { -1, 50, 1000 };
+		for (int i = 0; i < 3; i++)
+			abb_quitar(abb, &faltantes[i]);
+		bool seleccion_ok =
+			abb_tamanio(abb) == tamanio &&
+			validar_cantidades(abb, abb->nodo_raiz) == (long)tamanio &&
+			!abb_seleccionar(abb, tamanio);
+		for (size_t k = 0; k < tamanio; k++) {
+			if (*(int *)abb_seleccionar(abb, k) !=
+			    *(int *)lista_inorden[k])
+				seleccion_ok = false;
+		}
+		pa2m_afirmar(seleccion_ok,
+			     balanceado ?
+				     "Se puede seleccionar por posición (balanceado)." :
+				     "Se puede seleccionar por posición.");
+		size_t menores_a_10 = 0, entre_10_y_20 = 0;
+		for (size_t k = 0; k < tamanio; k++) {
+			int numero = *(int *)lista_inorden[k];
+			if (numero < 10)
+				menores_a_10++;
+			else if (numero <= 20)
+				entre_10_y_20++;
+		}
+		int diez = 10, veinte = 20;
+		pa2m_afirmar(abb_rango_de(abb, &diez) == menores_a_10 &&
+				     abb_contar_entre(abb, &diez, &veinte) ==
+					     entre_10_y_20 &&
+				     abb_contar_entre(abb, &veinte, &diez) == 0,
+			     balanceado ?
+				     "Se puede contar por posición y rango (balanceado)." :
+				     "Se puede contar por posición y rango.");
+		abb_destruir(abb);
+	}
+}
+
+/**
+ * Prueba las búsquedas de piso, techo, predecesor y sucesor.
+*/
+void prueba_piso_techo_predecesor_sucesor()
+{
+	abb_t *abb = abb_crear(comparador);
+	int numeros[5] = { 30, 10, 50, 20, 40 };
+	for (int i = 0; i < 5; i++)
+		abb = abb_insertar(abb, &numeros[i]);
+	int veinte = 20, veinticinco = 25, cinco = 5, sesenta = 60;
+	pa2m_afirmar(*(int *)abb_piso(abb, &veinticinco) == 20 &&
+			     *(int *)abb_piso(abb, &veinte) == 20 &&
+			     !abb_piso(abb, &cinco),
+		     "Se puede buscar el piso de un elemento.");
+	pa2m_afirmar(*(int *)abb_techo(abb, &veinticinco) == 30 &&
+			     *(int *)abb_techo(abb, &veinte) == 20 &&
+			     !abb_techo(abb, &sesenta),
+		     "Se puede buscar el techo de un elemento.");
+	pa2m_afirmar(*(int *)abb_predecesor(abb, &veinte) == 10 &&
+			     *(int *)abb_predecesor(abb, &sesenta) == 50 &&
+			     !abb_predecesor(abb, &numeros[1]),
+		     "Se puede buscar el predecesor de un elemento.");
+	pa2m_afirmar(*(int *)abb_sucesor(abb, &veinte) == 30 &&
+			     *(int *)abb_sucesor(abb, &cinco) == 10 &&
+			     !abb_sucesor(abb, &numeros[2]) &&
+			     !abb_sucesor(NULL, &cinco),
+		     "Se puede buscar el sucesor de un elemento.");
+	abb_destruir(abb);
+}
+
+/**
+ * Prueba si se puede congelar un arbol y buscar en la foto todos sus
+ * elementos, y que no se encuentren los que no están.
+*/
+void prueba_congelar()
+{
+	abb_t *abb = abb_crear(comparador);
+	int numeros[100];
+	for (int i = 0; i < 100; i++) {
+		numeros[i] = ((i * 37) % 100) * 2;
+		abb = abb_insertar(abb, &numeros[i]);
+	}
+	abb_congelado_t *eytzinger = abb_congelar(abb);
+	abb_congelado_t *veb = abb_congelar_veb(abb);
+	bool encontrados_ok = abb_congelado_tamanio(eytzinger) == 100 &&
+			      abb_congelado_tamanio(veb) == 100;
+	for (int i = 0; i < 100; i++) {
+		int par = 2 * i, impar = 2 * i + 1;
+		if (*(int *)abb_congelado_buscar(eytzinger, &par) != par ||
+		    *(int *)abb_congelado_buscar(veb, &par) != par ||
+		    abb_congelado_buscar(eytzinger, &impar) ||
+		    abb_congelado_buscar(veb, &impar))
+			encontrados_ok = false;
+	}
+	pa2m_afirmar(encontrados_ok,
+		     "Se pueden buscar los elementos de un arbol congelado.");
+	abb_congelado_destruir(eytzinger);
+	abb_congelado_destruir(veb);
+	abb_destruir(abb);
+
+	abb = abb_crear(comparador);
+	eytzinger = abb_congelar(abb);
+	veb = abb_congelar_veb(abb);
+	int num_buscar = 1;
+	pa2m_afirmar(abb_congelado_tamanio(eytzinger) == 0 &&
+			     !abb_congelado_buscar(eytzinger, &num_buscar) &&
+			     abb_congelado_tamanio(veb) == 0 &&
+			     !abb_congelado_buscar(veb, &num_buscar) &&
+			     !abb_congelar(NULL) && !abb_congelar_veb(NULL),
+		     "Se puede congelar un arbol vacío.");
+	abb_congelado_destruir(eytzinger);
+	abb_congelado_destruir(veb);
+	abb_destruir(abb);
+
+	abb = abb_crear_multiclave(comparador);
+	for (int i = 0; i < 100; i++)
+		abb_insertar(abb, &numeros[i]);
+	eytzinger = abb_congelar(abb);
+	veb = abb_congelar_veb(abb);
+	encontrados_ok = eytzinger && veb;
+	for (int i = 0; i < 100 && encontrados_ok; i++) {
+		int par = 2 * i, impar = 2 * i + 1;
+		encontrados_ok = abb_congelado_buscar(eytzinger, &par) &&
+				 *(int *)abb_congelado_buscar(eytzinger,
+							      &par) == par &&
+				 abb_congelado_buscar(veb, &par) &&
+				 !abb_congelado_buscar(eytzinger, &impar) &&
+				 !abb_congelado_buscar(veb, &impar);
+	}
+	pa2m_afirmar(encontrados_ok,
+		     "Se puede congelar un arbol multiclave.");
+	abb_congelado_destruir(eytzinger);
+	abb_congelado_destruir(veb);
+	abb_destruir(abb);
+}
+
+/**
+ * Recibe un nodo de un arbol multiclave, las cotas que deben respetar sus
+ * elementos (NULL si no hay cota) y si es la raíz. Verifica que cada nodo
+ * tenga entre el mínimo y el máximo de claves, que estén ordenadas y dentro
+ * de las cotas, y que todas las hojas estén a la misma profundidad.
+ * Devuelve la altura del nodo, o -1 si no se cumple alguna condición.
+*/
+int validar_multiclave(struct nodo_multiclave *nodo, void *minimo,
+		       void *maximo, bool es_raiz)
+{
+	bool es_hoja = nodo->es_hoja;
+	void **claves = es_hoja ? ((struct hoja_multiclave *)nodo)->elementos :
+				  ((struct interno_multiclave *)nodo)->claves;
+	size_t maximo_claves = es_hoja ? MULTICLAVE_CLAVES_HOJA :
+					 MULTICLAVE_CLAVES_INTERNO;
+	if (nodo->cantidad > maximo_claves ||
+	    nodo->cantidad < (es_raiz ? 1 : maximo_claves / 2))
+		return -1;
+	for (size_t i = 0; i < nodo->cantidad; i++) {
+		if ((minimo && comparador(claves[i], minimo) < 0) ||
+		    (maximo && comparador(claves[i], maximo) > 0) ||
+		    (i > 0 && comparador(claves[i - 1], claves[i]) > 0))
+			return -1;
+	}
+	if (es_hoja)
+		return 1;
+	struct interno_multiclave *interno = (struct interno_multiclave *)nodo;
+	int altura = -1;
+	for (size_t i = 0; i <= nodo->cantidad; i++) {
+		int altura_hijo = validar_multiclave(
+			interno->hijos[i], i > 0 ? claves[i - 1] : minimo,
+			i < nodo->cantidad ? claves[i] : maximo, false);
+		if (altura_hijo < 0 || (altura >= 0 && altura_hijo != altura))
+			return -1;
+		altura = altura_hijo;
+	}
+	return altura + 1;
+}
+
+/**
+ * Prueba si un arbol multiclave inserta, busca, recorre y quita elementos
+ * igual que un abb, manteniendo los nodos llenos a la mitad o más.
+*/
+void prueba_multiclave()
+{
+	abb_t *abb = abb_crear_multiclave(comparador);
+	int numeros[10000], repetidos[3] = { 42, 42, 42 };
+	for (int i = 0; i < 10000; i++) {
+		numeros[i] = (i * 7919) % 10000;
+		abb = abb_insertar(abb, &numeros[i]);
+	}
+	for (int i = 0; i < 3; i++)
+		abb = abb_insertar(abb, &repetidos[i]);
+	bool encontrados_ok = abb_tamanio(abb) == 10003;
+	for (int i = 0; i < 10000; i++) {
+		if (*(int *)abb_buscar(abb, &i) != i)
+			encontrados_ok = false;
+	}
+	int num_buscar = 10000;
+	pa2m_afirmar(encontrados_ok && !abb_buscar(abb, &num_buscar) &&
+			     validar_multiclave(abb->raiz_multiclave, NULL,
+						NULL, true) ==
+				     (int)abb->altura_maxima,
+		     "Se pueden buscar los elementos de un arbol multiclave.");
+
+	void *elementos[10003];
+	bool ordenados_ok = abb_recorrer(abb, INORDEN, elementos, 10003) ==
+			    10003;
+	for (int i = 1; i < 10003; i++) {
+		if (comparador(elementos[i - 1], elementos[i]) > 0)
+			ordenados_ok = false;
+	}
+	int minimo = 100, maximo = 199;
+	pa2m_afirmar(ordenados_ok &&
+			     abb_rango_contar(abb, &minimo, &maximo) == 100 &&
+			     abb_rango_recorrer(abb, &minimo, &maximo,
+						elementos, 10003) == 100 &&
+			     *(int *)elementos[99] == 199,
+		     "Un arbol multiclave se recorre en orden por sus hojas.");
+
+	bool quitados_ok = true;
+	for (int i = 0; i < 10000; i++) {
+		if (numeros[i] % 2 == 0 &&
+		    abb_quitar(abb, &numeros[i]) != &numeros[i])
+			quitados_ok = false;
+	}
+	int impar = 41, par = 40;
+	pa2m_afirmar(quitados_ok && abb_tamanio(abb) == 5003 &&
+			     *(int *)abb_buscar(abb, &impar) == 41 &&
+			     !abb_buscar(abb, &par) &&
+			     abb_rango_contar(abb, &minimo, &maximo) == 50 &&
+			     validar_multiclave(abb->raiz_multiclave, NULL,
+						NULL, true) > 0,
+		     "Quitar de un arbol multiclave mantiene sus invariantes.");
+
+	for (int i = 0; i < 10000; i++) {
+		if (numeros[i] % 2 == 1 &&
+		    abb_quitar(abb, &numeros[i]) != &numeros[i])
+			quitados_ok = false;
+	}
+	int cuarenta_y_dos = 42;
+	for (int i = 0; i < 3; i++) {
+		if (*(int *)abb_quitar(abb, &cuarenta_y_dos) != 42)
+			quitados_ok = false;
+	}
+	pa2m_afirmar(quitados_ok && abb_vacio(abb) && !abb->raiz_multiclave &&
+			     !abb_quitar(abb, &cuarenta_y_dos),
+		     "Se pueden quitar todos los elementos de un arbol "
+		     "multiclave.");
+	abb_destruir(abb);
+}
+
+/**
+ * Prueba si buscar de a lotes encuentra lo mismo que abb_buscar, en un arbol
+ * balanceado, en uno sin balancear y en uno multiclave.
+*/
+void prueba_buscar_lote()
+{
+	abb_t *arboles[3] = { abb_crear_balanceado(comparador),
+			      abb_crear(comparador),
+			      abb_crear_multiclave(comparador) };
+	int numeros[500], consultas[1000];
+	void *claves[1000], *resultados[1000];
+	for (int i = 0; i < 500; i++)
+		numeros[i] = ((i * 211) % 500) * 2;
+	for (int i = 0; i < 1000; i++) {
+		consultas[i] = (i * 389) % 1000;
+		claves[i] = &consultas[i];
+	}
+	bool lote_ok = true;
+	for (int j = 0; j < 3; j++) {
+		for (int i = 0; i < 500; i++)
+			abb_insertar(arboles[j], &numeros[i]);
+		if (abb_buscar_lote(arboles[j], claves, 1000, resultados) !=
+		    500)
+			lote_ok = false;
+		for (int i = 0; i < 1000; i++) {
+			if (resultados[i] != abb_buscar(arboles[j], claves[i]))
+				lote_ok = false;
+		}
+	}
+	pa2m_afirmar(lote_ok,
+		     "Buscar de a lotes encuentra lo mismo que abb_buscar.");
+	for (int j = 0; j < 3; j++)
+		abb_destruir(arboles[j]);
+
+	abb_t *abb = abb_crear(comparador);
+	resultados[0] = &consultas[0];
+	pa2m_afirmar(abb_buscar_lote(abb, claves, 1, resultados) == 0 &&
+			     !resultados[0] &&
+			     !abb_buscar_lote(NULL, claves, 1, resultados),
+		     "Buscar de a lotes en un arbol vacío no encuentra nada.");
+	abb_destruir(abb);
+}
+
+/**
+ * Recibe un puntero a un int64_t y un puntero a otro, y verifica que el
+ * primero no sea menor que el anterior recibido. Guarda el actual en aux.
+*/
+bool verificar_orden_i64(int64_t *clave, void *anterior)
+{
+	if (*clave < *(int64_t *)anterior)
+		return false;
+	*(int64_t *)anterior = *clave;
+	return true;
+}
+
+/**
+ * Prueba si un arbol definido con ABB_DEFINIR inserta, busca, recorre y quita
+ * claves guardadas en el nodo, incluidas las que no entran en un int.
+*/
+void prueba_abb_tipado()
+{
+	abb_i64_t *abb = abb_i64_crear();
+	bool insertados_ok = true;
+	for (int64_t i = 0; i < 1000; i++) {
+		if (!abb_i64_insertar(abb, ((i * 577) % 1000) << 40))
+			insertados_ok = false;
+	}
+	int64_t anterior = INT64_MIN;
+	pa2m_afirmar(insertados_ok && abb_i64_tamanio(abb) == 1000 &&
+			     abb->raiz->altura <= 11 &&
+			     abb_i64_con_cada_elemento(abb, verificar_orden_i64,
+						       &anterior) == 1000,
+		     "Se pueden insertar claves en un arbol tipado.");
+	int64_t grande = INT64_C(999) << 40;
+	pa2m_afirmar(abb_i64_buscar(abb, grande) &&
+			     *abb_i64_buscar(abb, grande) == grande &&
+			     !abb_i64_buscar(abb, grande + 1) &&
+			     !abb_i64_buscar(abb, -grande),
+		     "Se pueden buscar claves en un arbol tipado.");
+	bool quitados_ok = true;
+	for (int64_t i = 0; i < 1000; i += 2) {
+		if (!abb_i64_quitar(abb, i << 40))
+			quitados_ok = false;
+	}
+	pa2m_afirmar(quitados_ok && abb_i64_tamanio(abb) == 500 &&
+			     !abb_i64_quitar(abb, 0) &&
+			     abb_i64_buscar(abb, INT64_C(1) << 40),
+		     "Se pueden quitar claves de un arbol tipado.");
+	abb_i64_destruir(abb);
+}
+
+/**
+ * Recibe un void pointer a un string y devuelve sus primeros 8 bytes como un
+ * entero big-endian (completando con ceros), que respeta el orden de strcmp.
+*/
+uint64_t prefijo_string(void *elemento)
+{
+	const unsigned char *string = elemento;
+	uint64_t prefijo = 0;
+	size_t i = 0;
+	for (; i < 8 && string[i]; i++)
+		prefijo = (prefijo << 8) | string[i];
+	return i == 0 ? 0 : prefijo << (8 * (8 - i));
+}
+
+int comparador_strings(void *elemento1, void *elemento2)
+{
+	return strcmp(elemento1, elemento2);
+}
+
+/**
+ * Prueba si un arbol con extractor de claves inserta, busca y quita
+ * elementos, también cuando varios comparten la clave y decide el comparador.
+*/
+void prueba_crear_con_clave()
+{
+	abb_t *abb = abb_crear_con_clave(comparador_strings, prefijo_string);
+	char *palabras[] = { "prefijo_comun_b", "arbol", "prefijo_comun_a",
+			     "a", "prefijo", "zeta", "prefijo_comun_c", "" };
+	for (int i = 0; i < 8; i++)
+		abb = abb_insertar(abb, palabras[i]);
+	bool encontrados_ok = abb_tamanio(abb) == 8 &&
+			      validar_avl(abb->nodo_raiz) > 0;
+	for (int i = 0; i < 8; i++) {
+		char copia[32];
+		strcpy(copia, palabras[i]);
+		if (abb_buscar(abb, copia) != palabras[i])
+			encontrados_ok = false;
+	}
+	void *ordenados[8];
+	abb_recorrer(abb, INORDEN, ordenados, 8);
+	pa2m_afirmar(encontrados_ok && !abb_buscar(abb, "prefijo_comun_d") &&
+			     !abb_buscar(abb, "b") && ordenados[0] == palabras[7] &&
+			     ordenados[4] == palabras[2] &&
+			     ordenados[7] == palabras[5],
+		     "Se pueden buscar elementos en un arbol con claves.");
+	pa2m_afirmar(abb_quitar(abb, "prefijo_comun_b") == palabras[0] &&
+			     abb_quitar(abb, "arbol") == palabras[1] &&
+			     !abb_quitar(abb, "prefijo_comun_b") &&
+			     abb_buscar(abb, "prefijo_comun_c") == palabras[6] &&
+			     abb_buscar(abb, "prefijo_comun_a") == palabras[2] &&
+			     validar_avl(abb->nodo_raiz) > 0 &&
+			     !abb_crear_con_clave(comparador_strings, NULL),
+		     "Se pueden quitar elementos de un arbol con claves.");
+
+	abb_t *vacio = abb_crear_con_clave(comparador_strings, prefijo_string);
+	abb_t *copia = abb_union(abb, vacio);
+	abb_t *sin_clave = abb_crear(comparador_strings);
+	bool copia_ok = copia && copia->extractor && abb_tamanio(copia) == 6 &&
+			validar_avl(copia->nodo_raiz) > 0;
+	for (int i = 2; copia_ok && i < 8; i++)
+		copia_ok = abb_buscar(copia, palabras[i]) == palabras[i];
+	pa2m_afirmar(copia_ok && !abb_buscar(copia, "prefijo_comun_b") &&
+			     sin_clave->pool->tamanio_objeto <
+				     abb->pool->tamanio_objeto &&
+			     abb->pool->tamanio_objeto >=
+				     sizeof(struct nodo_con_clave),
+		     "Solo los arboles con claves reservan nodos con lugar para "
+		     "la clave, también los que arma abb_union.");
+	abb_destruir(sin_clave);
+	abb_destruir(copia);
+	abb_destruir(vacio);
+	abb_destruir(abb);
+}
+
+struct prueba_concurrente {
+	abb_concurrente_t *concurrente;
+	int *fijos;
+	int *variables;
+	bool ok;
+};
+
+/**
+ * Lector de prueba_concurrente: busca muchas veces los elementos fijos, que
+ * nunca se quitan, y anota si alguno no aparece.
+*/
+void *leer_concurrente(void *prueba)
+{
+	struct prueba_concurrente *datos = prueba;
+	for (int vuelta = 0; vuelta < 200; vuelta++) {
+		for (int i = 0; i < 100; i++) {
+			if (abb_concurrente_buscar(datos->concurrente,
+						   &datos->fijos[i]) !=
+			    &datos->fijos[i])
+				datos->ok = false;
+		}
+	}
+	return NULL;
+}
+
+/**
+ * Escritor de prueba_concurrente: inserta y quita los elementos variables.
+*/
+void *escribir_concurrente(void *prueba)
+{
+	struct prueba_concurrente *datos = prueba;
+	for (int vuelta = 0; vuelta < 20; vuelta++) {
+		for (int i = 0; i < 100; i++)
+			abb_concurrente_insertar(datos->concurrente,
+						 &datos->variables[i]);
+		for (int i = 0; i < 100; i++) {
+			if (abb_concurrente_quitar(datos->concurrente,
+						   &datos->variables[i]) !=
+			    &datos->variables[i])
+				datos->ok = false;
+		}
+	}
+	return NULL;
+}
+
+/**
+ * Prueba si varios hilos pueden buscar en un arbol envuelto con
+ * abb_concurrente_crear mientras otro inserta y quita elementos.
+*/
+void prueba_concurrente()
+{
+	int fijos[100], variables[100];
+	abb_concurrente_t *concurrente =
+		abb_concurrente_crear(abb_crear_balanceado(comparador));
+	for (int i = 0; i < 100; i++) {
+		fijos[i] = 2 * i;
+		variables[i] = 2 * i + 1;
+		abb_concurrente_insertar(concurrente, &fijos[i]);
+	}
+	struct prueba_concurrente lectores[4], escritor = {
+		.concurrente = concurrente,
+		.fijos = fijos,
+		.variables = variables,
+		.ok = true
+	};
+	pthread_t hilos[5];
+	for (int i = 0; i < 4; i++) {
+		lectores[i] = escritor;
+		pthread_create(&hilos[i], NULL, leer_concurrente, &lectores[i]);
+	}
+	pthread_create(&hilos[4], NULL, escribir_concurrente, &escritor);
+	bool ok = true;
+	for (int i = 0; i < 5; i++)
+		pthread_join(hilos[i], NULL);
+	for (int i = 0; i < 4; i++)
+		ok = ok && lectores[i].ok;
+	pa2m_afirmar(ok && escritor.ok &&
+			     abb_concurrente_tamanio(concurrente) == 100,
+		     "Varios hilos pueden buscar mientras otro modifica el "
+		     "arbol.");
+	pa2m_afirmar(!abb_concurrente_crear(NULL) &&
+			     !abb_concurrente_buscar(NULL, &fijos[0]),
+		     "No pasa nada si envuelvo un arbol NULL.");
+	abb_concurrente_destruir(concurrente, NULL);
+}
+
+struct prueba_rcu {
+	abb_rcu_t *rcu;
+	int *fijos;
+	int *variables;
+	bool ok;
+};
+
+/**
+ * Lector de prueba_rcu: con su propio lector, busca muchas veces los
+ * elementos fijos (que nunca se quitan) y los variables (que pueden estar o
+ * no, pero si están tienen que ser los del array).
+*/
+void *leer_rcu(void *prueba)
+{
+	struct prueba_rcu *datos = prueba;
+	abb_rcu_lector_t *lector = abb_rcu_lector_crear(datos->rcu);
+	for (int vuelta = 0; vuelta < 200; vuelta++) {
+		for (int i = 0; i < 100; i++) {
+			void *variable =
+				abb_rcu_buscar(lector, &datos->variables[i]);
+			if (abb_rcu_buscar(lector, &datos->fijos[i]) !=
+				    &datos->fijos[i] ||
+			    (variable && variable != &datos->variables[i]))
+				datos->ok = false;
+		}
+	}
+	abb_rcu_lector_destruir(lector);
+	return NULL;
+}
+
+/**
+ * Escritor de prueba_rcu: inserta y quita los elementos variables.
+*/
+void *escribir_rcu(void *prueba)
+{
+	struct prueba_rcu *datos = prueba;
+	for (int vuelta = 0; vuelta < 20; vuelta++) {
+		for (int i = 0; i < 100; i++)
+			abb_rcu_insertar(datos->rcu, &datos->variables[i]);
+		for (int i = 0; i < 100; i++) {
+			if (abb_rcu_quitar(datos->rcu, &datos->variables[i]) !=
+			    &datos->variables[i])
+				datos->ok = false;
+		}
+	}
+	return NULL;
+}
+
+/**
+ * Prueba si varios hilos pueden buscar sin locks en un arbol RCU mientras
+ * otro inserta y quita elementos (conviene correrla también compilando con
+ * -fsanitize=thread).
+*/
+void prueba_rcu()
+{
+	int fijos[100], variables[100];
+	abb_rcu_t *rcu = abb_rcu_crear(comparador);
+	for (int i = 0; i < 100; i++) {
+		fijos[i] = 2 * i;
+		variables[i] = 2 * i + 1;
+		abb_rcu_insertar(rcu, &fijos[i]);
+	}
+	struct prueba_rcu lectores[4], escritor = { .rcu = rcu,
+						    .fijos = fijos,
+						    .variables = variables,
+						    .ok = true };
+	pthread_t hilos[5];
+	for (int i = 0; i < 4; i++) {
+		lectores[i] = escritor;
+		pthread_create(&hilos[i], NULL, leer_rcu, &lectores[i]);
+	}
+	pthread_create(&hilos[4], NULL, escribir_rcu, &escritor);
+	bool ok = true;
+	for (int i = 0; i < 5; i++)
+		pthread_join(hilos[i], NULL);
+	for (int i = 0; i < 4; i++)
+		ok = ok && lectores[i].ok;
+	abb_rcu_lector_t *lector = abb_rcu_lector_crear(rcu);
+	int no_esta = 1;
+	pa2m_afirmar(ok && escritor.ok && abb_rcu_tamanio(rcu) == 100 &&
+			     abb_rcu_buscar(lector, &fijos[50]) == &fijos[50] &&
+			     !abb_rcu_buscar(lector, &no_esta) &&
+			     !abb_rcu_quitar(rcu, &no_esta),
+		     "Varios hilos pueden buscar sin locks mientras otro "
+		     "modifica un arbol RCU.");
+	abb_rcu_lector_destruir(lector);
+	abb_rcu_destruir(rcu, NULL);
+}
+
+/**
+ * Recibe un elemento de la prueba paralela y el contador del hilo que lo
+ * visita. Marca el elemento como visitado y suma uno al contador.
+*/
+bool visitar_paralelo(void *elemento, void *contador)
+{
+	(*(int *)elemento)++;
+	(*(size_t *)contador)++;
+	return true;
+}
+
+bool cortar_paralelo(void *elemento, void *contador)
+{
+	(*(int *)elemento)++;
+	(*(size_t *)contador)++;
+	return false;
+}
+
+/**
+ * Recibe un arbol, un array de enteros esperados y su tamaño, y devuelve true
+ * si el arbol es un AVL con cantidades correctas y sus elementos en inorden
+ * son los esperados.
+*/
+bool validar_conjunto(abb_t *abb, int *esperados, size_t cantidad)
+{
+	void *elementos[64];
+	if (!abb || abb_tamanio(abb) != cantidad ||
+	    validar_avl(abb->nodo_raiz) < 0 ||
+	    validar_cantidades(abb, abb->nodo_raiz) != (long)cantidad ||
+	    abb_recorrer(abb, INORDEN, elementos, 64) != cantidad)
+		return false;
+	for (size_t i = 0; i < cantidad; i++)
+		if (*(int *)elementos[i] != esperados[i])
+			return false;
+	return true;
+}
+
+/**
+ * Prueba si se pueden calcular la unión, la intersección y la diferencia de
+ * dos arboles, sin modificarlos y quedándose con los elementos del primero
+ * cuando hay iguales.
+*/
+void prueba_union_interseccion_diferencia()
+{
+	int pares[21], multiplos_de_3[14];
+	abb_t *a = abb_crear(comparador);
+	abb_t *b = abb_crear_multiclave(comparador);
+	for (int i = 0; i < 21; i++) {
+		pares[i] = 2 * i;
+		abb_insertar(a, &pares[i]);
+	}
+	for (int i = 13; i >= 0; i--) {
+		multiplos_de_3[i] = 3 * i;
+		abb_insertar(b, &multiplos_de_3[i]);
+	}
+	int esperados_union[28], esperados_interseccion[7],
+		esperados_diferencia[14];
+	size_t en_union = 0, en_interseccion = 0, en_diferencia = 0;
+	for (int i = 0; i <= 40; i++) {
+		if (i % 2 == 0 || i % 3 == 0)
+			esperados_union[en_union++] = i;
+		if (i % 6 == 0)
+			esperados_interseccion[en_interseccion++] = i;
+		else if (i % 2 == 0)
+			esperados_diferencia[en_diferencia++] = i;
+	}
+	abb_t *union_ab = abb_union(a, b);
+	abb_t *interseccion = abb_interseccion(a, b);
+	abb_t *diferencia = abb_diferencia(a, b);
+	int seis = 6;
+	pa2m_afirmar(validar_conjunto(union_ab, esperados_union, 28) &&
+			     abb_buscar(union_ab, &seis) == &pares[3],
+		     "Se puede calcular la unión de dos arboles.");
+	pa2m_afirmar(validar_conjunto(interseccion, esperados_interseccion,
+				      7) &&
+			     abb_buscar(interseccion, &seis) == &pares[3],
+		     "Se puede calcular la intersección de dos arboles.");
+	pa2m_afirmar(validar_conjunto(diferencia, esperados_diferencia, 14) &&
+			     abb_tamanio(a) == 21 && abb_tamanio(b) == 14,
+		     "Se puede calcular la diferencia de dos arboles sin "
+		     "modificarlos.");
+	abb_destruir(union_ab);
+	abb_destruir(interseccion);
+	abb_destruir(diferencia);
+
+	abb_t *vacio = abb_crear(comparador);
+	union_ab = abb_union(vacio, vacio);
+	pa2m_afirmar(union_ab && abb_vacio(union_ab) && !abb_union(a, NULL) &&
+			     !abb_diferencia(NULL, b),
+		     "La unión de dos arboles vacíos es un arbol vacío, y no se "
+		     "puede combinar un arbol NULL.");
+	abb_destruir(union_ab);
+	abb_destruir(vacio);
+	abb_destruir(a);
+	abb_destruir(b);
+}
+
+/**
+ * Recibe un arbol, el primer entero esperado y la cantidad, y devuelve true si
+ * sus cantidades son correctas y sus elementos en inorden son los enteros
+ * consecutivos desde el primero.
+*/
+bool validar_consecutivos(abb_t *abb, int primero, size_t cantidad)
+{
+	void *elementos[200];
+	if (!abb || abb_tamanio(abb) != cantidad ||
+	    validar_cantidades(abb, abb->nodo_raiz) != (long)cantidad ||
+	    abb_recorrer(abb, INORDEN, elementos, 200) != cantidad)
+		return false;
+	for (size_t i = 0; i < cantidad; i++)
+		if (*(int *)elementos[i] != primero + (int)i)
+			return false;
+	return true;
+}
+
+struct mitad_dividida {
+	abb_t *arbol;
+	size_t encontrados;
+};
+
+/**
+ * Recibe un struct mitad_dividida, busca en su arbol todos los números del
+ * 0 al 199, guarda cuántos encontró y destruye el arbol.
+*/
+void *leer_y_destruir(void *mitad)
+{
+	struct mitad_dividida *dividida = mitad;
+	for (int i = 0; i < 200; i++)
+		if (abb_buscar(dividida->arbol, &i))
+			dividida->encontrados++;
+	abb_destruir(dividida->arbol);
+	return NULL;
+}
+
+/**
+ * Prueba si se puede dividir un arbol por un pivote y volver a unir las
+ * partes, en arboles balanceados y sin balancear, y si los nodos se liberan
+ * bien cuando las partes de distintos arboles se mezclan, y si las dos
+ * mitades se pueden leer y destruir desde hilos distintos.
+*/
+void prueba_dividir_unir()
+{
+	int numeros[200], negativos[10];
+	abb_t *balanceado = abb_crear_balanceado(comparador);
+	abb_t *sin_balancear = abb_crear(comparador);
+	for (int i = 0; i < 200; i++)
+		numeros[i] = i;
+	for (int i = 0; i < 100; i++) {
+		abb_insertar(balanceado, &numeros[i]);
+		abb_insertar(sin_balancear, &numeros[100 + (i * 37) % 100]);
+	}
+	abb_t *menores, *mayores;
+	int pivote = 40;
+	bool dividido =
+		abb_dividir(balanceado, &pivote, &menores, &mayores);
+	pa2m_afirmar(dividido && validar_consecutivos(menores, 0, 40) &&
+			     validar_consecutivos(mayores, 40, 60) &&
+			     validar_avl(menores->nodo_raiz) > 0 &&
+			     validar_avl(mayores->nodo_raiz) > 0,
+		     "Se puede dividir un abb balanceado por un pivote.");
+	int uno_menos = 39;
+	pa2m_afirmar(!abb_unir(mayores, menores) &&
+			     validar_consecutivos(mayores, 40, 60),
+		     "No se pueden unir dos arboles en el orden equivocado.");
+	abb_t *unido = abb_unir(menores, mayores);
+	pa2m_afirmar(unido && validar_consecutivos(unido, 0, 100) &&
+			     validar_avl(unido->nodo_raiz) > 0 &&
+			     abb_quitar(unido, &uno_menos) == &numeros[39] &&
+			     abb_insertar(unido, &numeros[39]),
+		     "Se pueden unir dos abb balanceados.");
+
+	pivote = 150;
+	abb_t *sin_balancear_menores, *sin_balancear_mayores;
+	dividido = abb_dividir(sin_balancear, &pivote, &sin_balancear_menores,
+			       &sin_balancear_mayores);
+	pa2m_afirmar(dividido &&
+			     validar_consecutivos(sin_balancear_menores, 100,
+						  50) &&
+			     validar_consecutivos(sin_balancear_mayores, 150,
+						  50),
+		     "Se puede dividir un abb sin balancear por un pivote.");
+	sin_balancear = abb_unir(sin_balancear_menores, sin_balancear_mayores);
+	pa2m_afirmar(validar_consecutivos(sin_balancear, 100, 100),
+		     "Se pueden unir dos abb sin balancear.");
+
+	pivote = 50;
+	abb_dividir(unido, &pivote, &menores, &mayores);
+	pivote = 120;
+	abb_dividir(sin_balancear, &pivote, &sin_balancear_menores,
+		    &sin_balancear_mayores);
+	abb_t *negativo = abb_crear_balanceado(comparador);
+	for (int i = 0; i < 10; i++) {
+		negativos[i] = i - 10;
+		abb_insertar(negativo, &negativos[i]);
+	}
+	menores = abb_unir(negativo, menores);
+	abb_t *sin_balancear_unido = abb_crear(comparador);
+	sin_balancear_unido = abb_unir(sin_balancear_unido,
+				       sin_balancear_menores);
+	pa2m_afirmar(validar_consecutivos(menores, -10, 60) &&
+			     validar_consecutivos(sin_balancear_unido, 100,
+						  20),
+		     "Se pueden unir arboles que comparten nodos con otros.");
+	abb_destruir(menores);
+	abb_destruir(mayores);
+	abb_destruir(sin_balancear_unido);
+	abb_destruir(sin_balancear_mayores);
+
+	balanceado = abb_crear_balanceado(comparador);
+	for (int i = 0; i < 200; i++)
+		abb_insertar(balanceado, &numeros[i]);
+	pivote = 100;
+	abb_dividir(balanceado, &pivote, &menores, &mayores);
+	struct mitad_dividida mitades[2] = { { .arbol = menores },
+					     { .arbol = mayores } };
+	pthread_t hilo;
+	pthread_create(&hilo, NULL, leer_y_destruir, &mitades[1]);
+	leer_y_destruir(&mitades[0]);
+	pthread_join(hilo, NULL);
+	pa2m_afirmar(mitades[0].encontrados == 100 &&
+			     mitades[1].encontrados == 100,
+		     "Las dos mitades de un arbol dividido se pueden leer y "
+		     "destruir desde hilos distintos.");
+}
+
+/**
+ * Recibe un void pointer a un entero, un buffer y su tamaño, y copia el
+ * entero al buffer si entra. Devuelve el tamaño de un entero.
+*/
+size_t serializar_entero(void *elemento, void *buffer, size_t tamanio)
+{
+	if (tamanio >= sizeof(int))
+		memcpy(buffer, elemento, sizeof(int));
+	return sizeof(int);
+}
+
+/**
+ * Recibe un string, un buffer y su tamaño, y copia el string (con su 0 final)
+ * al buffer si entra. Devuelve lo que ocupa el string.
+*/
+size_t serializar_string(void *elemento, void *buffer, size_t tamanio)
+{
+	size_t largo = strlen(elemento) + 1;
+	if (largo <= tamanio)
+		memcpy(buffer, elemento, largo);
+	return largo;
+}
+
+/**
+ * Recibe un arbol y un serializador, y lo guarda en un archivo temporal nuevo.
+ * Devuelve true si lo pudo guardar, y deja en ruta el nombre del archivo.
+*/
+bool guardar_en_temporal(abb_t *abb, abb_serializador serializador,
+			 char *ruta)
+{
+	strcpy(ruta, "/tmp/pruebas_abb_XXXXXX");
+	int fd = mkstemp(ruta);
+	if (fd < 0)
+		return false;
+	bool guardado = abb_guardar(abb, fd, serializador);
+	close(fd);
+	return guardado;
+}
+
+/**
+ * Prueba si se puede guardar un arbol en un archivo y buscar en él después
+ * de mapearlo, y si se rechazan los archivos modificados.
+*/
+void prueba_guardar_cargar_mmap()
+{
+	int numeros[1000];
+	abb_t *abb = abb_crear(comparador);
+	for (int i = 0; i < 1000; i++) {
+		numeros[i] = (i * 7919) % 1000;
+		abb_insertar(abb, &numeros[i]);
+	}
+	char ruta[32];
+	bool guardado = guardar_en_temporal(abb, serializar_entero, ruta);
+	abb_destruir(abb);
+	abb_t *cargado = abb_cargar_mmap(ruta, comparador);
+	bool encontrados = cargado && abb_tamanio(cargado) == 1000;
+	for (int i = 0; i < 1000 && encontrados; i++) {
+		int *encontrado = abb_buscar(cargado, &i);
+		encontrados = encontrado && *encontrado == i &&
+			      (void *)encontrado != (void *)numeros;
+	}
+	int no_esta = 1000, menos_uno = -1;
+	pa2m_afirmar(guardado && encontrados &&
+			     !abb_buscar(cargado, &no_esta) &&
+			     !abb_buscar(cargado, &menos_uno) &&
+			     abb_verificar_mmap(cargado) &&
+			     !abb_verificar_mmap(NULL),
+		     "Se puede guardar un arbol y buscar en el archivo mapeado.");
+	void *elementos[1000];
+	bool ordenado = abb_recorrer(cargado, INORDEN, elementos, 1000) == 1000;
+	for (int i = 0; i < 1000 && ordenado; i++)
+		ordenado = *(int *)elementos[i] == i;
+	pa2m_afirmar(ordenado && !abb_insertar(cargado, &no_esta) &&
+			     !abb_quitar(cargado, &numeros[0]) &&
+			     abb_tamanio(cargado) == 1000,
+		     "Un arbol mapeado se puede recorrer pero no modificar.");
+	abb_congelado_t *eytzinger = abb_congelar(cargado);
+	abb_congelado_t *veb = abb_congelar_veb(cargado);
+	bool congelados = eytzinger && veb &&
+			  !abb_congelado_buscar(eytzinger, &no_esta) &&
+			  !abb_congelado_buscar(veb, &menos_uno);
+	for (int i = 0; i < 1000 && congelados; i++)
+		congelados = abb_congelado_buscar(eytzinger, &i) ==
+				     elementos[i] &&
+			     abb_congelado_buscar(veb, &i) == elementos[i];
+	pa2m_afirmar(congelados,
+		     "Se puede congelar un arbol mapeado y buscar en la foto.");
+	abb_congelado_destruir(eytzinger);
+	abb_congelado_destruir(veb);
+	abb_destruir(cargado);
+
+	FILE *archivo = fopen(ruta, "r+b");
+	fseek(archivo, -3, SEEK_END);
+	fputc(0x55, archivo);
+	fclose(archivo);
+	cargado = abb_cargar_mmap(ruta, comparador);
+	pa2m_afirmar(cargado && !abb_verificar_mmap(cargado),
+		     "abb_verificar_mmap detecta un archivo con los datos "
+		     "modificados.");
+	abb_destruir(cargado);
+	archivo = fopen(ruta, "r+b");
+	fseek(archivo, 64 + 8, SEEK_SET);
+	fputc(0x55, archivo);
+	fclose(archivo);
+	pa2m_afirmar(!abb_cargar_mmap(ruta, comparador) &&
+			     !abb_cargar_mmap("/tmp/no_existe_abb", comparador),
+		     "No se puede cargar un archivo con los desplazamientos "
+		     "modificados o inexistente.");
+	unlink(ruta);
+
+	char *strings[] = { "pera", "banana", "kiwi", "", "manzana" };
+	abb = abb_crear_balanceado(comparador_strings);
+	for (int i = 0; i < 5; i++)
+		abb_insertar(abb, strings[i]);
+	guardado = guardar_en_temporal(abb, serializar_string, ruta);
+	abb_destruir(abb);
+	cargado = abb_cargar_mmap(ruta, comparador_strings);
+	char *kiwi = cargado ? abb_buscar(cargado, "kiwi") : NULL;
+	pa2m_afirmar(guardado && kiwi && strcmp(kiwi, "kiwi") == 0 &&
+			     abb_buscar(cargado, "") &&
+			     !abb_buscar(cargado, "uva"),
+		     "Se pueden guardar elementos de distinto tamaño.");
+	abb_destruir(cargado);
+	unlink(ruta);
+}
+
+struct copia {
+	void **array;
+	size_t cantidad;
+};
+
+/**
+ * Recibe un elemento y un struct copia, y copia el elemento en la siguiente
+ * posición del array, como referencia para comparar con abb_recorrer.
+*/
+bool copiar_elemento(void *elemento, void *copia)
+{
+	struct copia *estado = copia;
+	estado->array[estado->cantidad++] = elemento;
+	return true;
+}
+
+/**
+ * Recibe un arbol, un recorrido y una cantidad, y devuelve true si
+ * abb_recorrer con un array de esa cantidad copia los mismos elementos que
+ * abb_con_cada_elemento, y ni uno más.
+*/
+bool recorrer_como_con_cada_elemento(abb_t *abb, abb_recorrido recorrido,
+				     size_t cantidad)
+{
+	void *esperados[400], *obtenidos[401];
+	struct copia copia = { .array = esperados };
+	abb_con_cada_elemento(abb, recorrido, copiar_elemento, &copia);
+	obtenidos[cantidad] = NULL;
+	size_t copiados = abb_recorrer(abb, recorrido, obtenidos, cantidad);
+	if (copiados != (cantidad < copia.cantidad ? cantidad : copia.cantidad)
+	    || obtenidos[cantidad])
+		return false;
+	return memcmp(esperados, obtenidos, copiados * sizeof(void *)) == 0;
+}
+
+/**
+ * Prueba si abb_recorrer copia lo mismo que abb_con_cada_elemento en un
+ * arbol bajo y en uno tan alto que no entra en la pila local (que se recorre
+ * con Morris), cortando cuando se llena el array y dejando el arbol intacto.
+*/
+void prueba_recorrer_arbol_alto()
+{
+	int numeros[400];
+	abb_t *bajo = abb_crear_balanceado(comparador);
+	abb_t *alto = abb_crear(comparador);
+	for (int i = 0; i < 400; i++) {
+		numeros[i] = i % 2 ? 399 - i / 2 : i / 2;
+		abb_insertar(bajo, &numeros[i]);
+		abb_insertar(alto, &numeros[i]);
+	}
+	bool iguales = true;
+	for (abb_recorrido recorrido = INORDEN; recorrido <= POSTORDEN;
+	     recorrido++)
+		iguales = iguales &&
+			  recorrer_como_con_cada_elemento(bajo, recorrido, 400) &&
+			  recorrer_como_con_cada_elemento(bajo, recorrido, 150);
+	pa2m_afirmar(iguales, "abb_recorrer copia los elementos en el orden "
+			      "pedido y se detiene al llenar el array.");
+	iguales = alto->altura_maxima == 400;
+	for (abb_recorrido recorrido = INORDEN; recorrido <= POSTORDEN;
+	     recorrido++)
+		iguales = iguales &&
+			  recorrer_como_con_cada_elemento(alto, recorrido, 150) &&
+			  recorrer_como_con_cada_elemento(alto, recorrido, 1) &&
+			  recorrer_como_con_cada_elemento(alto, recorrido, 400);
+	pa2m_afirmar(iguales && validar_cantidades(alto, alto->nodo_raiz) == 400,
+		     "abb_recorrer recorre un arbol degenerado sin pila y lo "
+		     "deja como estaba, aun si se llena el array.");
+	int cien = 100, doscientos = 200;
+	void *en_rango[400];
+	bool rango_ok = abb_rango_recorrer(alto, &cien, &doscientos, en_rango,
+					   400) == 101 &&
+			abb_rango_recorrer(alto, &cien, &doscientos, en_rango,
+					   0) == 0 &&
+			abb_rango_recorrer(alto, &cien, &doscientos, en_rango,
+					   30) == 30;
+	for (int i = 0; i < 30 && rango_ok; i++)
+		rango_ok = *(int *)en_rango[i] == 100 + i;
+	pa2m_afirmar(rango_ok && abb_rango_recorrer(bajo, &cien, &doscientos,
+						    en_rango, 400) == 101,
+		     "abb_rango_recorrer recorre un rango de un arbol alto y de "
+		     "uno bajo.");
+	abb_destruir(bajo);
+	abb_destruir(alto);
+
+	size_t cantidad = 1000000;
+	int *claves = malloc(cantidad * sizeof(int));
+	void **recorridos = malloc(cantidad * sizeof(void *));
+	abb_t *cadena = abb_crear(comparador);
+	struct nodo_abb **siguiente = &cadena->nodo_raiz;
+	for (size_t i = 0; i < cantidad; i++) {
+		claves[i] = (int)i;
+		*siguiente = abb_pool_obtener(cadena->pool);
+		(*siguiente)->elemento = &claves[i];
+		(*siguiente)->altura = 1;
+		(*siguiente)->cantidad = cantidad - i;
+		siguiente = &(*siguiente)->derecha;
+	}
+	cadena->tamanio = cantidad;
+	cadena->altura_maxima = cantidad;
+	bool en_orden =
+		abb_recorrer(cadena, POSTORDEN, recorridos, 10) == 10 &&
+		recorridos[0] == &claves[cantidad - 1] &&
+		recorridos[9] == &claves[cantidad - 10] &&
+		abb_recorrer(cadena, POSTORDEN, recorridos, cantidad) ==
+			cantidad;
+	for (size_t i = 0; i < cantidad && en_orden; i++)
+		en_orden = recorridos[i] == &claves[cantidad - 1 - i];
+	struct nodo_abb *nodo = cadena->nodo_raiz;
+	for (size_t i = 0; i < cantidad && en_orden; i++, nodo = nodo->derecha)
+		en_orden = nodo && !nodo->izquierda &&
+			   nodo->elemento == &claves[i];
+	pa2m_afirmar(en_orden && !nodo,
+		     "abb_recorrer recorre en postorden una cadena de 1M nodos "
+		     "sin pila y la deja como estaba.");
+	abb_destruir(cadena);
+	free(recorridos);
+	free(claves);
+}
+
+/**
+ * Prueba si el recorrido paralelo visita cada elemento una sola vez, si corta
+ * cuando la función devuelve false, y si el armado paralelo desde un array
+ * ordenado da el mismo arbol balanceado que el secuencial.
+*/
+void prueba_paralelo()
+{
+	int numeros[5000];
+	void *elementos[5000];
+	for (int i = 0; i < 5000; i++) {
+		numeros[i] = 2 * i;
+		elementos[i] = &numeros[i];
+	}
+	abb_t *abb =
+		abb_crear_desde_ordenado_paralelo(comparador, elementos, 5000, 4);
+	void *recorridos[5000];
+	bool ordenado = abb_recorrer(abb, INORDEN, recorridos, 5000) == 5000;
+	for (int i = 0; i < 5000 && ordenado; i++)
+		ordenado = recorridos[i] == &numeros[i];
+	pa2m_afirmar(ordenado && validar_avl(abb->nodo_raiz) > 0 &&
+			     validar_cantidades(abb, abb->nodo_raiz) == 5000,
+		     "Se puede crear un abb balanceado desde un array ordenado "
+		     "usando varios hilos.");
+
+	size_t contadores[4] = { 0 };
+	void *aux[4] = { &contadores[0], &contadores[1], &contadores[2],
+			 &contadores[3] };
+	size_t invocaciones =
+		abb_con_cada_elemento_paralelo(abb, visitar_paralelo, aux, 4);
+	bool una_vez = true;
+	for (int i = 0; i < 5000; i++)
+		una_vez = una_vez && numeros[i] == 2 * i + 1;
+	pa2m_afirmar(invocaciones == 5000 &&
+			     contadores[0] + contadores[1] + contadores[2] +
+					     contadores[3] ==
+				     5000 &&
+			     una_vez,
+		     "El recorrido paralelo visita cada elemento una sola vez "
+		     "y le pasa a cada hilo su propio aux.");
+
+	memset(contadores, 0, sizeof(contadores));
+	invocaciones = abb_con_cada_elemento_paralelo(abb, cortar_paralelo,
+						      aux, 4);
+	pa2m_afirmar(invocaciones >= 1 && invocaciones <= 4 &&
+			     contadores[0] + contadores[1] + contadores[2] +
+					     contadores[3] ==
+				     invocaciones,
+		     "El recorrido paralelo se corta cuando la función devuelve "
+		     "false.");
+	abb_destruir(abb);
+
+	/**
+	 * Una rama izquierda de 6000 nodos, cada uno con un hijo derecho: el
+	 * hilo que la baja deja miles de sub-árboles en su cola, más de los
+	 * que entran sin agrandarla y más de los que admite como máximo.
+	*/
+	int *alto = malloc(12000 * sizeof(int));
+	abb = abb_crear(comparador);
+	for (int i = 0; i < 12000; i++) {
+		alto[i] = 12000 - 2 * (i / 2) - (i % 2 ? 1 : 2);
+		abb_insertar(abb, &alto[i]);
+	}
+	memset(contadores, 0, sizeof(contadores));
+	invocaciones =
+		abb_con_cada_elemento_paralelo(abb, visitar_paralelo, aux, 4);
+	una_vez = abb->altura_maxima == 6001;
+	for (int i = 0; i < 12000 && una_vez; i++)
+		una_vez = alto[i] == 12000 - 2 * (i / 2) - (i % 2 ? 0 : 1);
+	pa2m_afirmar(invocaciones == 12000 &&
+			     contadores[0] + contadores[1] + contadores[2] +
+					     contadores[3] ==
+				     12000 &&
+			     una_vez,
+		     "El recorrido paralelo de un arbol alto visita cada "
+		     "elemento una sola vez.");
+	abb_destruir(abb);
+	free(alto);
+}
+
+/**
+ * Igual que validar_avl, pero con los nodos de un arbol persistente.
+*/
+int validar_avl_persistente(struct nodo_persistente *nodo)
+{
+	if (!nodo)
+		return 0;
+	int altura_izquierda = validar_avl_persistente(nodo->izquierda);
+	int altura_derecha = validar_avl_persistente(nodo->derecha);
+	if (altura_izquierda < 0 || altura_derecha < 0 ||
+	    altura_izquierda - altura_derecha > 1 ||
+	    altura_derecha - altura_izquierda > 1)
+		return -1;
+	int altura = (altura_izquierda > altura_derecha ? altura_izquierda :
+							  altura_derecha) +
+		     1;
+	if ((int)nodo->altura != altura)
+		return -1;
+	return altura;
+}
+
+/**
+ * Recibe una versión, un array de enteros y desde/hasta, y devuelve true si
+ * la versión tiene exactamente los elementos del array entre desde y hasta
+ * (sin incluir hasta), en orden.
+*/
+bool validar_version(abb_version_t *version, int *numeros, int desde,
+		     int hasta)
+{
+	void *elementos[200];
+	struct copia copia = { .array = elementos };
+	if (abb_version_tamanio(version) != (size_t)(hasta - desde) ||
+	    abb_version_con_cada_elemento(version, INORDEN, copiar_elemento,
+					  &copia) != (size_t)(hasta - desde))
+		return false;
+	for (int i = desde; i < hasta; i++) {
+		if (elementos[i - desde] != &numeros[i])
+			return false;
+	}
+	return validar_avl_persistente(version->raiz) >= 0;
+}
+
+/**
+ * Prueba si al insertar y quitar en un arbol persistente se obtienen
+ * versiones nuevas balanceadas, sin cambiar las anteriores, y si las
+ * versiones comparten los nodos que no cambiaron.
+*/
+void prueba_persistente()
+{
+	int numeros[200];
+	abb_version_t *versiones[201];
+	versiones[0] = abb_version_crear(comparador);
+	for (int i = 0; i < 200; i++) {
+		numeros[i] = i;
+		versiones[i + 1] =
+			abb_version_insertar(versiones[i], &numeros[i]);
+	}
+	bool intactas = true;
+	for (int i = 0; i <= 200; i++)
+		intactas = intactas &&
+			   validar_version(versiones[i], numeros, 0, i);
+	pa2m_afirmar(intactas && validar_avl_persistente(
+					 versiones[200]->raiz) == 8,
+		     "Cada inserción en un arbol persistente crea una versión "
+		     "balanceada nueva y las anteriores no cambian.");
+
+	int mayor = 1000;
+	abb_version_t *con_mayor =
+		abb_version_insertar(versiones[200], &mayor);
+	pa2m_afirmar(con_mayor->raiz != versiones[200]->raiz &&
+			     con_mayor->raiz->izquierda ==
+				     versiones[200]->raiz->izquierda,
+		     "La versión nueva comparte los sub-árboles que no "
+		     "cambiaron con la anterior.");
+
+	void *quitado = NULL;
+	abb_version_t *sin_mayor =
+		abb_version_quitar(con_mayor, &mayor, &quitado);
+	abb_version_t *foto = abb_version_tomar(sin_mayor);
+	abb_version_t *sin_cero =
+		abb_version_quitar(sin_mayor, &numeros[0], NULL);
+	pa2m_afirmar(quitado == &mayor && foto == sin_mayor &&
+			     validar_version(sin_mayor, numeros, 0, 200) &&
+			     validar_version(sin_cero, numeros, 1, 200) &&
+			     abb_version_buscar(con_mayor, &mayor) == &mayor &&
+			     !abb_version_buscar(sin_mayor, &mayor),
+		     "Quitar de un arbol persistente crea una versión nueva "
+		     "y una foto no cambia.");
+
+	int no_esta = -1;
+	abb_version_t *igual = abb_version_quitar(sin_cero, &no_esta, &quitado);
+	pa2m_afirmar(igual == sin_cero && !quitado,
+		     "Quitar un elemento que no está devuelve la misma "
+		     "versión.");
+
+	abb_version_liberar(igual);
+	abb_version_liberar(sin_cero);
+	abb_version_liberar(foto);
+	abb_version_liberar(sin_mayor);
+	for (int i = 0; i <= 200; i += 2)
+		abb_version_liberar(versiones[i]);
+	bool siguen = true;
+	for (int i = 1; i <= 200; i += 2)
+		siguen = siguen && validar_version(versiones[i], numeros, 0, i);
+	pa2m_afirmar(siguen && validar_version(con_mayor, numeros, 0, 200) ==
+					       false &&
+			     abb_version_tamanio(con_mayor) == 201,
+		     "Liberar versiones no afecta a las que comparten nodos "
+		     "con ellas.");
+	for (int i = 1; i <= 200; i += 2)
+		abb_version_liberar(versiones[i]);
+	abb_version_liberar(con_mayor);
+}
+
+struct prueba_persistente {
+	abb_version_t *foto;
+	int *numeros;
+	bool ok;
+};
+
+/**
+ * Lector de prueba_persistente_concurrente: recorre muchas veces su foto,
+ * que tiene que seguir teniendo los mismos elementos.
+*/
+void *leer_persistente(void *prueba)
+{
+	struct prueba_persistente *datos = prueba;
+	for (int vuelta = 0; vuelta < 50; vuelta++) {
+		if (!validar_version(datos->foto, datos->numeros, 0, 100))
+			datos->ok = false;
+	}
+	abb_version_liberar(datos->foto);
+	return NULL;
+}
+
+/**
+ * Prueba si varios hilos pueden leer fotos de una versión mientras otro crea
+ * versiones nuevas a partir de ella y las libera, y suelta la original
+ * (conviene correrla también compilando con -fsanitize=thread).
+*/
+void prueba_persistente_concurrente()
+{
+	int numeros[200];
+	abb_version_t *version = abb_version_crear(comparador);
+	for (int i = 0; i < 200; i++) {
+		numeros[i] = i;
+		if (i >= 100)
+			continue;
+		abb_version_t *nueva = abb_version_insertar(version, &numeros[i]);
+		abb_version_liberar(version);
+		version = nueva;
+	}
+	struct prueba_persistente lectores[4];
+	pthread_t hilos[4];
+	for (int i = 0; i < 4; i++) {
+		lectores[i] = (struct prueba_persistente){
+			.foto = abb_version_tomar(version),
+			.numeros = numeros,
+			.ok = true
+		};
+		pthread_create(&hilos[i], NULL, leer_persistente, &lectores[i]);
+	}
+	bool ok = true;
+	for (int vuelta = 0; vuelta < 20; vuelta++) {
+		abb_version_t *actual = abb_version_tomar(version);
+		for (int i = 100; i < 200; i++) {
+			abb_version_t *nueva =
+				abb_version_insertar(actual, &numeros[i]);
+			abb_version_liberar(actual);
+			actual = nueva;
+		}
+		for (int i = 0; i < 100; i += 3) {
+			abb_version_t *nueva =
+				abb_version_quitar(actual, &numeros[i], NULL);
+			abb_version_liberar(actual);
+			actual = nueva;
+		}
+		ok = ok && abb_version_tamanio(actual) == 166;
+		abb_version_liberar(actual);
+	}
+	abb_version_liberar(version);
+	for (int i = 0; i < 4; i++) {
+		pthread_join(hilos[i], NULL);
+		ok = ok && lectores[i].ok;
+	}
+	pa2m_afirmar(ok, "Varios hilos pueden leer fotos de un arbol "
+			 "persistente mientras otro crea y libera versiones.");
+}
+
+/**
+ * Prueba si un multiconjunto agrupa los elementos iguales en un único nodo,
+ * y si los recorridos, el iterador y las consultas por posición ven todas las
+ * copias.
+*/
+void prueba_multiconjunto()
+{
+	int sietes[1000], otros[100];
+	abb_t *abb = abb_crear_multiconjunto(comparador);
+	for (int i = 0; i < 100; i++) {
+		otros[i] = i < 50 ? i : i + 1;
+		abb_insertar(abb, &otros[i]);
+	}
+	for (int i = 0; i < 1000; i++) {
+		sietes[i] = 50;
+		abb_insertar(abb, &sietes[i]);
+	}
+	int cincuenta = 50;
+	pa2m_afirmar(abb_tamanio(abb) == 1100 &&
+			     abb_contar(abb, &cincuenta) == 1000 &&
+			     abb_buscar(abb, &cincuenta) == &sietes[0] &&
+			     validar_avl(abb->nodo_raiz) > 0 &&
+			     abb->nodo_raiz->altura <= 8 &&
+			     validar_cantidades(abb, abb->nodo_raiz) == 1100,
+		     "Un multiconjunto guarda los elementos iguales en un "
+		     "único nodo y el arbol no crece.");
+
+	void *recorridos[1100];
+	bool en_orden = abb_recorrer(abb, INORDEN, recorridos, 1100) == 1100;
+	for (int i = 0; i < 1100 && en_orden; i++) {
+		if (i < 50 || i >= 1050)
+			en_orden = recorridos[i] == &otros[i < 50 ? i : i - 1000];
+		else
+			en_orden = recorridos[i] == &sietes[i - 50];
+	}
+	abb_iterador_t *iterador = abb_iterador_crear(abb, INORDEN);
+	bool iterador_igual = true;
+	for (int i = 0; i < 1100; i++)
+		iterador_igual = iterador_igual &&
+				 abb_iterador_siguiente(iterador) ==
+					 recorridos[i];
+	iterador_igual = iterador_igual &&
+			 !abb_iterador_tiene_siguiente(iterador);
+	abb_iterador_destruir(iterador);
+	pa2m_afirmar(en_orden && iterador_igual,
+		     "Los recorridos y el iterador visitan todas las copias, "
+		     "seguidas y en el orden en que se insertaron.");
+
+	int cuarenta_nueve = 49, cincuenta_uno = 51;
+	void *en_rango[1002];
+	pa2m_afirmar(abb_rango_recorrer(abb, &cuarenta_nueve, &cincuenta_uno,
+					en_rango, 1002) == 1002 &&
+			     en_rango[1] == &sietes[0] &&
+			     en_rango[1001] == &otros[50] &&
+			     abb_contar_entre(abb, &cuarenta_nueve,
+					      &cincuenta_uno) == 1002 &&
+			     abb_rango_de(abb, &cincuenta_uno) == 1050 &&
+			     abb_seleccionar(abb, 549) == &sietes[499] &&
+			     abb_seleccionar(abb, 1050) == &otros[50],
+		     "Los rangos y las consultas por posición cuentan todas "
+		     "las copias.");
+
+	int quitados = 0;
+	pa2m_afirmar(abb_quitar(abb, &cincuenta) == &sietes[999] &&
+			     abb_contar(abb, &cincuenta) == 999 &&
+			     validar_cantidades(abb, abb->nodo_raiz) == 1099,
+		     "abb_quitar quita la última copia que se insertó.");
+	abb_quitar(abb, &otros[20]);
+	pa2m_afirmar(abb_quitar_todos(abb, &cincuenta, sumar_uno) == 999 &&
+			     sietes[0] == 51 && sietes[998] == 51 &&
+			     sietes[999] == 50 &&
+			     abb_contar(abb, &cincuenta) == 0 &&
+			     abb_tamanio(abb) == 99 &&
+			     validar_avl(abb->nodo_raiz) > 0 &&
+			     validar_cantidades(abb, abb->nodo_raiz) == 99 &&
+			     abb_quitar_todos(abb, &cincuenta, NULL) == 0,
+		     "abb_quitar_todos quita todas las copias e invoca el "
+		     "destructor con cada una.");
+
+	for (int i = 0; i < 10; i++)
+		abb_insertar(abb, &otros[0]);
+	abb_t *otro = abb_crear_multiconjunto(comparador);
+	pa2m_afirmar(!abb_union(abb, otro) && !abb_unir(abb, otro),
+		     "Un multiconjunto no se puede combinar con otros arboles.");
+	abb_t *comun = abb_crear_balanceado(comparador);
+	pa2m_afirmar(comun->pool->tamanio_objeto == sizeof(struct nodo_abb) &&
+			     otro->pool->tamanio_objeto ==
+				     sizeof(struct nodo_multiconjunto),
+		     "Solo los multiconjuntos reservan nodos con lugar para "
+		     "las copias repetidas.");
+	abb_destruir(comun);
+	abb_destruir(otro);
+	abb_destruir_todo(abb, sumar_uno);
+	for (int i = 0; i < 100; i++)
+		quitados += otros[i] - (i < 50 ? i : i + 1);
+	pa2m_afirmar(quitados == 99 + 10,
+		     "abb_destruir_todo invoca el destructor con todas las "
+		     "copias.");
+}
+
+/**
+ * Prueba si abb_contar y abb_quitar_todos funcionan también en un arbol que
+ * no es un multiconjunto.
+*/
+void prueba_contar_y_quitar_todos()
+{
+	int numeros[20];
+	abb_t *abb = abb_crear(comparador);
+	for (int i = 0; i < 20; i++) {
+		numeros[i] = i % 4;
+		abb_insertar(abb, &numeros[i]);
+	}
+	int dos = 2;
+	pa2m_afirmar(abb_contar(abb, &dos) == 5 &&
+			     abb_quitar_todos(abb, &dos, NULL) == 5 &&
+			     abb_contar(abb, &dos) == 0 &&
+			     abb_tamanio(abb) == 15,
+		     "abb_contar y abb_quitar_todos funcionan en un arbol "
+		     "común.");
+	abb_destruir(abb);
+}
+
+/**
+ * Prueba si abb_estadisticas describe la forma de un arbol degenerado y la
+ * de uno balanceado, y si los contadores acumulan las operaciones.
+*/
+void prueba_estadisticas()
+{
+	int numeros[127];
+	abb_t *abb = abb_crear(comparador);
+	abb_t *avl = abb_crear_balanceado(comparador);
+	for (int i = 0; i < 127; i++) {
+		numeros[i] = i;
+		if (i < 100)
+			abb_insertar(abb, &numeros[i]);
+		abb_insertar(avl, &numeros[i]);
+	}
+	abb_estadisticas_t estadisticas;
+	bool histograma_degenerado = true;
+	pa2m_afirmar(abb_estadisticas(abb, &estadisticas) &&
+			     !abb_estadisticas(NULL, &estadisticas) &&
+			     !abb_estadisticas(abb, NULL),
+		     "abb_estadisticas devuelve false con punteros NULL.");
+	for (size_t i = 0; i < ABB_ESTADISTICAS_NIVELES - 1; i++)
+		histograma_degenerado = histograma_degenerado &&
+					estadisticas.histograma[i] == 1;
+	pa2m_afirmar(estadisticas.cantidad == 100 &&
+			     estadisticas.nodos == 100 &&
+			     estadisticas.altura == 100 &&
+			     estadisticas.profundidad_promedio == 50.5 &&
+			     histograma_degenerado &&
+			     estadisticas.histograma[ABB_ESTADISTICAS_NIVELES -
+						     1] == 37 &&
+			     estadisticas.memoria_nodos ==
+				     100 * abb->pool->tamanio_objeto &&
+			     estadisticas.memoria_reservada >=
+				     estadisticas.memoria_nodos,
+		     "Un arbol degenerado tiene un nodo por nivel, y el último "
+		     "nivel del histograma acumula los más profundos.");
+
+	bool histograma_completo = abb_estadisticas(avl, &estadisticas);
+	for (size_t i = 0; i < 7; i++)
+		histograma_completo = histograma_completo &&
+				      estadisticas.histograma[i] == 1u << i;
+	pa2m_afirmar(histograma_completo && estadisticas.altura == 7 &&
+			     estadisticas.histograma[7] == 0 &&
+			     estadisticas.profundidad_promedio ==
+				     (1 + 2 * 2 + 4 * 3 + 8 * 4 + 16 * 5 +
+				      32 * 6 + 64 * 7) /
+					     127.0,
+		     "Un AVL de 127 elementos insertados en orden queda "
+		     "completo, con 2^k nodos en el nivel k + 1.");
+
+#ifdef ABB_CONTADORES
+	abb_estadisticas(abb, &estadisticas);
+	uint64_t comparaciones = estadisticas.comparaciones;
+	abb_buscar(abb, &numeros[0]);
+	abb_buscar(abb, &numeros[9]);
+	abb_estadisticas(abb, &estadisticas);
+	pa2m_afirmar(comparaciones == 99 * 100 / 2 &&
+			     estadisticas.comparaciones == comparaciones + 11 &&
+			     estadisticas.nodos_reservados == 100 &&
+			     estadisticas.nodos_liberados == 0 &&
+			     estadisticas.rebalanceos == 0,
+		     "Los contadores cuentan cada invocación al comparador y "
+		     "cada nodo reservado.");
+
+	for (int i = 0; i < 27; i++)
+		abb_quitar(avl, &numeros[i * 4]);
+	abb_estadisticas(avl, &estadisticas);
+	pa2m_afirmar(estadisticas.rebalanceos > 0 &&
+			     estadisticas.nodos_reservados == 127 &&
+			     estadisticas.nodos_liberados == 27 &&
+			     estadisticas.nodos_reservados -
+					     estadisticas.nodos_liberados ==
+				     estadisticas.nodos,
+		     "Los contadores de un AVL cuentan las rotaciones y los "
+		     "nodos liberados al quitar.");
+	pa2m_afirmar(offsetof(struct abb, contadores) >=
+			     offsetof(struct abb, multiconjunto) +
+				     CONCURRENTE_LINEA_CACHE,
+		     "Los contadores quedan a una línea de cache de los campos "
+		     "que leen las búsquedas.");
+#else
+	abb_buscar(abb, &numeros[0]);
+	abb_estadisticas(abb, &estadisticas);
+	pa2m_afirmar(estadisticas.comparaciones == 0 &&
+			     estadisticas.nodos_reservados == 0 &&
+			     estadisticas.rebalanceos == 0,
+		     "Sin -DABB_CONTADORES los contadores valen 0.");
+#endif
+	abb_destruir(abb);
+	abb_destruir(avl);
+
+	abb_t *multiclave = abb_crear_multiclave(comparador);
+	for (int i = 0; i < 127; i++)
+		abb_insertar(multiclave, &numeros[i]);
+	pa2m_afirmar(abb_estadisticas(multiclave, &estadisticas) &&
+			     estadisticas.cantidad == 127 &&
+			     estadisticas.altura == multiclave->altura_maxima &&
+			     estadisticas.profundidad_promedio ==
+				     (double)estadisticas.altura &&
+			     estadisticas.memoria_nodos ==
+				     estadisticas.nodos *
+					     MULTICLAVE_TAMANIO_NODO,
+		     "En un arbol multiclave todos los elementos están en el "
+		     "último nivel.");
+	abb_destruir(multiclave);
+}
+
 int main()
 {
 	pa2m_nuevo_grupo(
@@ -454,5 +2443,34 @@ int main()
 	prueba_recorrer_inorden();
 	prueba_recorrer_preorden();
 	prueba_recorrer_postorden();
+	prueba_recorrer_arbol_alto();
+	prueba_insertar_balanceado();
+	prueba_quitar_balanceado();
+	prueba_estres_arbol_degenerado();
+	prueba_pool_reutiliza_nodos();
+	prueba_destruir_todo_invoca_destructor();
+	prueba_crear_desde_ordenado();
+	prueba_crear_desde_desordenado();
+	prueba_union_interseccion_diferencia();
+	prueba_dividir_unir();
+	prueba_iterador_recorridos();
+	prueba_iterador_intercalado();
+	prueba_rango();
+	prueba_estadisticos_de_orden();
+	prueba_piso_techo_predecesor_sucesor();
+	prueba_congelar();
+	prueba_guardar_cargar_mmap();
+	prueba_multiclave();
+	prueba_buscar_lote();
+	prueba_abb_tipado();
+	prueba_crear_con_clave();
+	prueba_multiconjunto();
+	prueba_contar_y_quitar_todos();
+	prueba_estadisticas();
+	prueba_concurrente();
+	prueba_rcu();
+	prueba_paralelo();
+	prueba_persistente();
+	prueba_persistente_concurrente();
 	return pa2m_mostrar_reporte();
 }
@@ -1,7 +1,39 @@
 #include "abb.h"
 #include "abb_estructura_privada.h"
+#include "abb_multiclave.h"
+#include "abb_pool.h"
 #include <stddef.h>
+#include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
+
+#define BUSQUEDA_GRUPO 16
+#define RECORRER_PILA 128
+
+/**
+ * Recibe un comparador y el tamaño de los nodos del arbol (el de struct
+ * nodo_abb, o el de un nodo que la extiende), y crea un arbol vacío con un
+ * pool de nodos de ese tamaño, alineados solo como lo pide struct nodo_abb
+ * para que el pool no les agregue relleno.
+ * Devuelve un puntero al arbol creado o NULL en caso de error.
+*/
+abb_t *crear_arbol(abb_comparador comparador, size_t tamanio_nodo)
+{
+	if (!comparador)
+		return NULL;
+	struct abb *nuevo_abb = calloc(1, sizeof(struct abb));
+	if (!nuevo_abb)
+		return NULL;
+	nuevo_abb->pool =
+		abb_pool_crear_alineado(tamanio_nodo,
+					_Alignof(struct nodo_abb));
+	if (!nuevo_abb->pool) {
+		free(nuevo_abb);
+		return NULL;
+	}
+	nuevo_abb->comparador = comparador;
+	return nuevo_abb;
+}
 
 /**
  * Crea un arbol binario de búsqueda. Comparador es una función que se utiliza
@@ -10,409 +42,1680 @@
  * Devuelve un puntero al arbol creado o NULL en caso de error.
  */
 abb_t *abb_crear(abb_comparador comparador)
+{
+	return crear_arbol(comparador, sizeof(struct nodo_abb));
+}
+
+/**
+ * Crea un arbol binario de búsqueda balanceado (AVL). Se comporta igual que un
+ * arbol creado con abb_crear, pero cada inserción y eliminación rebalancea el
+ * arbol, por lo que su altura es siempre O(log n).
+ *
+ * Devuelve un puntero al arbol creado o NULL en caso de error.
+ */
+abb_t *abb_crear_balanceado(abb_comparador comparador)
+{
+	abb_t *nuevo_abb = abb_crear(comparador);
+	if (!nuevo_abb)
+		return NULL;
+	nuevo_abb->balanceado = true;
+	return nuevo_abb;
+}
+
+/**
+ * Crea un arbol multiclave: un arbol B+ cuyos nodos ocupan
+ * MULTICLAVE_TAMANIO_NODO bytes alineados a línea de cache, con hasta 14
+ * elementos por hoja y 8 hijos por nodo interno, y cuyas hojas están
+ * enlazadas en orden.
+ *
+ * Devuelve un puntero al arbol creado o NULL en caso de error.
+ */
+abb_t *abb_crear_multiclave(abb_comparador comparador)
 {
 	if (!comparador)
 		return NULL;
 	struct abb *nuevo_abb = calloc(1, sizeof(struct abb));
 	if (!nuevo_abb)
 		return NULL;
+	nuevo_abb->pool = abb_pool_crear_alineado(MULTICLAVE_TAMANIO_NODO,
+						  MULTICLAVE_TAMANIO_NODO / 2);
+	if (!nuevo_abb->pool) {
+		free(nuevo_abb);
+		return NULL;
+	}
 	nuevo_abb->comparador = comparador;
+	nuevo_abb->multiclave = true;
+	return nuevo_abb;
+}
+
+/**
+ * Crea un arbol balanceado (ver abb_crear_balanceado) que además guarda en
+ * cada nodo la clave que el extractor devuelve para su elemento, y la compara
+ * antes de invocar al comparador. Solo los nodos de estos arboles tienen
+ * lugar para la clave.
+ *
+ * Devuelve un puntero al arbol creado o NULL en caso de error.
+ */
+abb_t *abb_crear_con_clave(abb_comparador comparador,
+			   abb_extractor_clave extractor)
+{
+	if (!extractor)
+		return NULL;
+	abb_t *nuevo_abb = crear_arbol(comparador, sizeof(struct nodo_con_clave));
+	if (!nuevo_abb)
+		return NULL;
+	nuevo_abb->balanceado = true;
+	nuevo_abb->extractor = extractor;
+	return nuevo_abb;
+}
+
+/**
+ * Crea un arbol balanceado (ver abb_crear_balanceado) que guarda los
+ * elementos iguales en un único nodo, con las copias en un array aparte.
+ * Solo los nodos de estos arboles tienen lugar para el puntero a ese array.
+ *
+ * Devuelve un puntero al arbol creado o NULL en caso de error.
+ */
+abb_t *abb_crear_multiconjunto(abb_comparador comparador)
+{
+	abb_t *nuevo_abb =
+		crear_arbol(comparador, sizeof(struct nodo_multiconjunto));
+	if (!nuevo_abb)
+		return NULL;
+	nuevo_abb->balanceado = true;
+	nuevo_abb->multiconjunto = true;
 	return nuevo_abb;
 }
 
 /**
- * Recibe un void pointer a un elemento, y crea un struct nodo_abb con
- * ese elemento.
+ * Recibe un nodo de un arbol con extractor y devuelve un puntero a la clave
+ * que se guarda a continuación del nodo (ver struct nodo_con_clave).
+*/
+uint64_t *nodo_clave(struct nodo_abb *nodo)
+{
+	return &((struct nodo_con_clave *)nodo)->clave;
+}
+
+/**
+ * Recibe un nodo de un multiconjunto y devuelve un puntero a sus copias
+ * repetidas, que se guardan a continuación del nodo (ver struct
+ * nodo_multiconjunto).
+*/
+struct repetidos **nodo_repetidos(struct nodo_abb *nodo)
+{
+	return &((struct nodo_multiconjunto *)nodo)->repetidos;
+}
+
+/**
+ * Recibe un puntero a struct abb y un void pointer a un elemento, y crea un
+ * struct nodo_abb con ese elemento, obteniéndolo del pool del arbol.
  * Devuelve un puntero al nodo creado.
 */
-struct nodo_abb *crear_nodo(void *elemento)
+struct nodo_abb *crear_nodo(abb_t *arbol, void *elemento)
 {
-	struct nodo_abb *nuevo_nodo = calloc(1, sizeof(struct nodo_abb));
+	struct nodo_abb *nuevo_nodo = abb_pool_obtener(arbol->pool);
 	if (!nuevo_nodo)
 		return NULL;
+	ABB_CONTAR(arbol, nodos_reservados, 1);
 	nuevo_nodo->elemento = elemento;
+	nuevo_nodo->altura = 1;
+	nuevo_nodo->cantidad = 1;
+	if (arbol->extractor)
+		*nodo_clave(nuevo_nodo) = arbol->extractor(elemento);
 	return nuevo_nodo;
 }
 
 /**
- * Recibe un doble puntero a un struct nodo_abb, un void pointer a un elemento
- * y un abb_comparador, recorre recursivamente los hijos del nodo pasado por
- * parámetro e inserta un nuevo nodo con ese elemento de manera ordenada.
+ * Recibe un puntero a struct abb y dos void pointers a elementos, y los
+ * compara con el comparador del arbol, sumando uno a sus comparaciones.
 */
-void abb_insertar_recu(struct nodo_abb **nodo_actual, void *elemento,
-		       abb_comparador comparador)
+int comparar(abb_t *arbol, void *a, void *b)
 {
-	if (!(*nodo_actual)) {
-		*nodo_actual = crear_nodo(elemento);
-		return;
-	}
-	if (comparador((*nodo_actual)->elemento, elemento) >= 0)
-		abb_insertar_recu(&((*nodo_actual)->izquierda), elemento,
-				  comparador);
-	else
-		abb_insertar_recu(&((*nodo_actual)->derecha), elemento,
-				  comparador);
+	ABB_CONTAR(arbol, comparaciones, 1);
+	return arbol->comparador(a, b);
 }
 
 /**
- * Inserta un elemento en el arbol.
- * El arbol admite elementos con valores repetidos.
- *
- * Devuelve el arbol en caso de exito o NULL en caso de error.
- */
-abb_t *abb_insertar(abb_t *arbol, void *elemento)
+ * Recibe un puntero a struct abb, un nodo, un void pointer a un elemento y
+ * su clave (que solo se usa si el arbol tiene extractor), y compara el
+ * elemento del nodo con el recibido. Si las claves difieren alcanza con
+ * ellas, sin leer el elemento del nodo; si son iguales decide el comparador.
+*/
+int comparar_con_nodo(abb_t *arbol, struct nodo_abb *nodo, void *elemento,
+		      uint64_t clave)
 {
-	if (!arbol)
-		return NULL;
-	abb_insertar_recu(&(arbol->nodo_raiz), elemento, arbol->comparador);
-	arbol->tamanio++;
-	return arbol;
+	if (arbol->extractor && *nodo_clave(nodo) != clave)
+		return *nodo_clave(nodo) < clave ? -1 : 1;
+	return comparar(arbol, nodo->elemento, elemento);
 }
 
 /**
- * Recibe un puntero a un struct nodo_abb y devuelve cuantos hijos 
- * tiene ese nodo.
+ * Recibe un puntero a struct abb y un void pointer a un elemento, y devuelve
+ * la clave del elemento, o 0 si el arbol no tiene extractor.
 */
-int nodo_cantidad_hijos(struct nodo_abb *nodo)
+uint64_t clave_de(abb_t *arbol, void *elemento)
 {
-	if (nodo->derecha && nodo->izquierda)
-		return 2;
-	if (nodo->derecha || nodo->izquierda)
-		return 1;
-	return 0;
+	return arbol->extractor ? arbol->extractor(elemento) : 0;
 }
 
 /**
- * Recibe un struct nodo_abb y un entero (0 o 1).
- * Si el entero es 0, crea un puntero al hijo izquierdo del nodo pasado por
- * parámetro, o al derecho si es 1.
+ * Recibe un puntero a struct abb y un nodo que ya no forma parte del mismo, y
+ * lo devuelve al pool del arbol para que pueda ser reutilizado.
 */
-struct nodo_abb *crear_nodo_a_quitar(struct nodo_abb *nodo_padre, int posicion)
+void liberar_nodo(abb_t *arbol, struct nodo_abb *nodo)
 {
-	struct nodo_abb *nodo_a_quitar = NULL;
-	if (posicion == 0)
-		nodo_a_quitar = nodo_padre->izquierda;
-	else
-		nodo_a_quitar = nodo_padre->derecha;
-	return nodo_a_quitar;
+	ABB_CONTAR(arbol, nodos_liberados, 1);
+	abb_pool_devolver(arbol->pool, nodo);
 }
 
 /**
- * Recibe dos punteros a struct nodo_abb, donde uno es el hijo del otro, y
- * a su vez no tiene ningún hijo, y un entero (0 o 1), que indica si este nodo
- * es el hijo izquierdo (0) o el derecho (1).
- * Libera el hijo y hace que el padre apunte a NULL en esa posición.
+ * Recibe un puntero a un struct nodo_abb y devuelve su altura, o 0 si el nodo
+ * es NULL.
 */
-void quitar_hijo_sin_hijos(struct nodo_abb *nodo_padre,
-			   struct nodo_abb *nodo_a_quitar, int posicion)
+size_t nodo_altura(struct nodo_abb *nodo)
 {
-	if (posicion == 0)
-		nodo_padre->izquierda = NULL;
-	else
-		nodo_padre->derecha = NULL;
-	free(nodo_a_quitar);
+	if (!nodo)
+		return 0;
+	return nodo->altura;
 }
 
 /**
- * Recibe dos punteros a struct nodo_abb, donde uno es el hijo del otro, y
- * a su vez tiene un solo hijo, y un entero (0 o 1), que indica si este nodo es
- * el hijo izquierdo (0) o el derecho (1).
- * Hace que el padre apunte al unico hijo del nodo pasado por parámetro, y
- * libera este nodo.
+ * Recibe un puntero a un struct nodo_abb y devuelve la cantidad de elementos
+ * de su sub-árbol, o 0 si el nodo es NULL.
 */
-void quitar_hijo_con_un_hijo(struct nodo_abb *nodo_padre,
-			     struct nodo_abb *nodo_a_quitar, int posicion)
+size_t nodo_cantidad(struct nodo_abb *nodo)
 {
-	if (posicion == 0) {
-		if (nodo_a_quitar->derecha)
-			nodo_padre->izquierda = nodo_a_quitar->derecha;
-		else
-			nodo_padre->izquierda = nodo_a_quitar->izquierda;
-	} else {
-		if (nodo_a_quitar->derecha)
-			nodo_padre->derecha = nodo_a_quitar->derecha;
-		else
-			nodo_padre->derecha = nodo_a_quitar->izquierda;
-	}
-	free(nodo_a_quitar);
+	if (!nodo)
+		return 0;
+	return nodo->cantidad;
 }
 
 /**
- * Recibe un puntero a struct nodo_abb, y recorre recursivamente hacia la
- * derecho, devolviendo un puntero al nodo cuyo hijo derecho no tiene hijo
- * derecho. Es decir que devuelve un puntero al nodo padre del nodo predecesor
- * inorden (el inmediatamente menor) al padre del nodo pasado por parámetro.
+ * Recibe un puntero a struct abb y uno de sus nodos, y devuelve la cantidad
+ * de elementos que guarda el nodo: 1, más las copias repetidas si el arbol es
+ * un multiconjunto.
 */
-struct nodo_abb *buscar_predecesor_inorden(struct nodo_abb *nodo_actual)
+size_t nodo_copias(abb_t *arbol, struct nodo_abb *nodo)
 {
-	if (!nodo_actual->derecha->derecha) {
-		return nodo_actual;
-	}
-	return buscar_predecesor_inorden(nodo_actual->derecha);
+	if (!arbol->multiconjunto || !*nodo_repetidos(nodo))
+		return 1;
+	return (*nodo_repetidos(nodo))->cantidad + 1;
 }
 
 /**
- * Recibe un puntero a struct nodo_abb, quita el predecesor inorden de ese nodo
- * (aquel que contiene el elemento inmediatamente menor al nodo pasado por
- * parámetro), y devuelve el elemento del predecesor.
+ * Recibe un puntero a un struct nodo_abb y una posición menor a
+ * nodo_copias(nodo), y devuelve el elemento de esa posición: el del nodo si
+ * es 0, o si no una de las copias repetidas.
 */
-void *quitar_predecesor_a_derecha(struct nodo_abb *nodo_actual)
+void *nodo_copia(struct nodo_abb *nodo, size_t posicion)
 {
-	struct nodo_abb *nodo_padre_del_predecesor =
-		buscar_predecesor_inorden(nodo_actual->izquierda);
-	struct nodo_abb *nodo_predecesor = nodo_padre_del_predecesor->derecha;
-	void *elemento_predecesor = nodo_predecesor->elemento;
-	if (nodo_cantidad_hijos(nodo_predecesor) == 0) {
-		quitar_hijo_sin_hijos(nodo_padre_del_predecesor,
-				      nodo_predecesor, 1);
-	} else {
-		quitar_hijo_con_un_hijo(nodo_padre_del_predecesor,
-					nodo_predecesor, 1);
-	}
-	return elemento_predecesor;
+	if (posicion == 0)
+		return nodo->elemento;
+	return (*nodo_repetidos(nodo))->elementos[posicion - 1];
 }
 
 /**
- * Recibe un puntero a struct nodo_abb, quita su hijo izquierdo, y devuelve el
- * elemento de ese hijo.
+ * Recibe un puntero a struct abb y uno de sus nodos, y recalcula la altura
+ * del nodo y la cantidad de elementos de su sub-árbol a partir de las de sus
+ * hijos.
 */
-void *quitar_hijo_izquierda(struct nodo_abb *nodo_actual)
+void nodo_actualizar(abb_t *arbol, struct nodo_abb *nodo)
 {
-	void *elemento_predecesor = nodo_actual->izquierda->elemento;
-	if (nodo_cantidad_hijos(nodo_actual->izquierda) == 0) {
-		quitar_hijo_sin_hijos(nodo_actual, nodo_actual->izquierda, 0);
-	} else {
-		quitar_hijo_con_un_hijo(nodo_actual, nodo_actual->izquierda, 0);
-	}
-	return elemento_predecesor;
+	nodo->cantidad = nodo_cantidad(nodo->izquierda) +
+			 nodo_cantidad(nodo->derecha) +
+			 nodo_copias(arbol, nodo);
+	size_t altura_izquierda = nodo_altura(nodo->izquierda);
+	size_t altura_derecha = nodo_altura(nodo->derecha);
+	if (altura_izquierda > altura_derecha)
+		nodo->altura = altura_izquierda + 1;
+	else
+		nodo->altura = altura_derecha + 1;
 }
 
 /**
- * Recibe un puntero a struct nodo_abb que tiene dos hijos, quita el nodo 
- * predecesor inorden del pasado por parámetro (aquel que contiene el elemento
- * inmediatamente menor), y copia el elemento predecesor en el nodo pasado por
- * parámetro. Es decir que quita un nodo con dos hijos de un abb.
+ * Recibe un puntero a struct abb y uno de sus nodos con hijo izquierdo, y lo
+ * rota hacia la derecha: el hijo izquierdo pasa a ser la raíz del sub-árbol.
+ * Devuelve un puntero a la nueva raíz del sub-árbol.
 */
-void quitar_hijo_con_dos_hijos(struct nodo_abb *nodo_a_quitar)
+struct nodo_abb *rotar_a_derecha(abb_t *arbol, struct nodo_abb *nodo)
 {
-	void *elemento_predecesor = NULL;
-	if (nodo_a_quitar->izquierda->derecha) {
-		elemento_predecesor =
-			quitar_predecesor_a_derecha(nodo_a_quitar);
-	} else {
-		elemento_predecesor = quitar_hijo_izquierda(nodo_a_quitar);
-	}
-	nodo_a_quitar->elemento = elemento_predecesor;
+	struct nodo_abb *nueva_raiz = nodo->izquierda;
+	nodo->izquierda = nueva_raiz->derecha;
+	nueva_raiz->derecha = nodo;
+	nodo_actualizar(arbol, nodo);
+	nodo_actualizar(arbol, nueva_raiz);
+	return nueva_raiz;
 }
 
 /**
- * Recibe un puntero a struct abb, un puntero a struct nodo_abb, un void
- * pointer a un elemento, y un entero (0 o 1).
- * Quita el hijo derecho (si el entero es 1) o el izquierdo (si es 0) del nodo
- * pasado por parámetro, reduce el tamaño del arbol, y devuelve el elemento.
+ * Recibe un puntero a struct abb y uno de sus nodos con hijo derecho, y lo
+ * rota hacia la izquierda: el hijo derecho pasa a ser la raíz del sub-árbol.
+ * Devuelve un puntero a la nueva raíz del sub-árbol.
 */
-void *quitar_un_hijo(abb_t *arbol, struct nodo_abb *nodo_padre, void *elemento,
-		     int posicion)
+struct nodo_abb *rotar_a_izquierda(abb_t *arbol, struct nodo_abb *nodo)
 {
-	struct nodo_abb *nodo_a_quitar =
-		crear_nodo_a_quitar(nodo_padre, posicion);
-	if (nodo_cantidad_hijos(nodo_a_quitar) == 0) {
-		quitar_hijo_sin_hijos(nodo_padre, nodo_a_quitar, posicion);
-	} else if (nodo_cantidad_hijos(nodo_a_quitar) == 1) {
-		quitar_hijo_con_un_hijo(nodo_padre, nodo_a_quitar, posicion);
-	} else {
-		quitar_hijo_con_dos_hijos(nodo_a_quitar);
-	}
-	arbol->tamanio--;
-	return elemento;
+	struct nodo_abb *nueva_raiz = nodo->derecha;
+	nodo->derecha = nueva_raiz->izquierda;
+	nueva_raiz->izquierda = nodo;
+	nodo_actualizar(arbol, nodo);
+	nodo_actualizar(arbol, nueva_raiz);
+	return nueva_raiz;
 }
 
 /**
- * Recibe un puntero a struct abb, un puntero a struct nodo_abb, un void
- * pointer a un elemento, y un abb_comparador. Recorre el arbol recursivamente
- * a partir del nodo pasado por parámetro hasta encontrar el nodo que contiene
- * el elemento recibido, lo quita del árbol y lo devuelve.
+ * Recibe un puntero a struct abb y un puntero a un struct nodo_abb cuyos
+ * hijos están balanceados y difieren en altura en 2 como máximo. Actualiza su
+ * altura y, si está desbalanceado, aplica la rotación simple o doble que
+ * corresponda (y la suma a los rebalanceos del arbol).
+ * Devuelve un puntero a la nueva raíz del sub-árbol.
 */
-void *abb_quitar_recu(abb_t *arbol, struct nodo_abb *nodo_actual,
-		      void *elemento, abb_comparador comparador)
+struct nodo_abb *balancear_nodo(abb_t *arbol, struct nodo_abb *nodo)
 {
-	if (!nodo_actual) {
-		return NULL;
-	} else if (nodo_actual->derecha &&
-		   comparador(nodo_actual->derecha->elemento, elemento) == 0) {
-		return quitar_un_hijo(arbol, nodo_actual, elemento, 1);
-	} else if (nodo_actual->izquierda &&
-		   comparador(nodo_actual->izquierda->elemento, elemento) ==
-			   0) {
-		return quitar_un_hijo(arbol, nodo_actual, elemento, 0);
-	} else if (comparador(nodo_actual->elemento, elemento) > 0) {
-		return abb_quitar_recu(arbol, nodo_actual->izquierda, elemento,
-				       comparador);
-	} else {
-		return abb_quitar_recu(arbol, nodo_actual->derecha, elemento,
-				       comparador);
+	size_t altura_izquierda = nodo_altura(nodo->izquierda);
+	size_t altura_derecha = nodo_altura(nodo->derecha);
+	if (altura_izquierda > altura_derecha + 1) {
+		if (nodo_altura(nodo->izquierda->derecha) >
+		    nodo_altura(nodo->izquierda->izquierda)) {
+			nodo->izquierda =
+				rotar_a_izquierda(arbol, nodo->izquierda);
+			ABB_CONTAR(arbol, rebalanceos, 1);
+		}
+		ABB_CONTAR(arbol, rebalanceos, 1);
+		return rotar_a_derecha(arbol, nodo);
 	}
+	if (altura_derecha > altura_izquierda + 1) {
+		if (nodo_altura(nodo->derecha->izquierda) >
+		    nodo_altura(nodo->derecha->derecha)) {
+			nodo->derecha = rotar_a_derecha(arbol, nodo->derecha);
+			ABB_CONTAR(arbol, rebalanceos, 1);
+		}
+		ABB_CONTAR(arbol, rebalanceos, 1);
+		return rotar_a_izquierda(arbol, nodo);
+	}
+	nodo_actualizar(arbol, nodo);
+	return nodo;
 }
 
 /**
- * Recibe un puntero a un struct abb que contiene un único elemento, y un
- * puntero a ese elemento. Quita el único elemento del árbol, reduce su tamaño
- * y devuelve el elemento.
+ * Recibe un puntero a struct abb, un array de nodos contiguos obtenido de su
+ * pool y una posición, y devuelve el nodo de esa posición. Los nodos están
+ * separados por el tamaño de objeto del pool, que depende de qué tipo de nodo
+ * usa el arbol.
 */
-void *quitar_unico_elemento(abb_t *arbol, void *elemento)
+struct nodo_abb *nodo_en(abb_t *arbol, struct nodo_abb *nodos, size_t posicion)
 {
-	free(arbol->nodo_raiz);
-	arbol->nodo_raiz = NULL;
-	arbol->tamanio--;
-	return elemento;
+	return (struct nodo_abb *)((char *)nodos +
+				   posicion * arbol->pool->tamanio_objeto);
 }
 
 /**
- * Recibe un puntero a un struct abb cuya raíz tiene un solo hijo, y quita esa
- * raíz, haciendo que su único hijo sea la nueva raiz.
+ * Recibe un puntero a struct abb, un array de nodos de su pool, un array de
+ * elementos ordenados y un rango [inicio, fin) de ambos. Arma un sub-árbol de
+ * altura mínima con los elementos del rango, usando como raíz el elemento del
+ * medio y armando recursivamente los hijos con cada mitad. Cada elemento va
+ * al nodo de su misma posición (con su clave, si el arbol tiene extractor),
+ * así que los nodos quedan en memoria en orden inorden.
+ * Devuelve un puntero a la raíz del sub-árbol, o NULL si el rango está vacío.
 */
-void quitar_raiz_con_un_hijo(abb_t *arbol)
+struct nodo_abb *armar_sub_arbol_ordenado(abb_t *arbol, struct nodo_abb *nodos,
+					  void **elementos, size_t inicio,
+					  size_t fin)
 {
-	struct nodo_abb *raiz_aux = crear_nodo(arbol->nodo_raiz->elemento);
-	raiz_aux->derecha = arbol->nodo_raiz;
-	quitar_hijo_con_un_hijo(raiz_aux, arbol->nodo_raiz, 1);
-	arbol->nodo_raiz = raiz_aux->derecha;
-	free(raiz_aux);
+	if (inicio >= fin)
+		return NULL;
+	size_t medio = inicio + (fin - inicio) / 2;
+	struct nodo_abb *nodo = nodo_en(arbol, nodos, medio);
+	nodo->elemento = elementos[medio];
+	if (arbol->extractor)
+		*nodo_clave(nodo) = arbol->extractor(nodo->elemento);
+	nodo->izquierda = armar_sub_arbol_ordenado(arbol, nodos, elementos,
+						   inicio, medio);
+	nodo->derecha = armar_sub_arbol_ordenado(arbol, nodos, elementos,
+						 medio + 1, fin);
+	nodo_actualizar(arbol, nodo);
+	return nodo;
 }
 
 /**
- * Recibe un puntero a un struct abb, un void pointer a un elemento, y la
- * un entero (1 o 2), que indica la cantidad de hijos de la raíz del arbol, 
- * quita la raíz, reduce el tamaño del árbol y devuelve el elemento pasado
- * por parámetro (el de la raíz eliminada).
+ * Recibe un arbol balanceado vacío (o NULL) y n elementos ordenados, y arma
+ * con ellos el arbol en O(n), con altura mínima y todos los nodos en un único
+ * bloque del pool. Si no puede, destruye el arbol.
+ * Devuelve el arbol, o NULL en caso de error.
 */
-void *quitar_raiz_con_hijos(abb_t *arbol, void *elemento, int cant_hijos)
+abb_t *llenar_desde_ordenado(abb_t *arbol, void **elementos, size_t n)
 {
-	if (cant_hijos == 1) {
-		quitar_raiz_con_un_hijo(arbol);
-	} else {
-		quitar_hijo_con_dos_hijos(arbol->nodo_raiz);
+	if (!arbol || n == 0)
+		return arbol;
+	struct nodo_abb *nodos = abb_pool_obtener_contiguos(arbol->pool, n);
+	if (!nodos) {
+		abb_destruir(arbol);
+		return NULL;
 	}
-	arbol->tamanio--;
-	return elemento;
+	ABB_CONTAR(arbol, nodos_reservados, n);
+	arbol->nodo_raiz =
+		armar_sub_arbol_ordenado(arbol, nodos, elementos, 0, n);
+	arbol->tamanio = n;
+	return arbol;
 }
 
 /**
- * Busca en el arbol un elemento igual al provisto (utilizando la funcion de
- * comparación) y si lo encuentra lo quita del arbol y lo devuelve.
- * Devuelve el elemento extraido del árbol o NULL en caso de error.
+ * Crea un arbol balanceado (ver abb_crear_balanceado) con los n elementos del
+ * array, que deben estar ordenados de menor a mayor según el comparador. El
+ * arbol se arma en O(n) con altura mínima, y todos sus nodos se reservan en
+ * un único bloque de memoria.
+ *
+ * Devuelve un puntero al arbol creado o NULL en caso de error.
  */
-void *abb_quitar(abb_t *arbol, void *elemento)
+abb_t *abb_crear_desde_ordenado(abb_comparador comparador, void **elementos,
+				size_t n)
 {
-	if (!arbol || abb_tamanio(arbol) == 0)
+	if (!elementos && n > 0)
 		return NULL;
-	if (arbol->comparador(arbol->nodo_raiz->elemento, elemento) == 0) {
-		if (nodo_cantidad_hijos(arbol->nodo_raiz) == 0)
-			return quitar_unico_elemento(arbol, elemento);
-		else
-			return quitar_raiz_con_hijos(
-				arbol, elemento,
-				nodo_cantidad_hijos(arbol->nodo_raiz));
+	return llenar_desde_ordenado(abb_crear_balanceado(comparador), elementos,
+				     n);
+}
+
+/**
+ * Recibe un array de elementos, un array auxiliar del mismo tamaño n y un
+ * abb_comparador, y ordena los elementos de menor a mayor con merge sort
+ * iterativo (de abajo hacia arriba), que es estable y no usa recursión.
+*/
+void ordenar_elementos(void **elementos, void **auxiliar, size_t n,
+		       abb_comparador comparador)
+{
+	void **origen = elementos, **destino = auxiliar;
+	for (size_t ancho = 1; ancho < n; ancho *= 2) {
+		for (size_t inicio = 0; inicio < n; inicio += 2 * ancho) {
+			size_t medio = inicio + ancho < n ? inicio + ancho : n;
+			size_t fin = medio + ancho < n ? medio + ancho : n;
+			size_t i = inicio, j = medio, k = inicio;
+			while (i < medio && j < fin) {
+				if (comparador(origen[i], origen[j]) <= 0)
+					destino[k++] = origen[i++];
+				else
+					destino[k++] = origen[j++];
+			}
+			while (i < medio)
+				destino[k++] = origen[i++];
+			while (j < fin)
+				destino[k++] = origen[j++];
+		}
+		void **intercambio = origen;
+		origen = destino;
+		destino = intercambio;
+	}
+	if (origen != elementos) {
+		for (size_t i = 0; i < n; i++)
+			elementos[i] = origen[i];
 	}
-	return abb_quitar_recu(arbol, arbol->nodo_raiz, elemento,
-			       arbol->comparador);
 }
 
 /**
- * Recibe un struct nodo_abb, un void pointer a un elemento que se quiere 
- * buscar en el arbol y un abb_comparador.
- * Recorre recursivamente los hijos del nodo pasado por parámetro buscando
- * el elemento pasado, si lo encuentra lo devuelve, y si no devuelve NULL.
+ * Igual que abb_crear_desde_ordenado, pero los elementos del array pueden
+ * estar en cualquier orden: primero se ordena una copia del array (el array
+ * recibido no se modifica), en O(n log n).
+ *
+ * Devuelve un puntero al arbol creado o NULL en caso de error.
+ */
+abb_t *abb_crear_desde_desordenado(abb_comparador comparador,
+				   void **elementos, size_t n)
+{
+	if (!comparador || (!elementos && n > 0))
+		return NULL;
+	if (n == 0)
+		return abb_crear_balanceado(comparador);
+	if (n > SIZE_MAX / (2 * sizeof(void *)))
+		return NULL;
+	void **copia = malloc(2 * n * sizeof(void *));
+	if (!copia)
+		return NULL;
+	for (size_t i = 0; i < n; i++)
+		copia[i] = elementos[i];
+	ordenar_elementos(copia, copia + n, n, comparador);
+	abb_t *arbol = abb_crear_desde_ordenado(comparador, copia, n);
+	free(copia);
+	return arbol;
+}
+
+/**
+ * Las operaciones que combinan dos arboles ordenados.
+*/
+enum operacion_conjuntos { UNION, INTERSECCION, DIFERENCIA };
+
+/**
+ * Recibe dos arrays ordenados a y b con sus tamaños, un abb_comparador, una
+ * operación y un array de salida con lugar para n + m elementos. Recorre los
+ * dos arrays a la vez (como el merge de merge sort) y copia a la salida, en
+ * orden, los elementos que pide la operación. Cuando un elemento de a es
+ * igual a uno de b se copia el de a. Devuelve la cantidad copiada.
 */
-void *abb_buscar_recu(struct nodo_abb *nodo_actual, void *elemento,
-		      abb_comparador comparador)
+size_t combinar_ordenados(void **a, size_t n, void **b, size_t m,
+			  abb_comparador comparador,
+			  enum operacion_conjuntos operacion, void **salida)
 {
-	if (!nodo_actual)
+	size_t i = 0, j = 0, k = 0;
+	while (i < n && j < m) {
+		int comparacion = comparador(a[i], b[j]);
+		if (comparacion < 0) {
+			if (operacion != INTERSECCION)
+				salida[k++] = a[i];
+			i++;
+		} else if (comparacion > 0) {
+			if (operacion == UNION)
+				salida[k++] = b[j];
+			j++;
+		} else {
+			if (operacion != DIFERENCIA)
+				salida[k++] = a[i];
+			i++;
+			j++;
+		}
+	}
+	for (; i < n && operacion != INTERSECCION; i++)
+		salida[k++] = a[i];
+	for (; j < m && operacion == UNION; j++)
+		salida[k++] = b[j];
+	return k;
+}
+
+/**
+ * Recibe dos arboles y una operación, y devuelve un arbol balanceado nuevo
+ * con el resultado, armado con abb_crear_desde_ordenado. Los elementos de
+ * los dos arboles se copian en orden a un array, se combinan en otro y recién
+ * ahí se reservan los nodos, exactamente los que necesita el resultado.
+ * Devuelve NULL en caso de error.
+*/
+abb_t *combinar_arboles(abb_t *a, abb_t *b, enum operacion_conjuntos operacion)
+{
+	if (!a || !b || a->multiconjunto || b->multiconjunto)
 		return NULL;
-	else if (comparador(nodo_actual->elemento, elemento) == 0)
-		return nodo_actual->elemento;
-	else if (comparador(nodo_actual->elemento, elemento) < 0)
-		return abb_buscar_recu(nodo_actual->derecha, elemento,
-				       comparador);
-	else
-		return abb_buscar_recu(nodo_actual->izquierda, elemento,
-				       comparador);
+	size_t n = a->tamanio, m = b->tamanio;
+	if (n + m < n || n + m > SIZE_MAX / (2 * sizeof(void *)))
+		return NULL;
+	void **elementos = malloc(2 * (n + m) * sizeof(void *));
+	if (!elementos && n + m > 0)
+		return NULL;
+	abb_recorrer(a, INORDEN, elementos, n);
+	abb_recorrer(b, INORDEN, elementos + n, m);
+	void **salida = elementos + n + m;
+	size_t cantidad = combinar_ordenados(elementos, n, elementos + n, m,
+					     a->comparador, operacion, salida);
+	abb_t *resultado = llenar_desde_ordenado(
+		a->extractor ? abb_crear_con_clave(a->comparador, a->extractor) :
+			       abb_crear_balanceado(a->comparador),
+		salida, cantidad);
+	free(elementos);
+	return resultado;
 }
 
 /**
- * Busca en el arbol un elemento igual al provisto (utilizando la
- * funcion de comparación).
+ * Crea un arbol balanceado (ver abb_crear_balanceado) con los elementos que
+ * están en a, en b o en los dos. Si un elemento de a es igual a uno de b
+ * (según el comparador de a), queda solo el de a. Los dos arboles tienen que
+ * ordenar con el mismo criterio y no se modifican.
  *
- * Devuelve el elemento encontrado o NULL si no lo encuentra.
+ * Los elementos de cada arbol se recorren en orden a la vez, así que tarda
+ * O(n + m), y se reservan solo los nodos del resultado. Si a tiene extractor
+ * de clave, el resultado también.
+ *
+ * Devuelve un puntero al arbol creado o NULL en caso de error.
  */
-void *abb_buscar(abb_t *arbol, void *elemento)
+abb_t *abb_union(abb_t *a, abb_t *b)
 {
-	if (!arbol)
-		return NULL;
-	return abb_buscar_recu(arbol->nodo_raiz, elemento, arbol->comparador);
+	return combinar_arboles(a, b, UNION);
 }
 
 /**
- * Determina si el árbol está vacío.
+ * Igual que abb_union, pero con los elementos de a que son iguales a alguno
+ * de b.
  *
- * Devuelve true si está vacío o el arbol es NULL, false si el árbol tiene al
- * menos un elemento.
+ * Devuelve un puntero al arbol creado o NULL en caso de error.
  */
-bool abb_vacio(abb_t *arbol)
+abb_t *abb_interseccion(abb_t *a, abb_t *b)
 {
-	return !arbol || arbol->tamanio == 0;
+	return combinar_arboles(a, b, INTERSECCION);
 }
 
 /**
- * Devuelve la cantidad de elementos almacenados en el arbol o 0 si el arbol es
- * NULL.
+ * Igual que abb_union, pero con los elementos de a que no son iguales a
+ * ninguno de b.
+ *
+ * Devuelve un puntero al arbol creado o NULL en caso de error.
  */
-size_t abb_tamanio(abb_t *arbol)
+abb_t *abb_diferencia(abb_t *a, abb_t *b)
 {
-	if (!arbol)
-		return 0;
-	return arbol->tamanio;
+	return combinar_arboles(a, b, DIFERENCIA);
 }
 
 /**
- * Recibe un struct nodo_abb y un puntero a una funcion que recibe un void
- * pointer, la cual se invoca con cada elemento de los hijos del nodo pasado, 
- * y luego libera cada uno de los nodos.
+ * Recibe un puntero a struct abb, dos sub-árboles AVL del mismo y un nodo
+ * suelto cuyo elemento es mayor o igual a todos los de izquierda y menor o
+ * igual a todos los de derecha, y los une en un único AVL. Baja por el borde
+ * del sub-árbol más alto hasta encontrar uno de la altura del otro (o uno más),
+ * cuelga ahí el nodo con los dos, y rebalancea al volver. Tarda O(diferencia de
+ * alturas).
+ * Devuelve la raíz del AVL resultante.
 */
-void abb_destruir_nodos(struct nodo_abb *nodo_actual,
-			void (*destructor)(void *))
+struct nodo_abb *unir_avl(abb_t *arbol, struct nodo_abb *izquierda,
+			  struct nodo_abb *nodo, struct nodo_abb *derecha)
 {
-	if (!nodo_actual) {
-		return;
+	size_t altura_izquierda = nodo_altura(izquierda);
+	size_t altura_derecha = nodo_altura(derecha);
+	if (altura_izquierda > altura_derecha + 1) {
+		izquierda->derecha =
+			unir_avl(arbol, izquierda->derecha, nodo, derecha);
+		return balancear_nodo(arbol, izquierda);
 	}
-	abb_destruir_nodos(nodo_actual->izquierda, destructor);
-	abb_destruir_nodos(nodo_actual->derecha, destructor);
-	if (destructor && destructor != free) {
-		/**
-		 * Pongo destructor != free porque si no me tira invalid free
-		 * en mis pruebas, ṕorque creo los elementos del abb en el
-		 * stack.
-		*/
-		destructor(nodo_actual->elemento);
+	if (altura_derecha > altura_izquierda + 1) {
+		derecha->izquierda =
+			unir_avl(arbol, izquierda, nodo, derecha->izquierda);
+		return balancear_nodo(arbol, derecha);
 	}
-	free(nodo_actual);
+	nodo->izquierda = izquierda;
+	nodo->derecha = derecha;
+	nodo_actualizar(arbol, nodo);
+	return nodo;
 }
 
 /**
- * Destruye el arbol liberando la memoria reservada por el mismo.
- */
-void abb_destruir(struct abb *arbol)
+ * Recibe un puntero a struct abb balanceado, un nodo, y un elemento con su
+ * clave, y separa el sub-árbol del nodo en dos AVL: el de los elementos
+ * menores al recibido, que guarda en menores, y el del resto, que guarda en
+ * mayores. Cada nodo del camino se une con unir_avl a la parte que le
+ * corresponde, y como las alturas de las partes crecen a lo largo del camino,
+ * en total tarda O(log n).
+*/
+void dividir_avl(abb_t *arbol, struct nodo_abb *nodo, void *elemento,
+		 uint64_t clave, struct nodo_abb **menores,
+		 struct nodo_abb **mayores)
 {
-	if (!arbol) {
+	if (!nodo) {
+		*menores = NULL;
+		*mayores = NULL;
 		return;
 	}
-	abb_destruir_nodos(arbol->nodo_raiz, NULL);
-	free(arbol);
+	struct nodo_abb *izquierda = nodo->izquierda, *derecha = nodo->derecha;
+	if (comparar_con_nodo(arbol, nodo, elemento, clave) < 0) {
+		dividir_avl(arbol, derecha, elemento, clave, menores, mayores);
+		*menores = unir_avl(arbol, izquierda, nodo, *menores);
+	} else {
+		dividir_avl(arbol, izquierda, elemento, clave, menores, mayores);
+		*mayores = unir_avl(arbol, *mayores, nodo, derecha);
+	}
 }
 
 /**
- * Destruye el arbol liberando la memoria reservada por el mismo.
- *
+ * Igual que dividir_avl, pero para un arbol no balanceado, que puede ser
+ * muy alto: separa sin recursión, colgando cada nodo del camino del último
+ * nodo de su parte. Como no puede recalcular las cantidades al volver, antes
+ * baja una vez para contar los elementos menores, y con eso calcula la
+ * cantidad nueva de cada nodo del camino al bajar por segunda vez.
+*/
+void dividir_sin_balancear(abb_t *arbol, void *elemento,
+			   struct nodo_abb **menores,
+			   struct nodo_abb **mayores)
+{
+	size_t cantidad_menores = 0;
+	for (struct nodo_abb *nodo = arbol->nodo_raiz; nodo;) {
+		if (comparar(arbol, nodo->elemento, elemento) < 0) {
+			cantidad_menores += nodo_cantidad(nodo->izquierda) + 1;
+			nodo = nodo->derecha;
+		} else {
+			nodo = nodo->izquierda;
+		}
+	}
+	struct nodo_abb *nodo = arbol->nodo_raiz;
+	*menores = NULL;
+	*mayores = NULL;
+	while (nodo) {
+		if (comparar(arbol, nodo->elemento, elemento) < 0) {
+			*menores = nodo;
+			menores = &nodo->derecha;
+			nodo->cantidad = cantidad_menores;
+			cantidad_menores -= nodo_cantidad(nodo->izquierda) + 1;
+			nodo = nodo->derecha;
+		} else {
+			*mayores = nodo;
+			mayores = &nodo->izquierda;
+			nodo->cantidad -= cantidad_menores;
+			nodo = nodo->izquierda;
+		}
+	}
+	*menores = NULL;
+	*mayores = NULL;
+}
+
+/**
+ * Separa el arbol en dos: menores, con los elementos menores al pivote, y
+ * mayores, con el resto. No reserva nodos ni copia elementos: los nodos del
+ * arbol se reparten entre los dos, que comparten su pool, y el arbol recibido
+ * pasa a ser menores (no hay que destruirlo aparte). Hay que destruir los dos
+ * resultados.
+ *
+ * Como el pool compartido no es seguro para varios hilos, los dos resultados
+ * no se pueden modificar (insertar, quitar o unir) a la vez desde hilos
+ * distintos; sí se pueden leer a la vez y destruir desde cualquier hilo. Para
+ * repartirlos entre hilos que los modifiquen, se puede copiar uno a un arbol
+ * con su propio pool, por ejemplo con abb_union con un arbol vacío.
+ *
+ * En un arbol balanceado tarda O(log n) y los dos resultados quedan
+ * balanceados; en uno que no lo es tarda O(altura). No funciona con arboles
+ * multiclave.
+ *
+ * Devuelve true si se pudo dividir, o false (sin modificar el arbol) en caso
+ * de error.
+ */
+bool abb_dividir(abb_t *arbol, void *pivote, abb_t **menores,
+		 abb_t **mayores)
+{
+	if (!arbol || arbol->multiclave || arbol->mapeado ||
+	    arbol->multiconjunto || !menores || !mayores)
+		return false;
+	abb_t *otro = calloc(1, sizeof(struct abb));
+	if (!otro)
+		return false;
+	*otro = *arbol;
+	otro->pool = abb_pool_compartir(arbol->pool);
+#ifdef ABB_CONTADORES
+	memset(&otro->contadores, 0, sizeof(otro->contadores));
+#endif
+	struct nodo_abb *raiz_menores, *raiz_mayores;
+	if (arbol->balanceado)
+		dividir_avl(arbol, arbol->nodo_raiz, pivote,
+			    clave_de(arbol, pivote), &raiz_menores,
+			    &raiz_mayores);
+	else
+		dividir_sin_balancear(arbol, pivote, &raiz_menores,
+				      &raiz_mayores);
+	arbol->nodo_raiz = raiz_menores;
+	arbol->tamanio = nodo_cantidad(raiz_menores);
+	otro->nodo_raiz = raiz_mayores;
+	otro->tamanio = nodo_cantidad(raiz_mayores);
+	*menores = arbol;
+	*mayores = otro;
+	return true;
+}
+
+/**
+ * Recibe dos arboles y pasa los elementos de b a nodos nuevos del pool de a,
+ * con los que arma un sub-árbol de altura mínima que reemplaza la raíz de b.
+ * Los nodos viejos quedan en el pool de b. Devuelve false en caso de error,
+ * sin modificar nada.
+*/
+bool copiar_nodos(abb_t *a, abb_t *b)
+{
+	if (b->tamanio == 0)
+		return true;
+	if (b->tamanio > SIZE_MAX / sizeof(void *))
+		return false;
+	void **elementos = malloc(b->tamanio * sizeof(void *));
+	if (!elementos)
+		return false;
+	struct nodo_abb *nodos =
+		abb_pool_obtener_contiguos(a->pool, b->tamanio);
+	if (!nodos) {
+		free(elementos);
+		return false;
+	}
+	ABB_CONTAR(b, nodos_reservados, b->tamanio);
+	ABB_CONTAR(b, nodos_liberados, b->tamanio);
+	abb_recorrer(b, INORDEN, elementos, b->tamanio);
+	b->nodo_raiz =
+		armar_sub_arbol_ordenado(b, nodos, elementos, 0, b->tamanio);
+	b->altura_maxima = nodo_altura(b->nodo_raiz);
+	free(elementos);
+	return true;
+}
+
+/**
+ * Recibe dos arboles y deja los nodos de b en el pool de a (que puede pasar
+ * a ser el de b), para que a pueda usarlos. Si cada pool es de un solo arbol,
+ * o los dos son el mismo, tarda O(1); si los dos están compartidos con otros
+ * arboles, copia los elementos de b a nodos del pool de a en O(m).
+ * Devuelve false, sin modificar nada, en caso de error.
+*/
+bool juntar_pools(abb_t *a, abb_t *b)
+{
+	if (a->pool == b->pool) {
+		abb_pool_destruir(b->pool);
+		return true;
+	}
+	if (abb_pool_absorber(a->pool, b->pool))
+		return true;
+	if (abb_pool_absorber(b->pool, a->pool)) {
+		a->pool = b->pool;
+		return true;
+	}
+	if (!copiar_nodos(a, b))
+		return false;
+	abb_pool_destruir(b->pool);
+	return true;
+}
+
+/**
+ * Recibe un puntero a struct abb y un nodo AVL no NULL del mismo, y separa de
+ * su sub-árbol el nodo con el mayor elemento, que guarda en maximo,
+ * rebalanceando el camino.
+ * Devuelve la raíz del sub-árbol que queda.
+*/
+struct nodo_abb *separar_maximo(abb_t *arbol, struct nodo_abb *nodo,
+				struct nodo_abb **maximo)
+{
+	if (!nodo->derecha) {
+		*maximo = nodo;
+		return nodo->izquierda;
+	}
+	nodo->derecha = separar_maximo(arbol, nodo->derecha, maximo);
+	return balancear_nodo(arbol, nodo);
+}
+
+/**
+ * Recibe dos punteros a struct abb y le suma a los contadores de a los de b.
+*/
+void sumar_contadores(abb_t *a, abb_t *b)
+{
+#ifdef ABB_CONTADORES
+	ABB_CONTAR(a, comparaciones, b->contadores.comparaciones);
+	ABB_CONTAR(a, nodos_reservados, b->contadores.nodos_reservados);
+	ABB_CONTAR(a, nodos_liberados, b->contadores.nodos_liberados);
+	ABB_CONTAR(a, rebalanceos, b->contadores.rebalanceos);
+#else
+	(void)a;
+	(void)b;
+#endif
+}
+
+/**
+ * Une dos arboles creados de la misma forma (con el mismo comparador, y los
+ * dos balanceados o los dos sin balancear), donde todos los elementos de a
+ * son menores o iguales a todos los de b. Reutiliza los nodos de los dos
+ * arboles: el resultado es a, y b deja de existir (no hay que destruirlo).
+ *
+ * Si los dos son balanceados tarda O(log n + log m), y si no, O(altura de
+ * a). Si los dos arboles comparten su pool con otros (por haber salido de
+ * abb_dividir sin que se destruyera la otra parte), los elementos de b se
+ * pasan a nodos nuevos, en O(m). No funciona con arboles multiclave.
+ *
+ * Devuelve a, o NULL (sin modificar ninguno de los dos) en caso de error o
+ * si algún elemento de a es mayor a alguno de b.
+ */
+abb_t *abb_unir(abb_t *a, abb_t *b)
+{
+	if (!a || !b || a == b || a->multiclave || b->multiclave ||
+	    a->mapeado || b->mapeado || a->multiconjunto || b->multiconjunto ||
+	    a->balanceado != b->balanceado || a->comparador != b->comparador ||
+	    a->extractor != b->extractor)
+		return NULL;
+	if (a->nodo_raiz && b->nodo_raiz) {
+		struct nodo_abb *maximo = a->nodo_raiz, *minimo = b->nodo_raiz;
+		while (maximo->derecha)
+			maximo = maximo->derecha;
+		while (minimo->izquierda)
+			minimo = minimo->izquierda;
+		if (comparar(a, maximo->elemento, minimo->elemento) > 0)
+			return NULL;
+	}
+	if (!juntar_pools(a, b))
+		return NULL;
+
+	if (!a->nodo_raiz) {
+		a->nodo_raiz = b->nodo_raiz;
+		a->altura_maxima = b->altura_maxima;
+	} else if (b->nodo_raiz && a->balanceado) {
+		struct nodo_abb *maximo;
+		struct nodo_abb *resto =
+			separar_maximo(a, a->nodo_raiz, &maximo);
+		a->nodo_raiz = unir_avl(a, resto, maximo, b->nodo_raiz);
+	} else if (b->nodo_raiz) {
+		/**
+		 * Sin balancear alcanza con colgar b a la derecha del máximo de
+		 * a, que queda a lo sumo a altura_maxima de profundidad.
+		*/
+		struct nodo_abb *nodo = a->nodo_raiz;
+		for (; nodo->derecha; nodo = nodo->derecha)
+			nodo->cantidad += b->tamanio;
+		nodo->cantidad += b->tamanio;
+		nodo->derecha = b->nodo_raiz;
+		a->altura_maxima += b->altura_maxima;
+	}
+	a->tamanio += b->tamanio;
+	sumar_contadores(a, b);
+	free(b);
+	return a;
+}
+
+/**
+ * Recibe un puntero a struct abb, un doble puntero a un struct nodo_abb y un
+ * nodo nuevo, baja iterativamente por los hijos del nodo pasado por
+ * parámetro hasta encontrar un lugar libre e inserta ahí el nodo nuevo de
+ * manera ordenada.
+ * Devuelve la profundidad en la que quedó el nodo nuevo (1 si es la raíz).
+*/
+size_t abb_insertar_iter(abb_t *arbol, struct nodo_abb **nodo_actual,
+			 struct nodo_abb *nuevo_nodo)
+{
+	size_t profundidad = 1;
+	while (*nodo_actual) {
+		(*nodo_actual)->cantidad++;
+		if (comparar(arbol, (*nodo_actual)->elemento,
+			     nuevo_nodo->elemento) >= 0)
+			nodo_actual = &((*nodo_actual)->izquierda);
+		else
+			nodo_actual = &((*nodo_actual)->derecha);
+		profundidad++;
+	}
+	*nodo_actual = nuevo_nodo;
+	return profundidad;
+}
+
+/**
+ * Recibe un puntero a struct abb, un puntero a un struct nodo_abb raíz de un
+ * sub-árbol balanceado, un nodo nuevo y su clave (ver comparar_con_nodo).
+ * Inserta el nodo nuevo de manera ordenada y rebalancea los nodos del camino
+ * recorrido a medida que vuelve la recursión.
+ * Devuelve un puntero a la nueva raíz del sub-árbol.
+*/
+struct nodo_abb *abb_insertar_balanceado(abb_t *arbol,
+					 struct nodo_abb *nodo_actual,
+					 struct nodo_abb *nuevo_nodo,
+					 uint64_t clave)
+{
+	if (!nodo_actual)
+		return nuevo_nodo;
+	if (comparar_con_nodo(arbol, nodo_actual, nuevo_nodo->elemento,
+			      clave) >= 0)
+		nodo_actual->izquierda = abb_insertar_balanceado(
+			arbol, nodo_actual->izquierda, nuevo_nodo, clave);
+	else
+		nodo_actual->derecha = abb_insertar_balanceado(
+			arbol, nodo_actual->derecha, nuevo_nodo, clave);
+	return balancear_nodo(arbol, nodo_actual);
+}
+
+/**
+ * Recibe un puntero a struct abb, un void pointer a un elemento y su clave
+ * (ver comparar_con_nodo), y devuelve el primer nodo del camino de búsqueda
+ * cuyo elemento es igual al recibido, o NULL si no hay ninguno.
+*/
+struct nodo_abb *buscar_nodo(abb_t *arbol, void *elemento, uint64_t clave)
+{
+	struct nodo_abb *nodo_actual = arbol->nodo_raiz;
+	while (nodo_actual) {
+		int comparacion =
+			comparar_con_nodo(arbol, nodo_actual, elemento, clave);
+		if (comparacion == 0)
+			return nodo_actual;
+		if (comparacion < 0)
+			nodo_actual = nodo_actual->derecha;
+		else
+			nodo_actual = nodo_actual->izquierda;
+	}
+	return NULL;
+}
+
+/**
+ * Recibe un puntero a un struct nodo_abb de un multiconjunto y un void
+ * pointer a un elemento igual al suyo, y lo agrega al final de sus copias
+ * repetidas, duplicando el array cuando se llena.
+ * Devuelve false (sin modificar el nodo) si no hay memoria.
+*/
+bool agregar_repetido(struct nodo_abb *nodo, void *elemento)
+{
+	struct repetidos *repetidos = *nodo_repetidos(nodo);
+	if (!repetidos || repetidos->cantidad == repetidos->capacidad) {
+		size_t capacidad = repetidos ? 2 * repetidos->capacidad : 4;
+		repetidos = realloc(repetidos,
+				    sizeof(struct repetidos) +
+					    capacidad * sizeof(void *));
+		if (!repetidos)
+			return false;
+		if (!*nodo_repetidos(nodo))
+			repetidos->cantidad = 0;
+		repetidos->capacidad = capacidad;
+		*nodo_repetidos(nodo) = repetidos;
+	}
+	repetidos->elementos[repetidos->cantidad++] = elemento;
+	return true;
+}
+
+/**
+ * Recibe un puntero a struct abb multiconjunto, uno de sus nodos, un void
+ * pointer a un elemento igual al del nodo y su clave, y un cambio (1 o -1).
+ * Baja desde la raíz hasta el nodo y suma el cambio a la cantidad de cada
+ * nodo del camino (incluido el recibido), que cambió de copias.
+*/
+void sumar_al_camino(abb_t *arbol, struct nodo_abb *destino, void *elemento,
+		     uint64_t clave, int cambio)
+{
+	struct nodo_abb *nodo_actual = arbol->nodo_raiz;
+	while (nodo_actual != destino) {
+		nodo_actual->cantidad += (size_t)cambio;
+		if (comparar_con_nodo(arbol, nodo_actual, elemento, clave) < 0)
+			nodo_actual = nodo_actual->derecha;
+		else
+			nodo_actual = nodo_actual->izquierda;
+	}
+	destino->cantidad += (size_t)cambio;
+}
+
+/**
+ * Inserta un elemento en el arbol.
+ * El arbol admite elementos con valores repetidos.
+ *
+ * Devuelve el arbol en caso de exito o NULL en caso de error.
+ */
+abb_t *abb_insertar(abb_t *arbol, void *elemento)
+{
+	if (!arbol || arbol->mapeado)
+		return NULL;
+	if (arbol->multiclave)
+		return multiclave_insertar(arbol, elemento);
+	if (arbol->multiconjunto) {
+		uint64_t clave = clave_de(arbol, elemento);
+		struct nodo_abb *igual = buscar_nodo(arbol, elemento, clave);
+		if (igual) {
+			if (!agregar_repetido(igual, elemento))
+				return NULL;
+			sumar_al_camino(arbol, igual, elemento, clave, 1);
+			arbol->tamanio++;
+			return arbol;
+		}
+	}
+	struct nodo_abb *nuevo_nodo = crear_nodo(arbol, elemento);
+	if (!nuevo_nodo)
+		return NULL;
+	if (arbol->balanceado)
+		arbol->nodo_raiz = abb_insertar_balanceado(
+			arbol, arbol->nodo_raiz, nuevo_nodo,
+			arbol->extractor ? *nodo_clave(nuevo_nodo) : 0);
+	else {
+		size_t profundidad = abb_insertar_iter(
+			arbol, &(arbol->nodo_raiz), nuevo_nodo);
+		if (profundidad > arbol->altura_maxima)
+			arbol->altura_maxima = profundidad;
+	}
+	arbol->tamanio++;
+	return arbol;
+}
+
+/**
+ * Recibe un puntero a un struct nodo_abb y devuelve cuantos hijos 
+ * tiene ese nodo.
+*/
+int nodo_cantidad_hijos(struct nodo_abb *nodo)
+{
+	if (nodo->derecha && nodo->izquierda)
+		return 2;
+	if (nodo->derecha || nodo->izquierda)
+		return 1;
+	return 0;
+}
+
+/**
+ * Recibe un struct nodo_abb y un entero (0 o 1).
+ * Si el entero es 0, crea un puntero al hijo izquierdo del nodo pasado por
+ * parámetro, o al derecho si es 1.
+*/
+struct nodo_abb *crear_nodo_a_quitar(struct nodo_abb *nodo_padre, int posicion)
+{
+	struct nodo_abb *nodo_a_quitar = NULL;
+	if (posicion == 0)
+		nodo_a_quitar = nodo_padre->izquierda;
+	else
+		nodo_a_quitar = nodo_padre->derecha;
+	return nodo_a_quitar;
+}
+
+/**
+ * Recibe un puntero a struct abb, dos punteros a struct nodo_abb, donde uno es
+ * el hijo del otro, y a su vez no tiene ningún hijo, y un entero (0 o 1), que
+ * indica si este nodo es el hijo izquierdo (0) o el derecho (1).
+ * Libera el hijo y hace que el padre apunte a NULL en esa posición.
+*/
+void quitar_hijo_sin_hijos(abb_t *arbol, struct nodo_abb *nodo_padre,
+			   struct nodo_abb *nodo_a_quitar, int posicion)
+{
+	if (posicion == 0)
+		nodo_padre->izquierda = NULL;
+	else
+		nodo_padre->derecha = NULL;
+	liberar_nodo(arbol, nodo_a_quitar);
+}
+
+/**
+ * Recibe un puntero a struct abb, dos punteros a struct nodo_abb, donde uno es
+ * el hijo del otro, y a su vez tiene un solo hijo, y un entero (0 o 1), que
+ * indica si este nodo es el hijo izquierdo (0) o el derecho (1).
+ * Hace que el padre apunte al unico hijo del nodo pasado por parámetro, y
+ * libera este nodo.
+*/
+void quitar_hijo_con_un_hijo(abb_t *arbol, struct nodo_abb *nodo_padre,
+			     struct nodo_abb *nodo_a_quitar, int posicion)
+{
+	if (posicion == 0) {
+		if (nodo_a_quitar->derecha)
+			nodo_padre->izquierda = nodo_a_quitar->derecha;
+		else
+			nodo_padre->izquierda = nodo_a_quitar->izquierda;
+	} else {
+		if (nodo_a_quitar->derecha)
+			nodo_padre->derecha = nodo_a_quitar->derecha;
+		else
+			nodo_padre->derecha = nodo_a_quitar->izquierda;
+	}
+	liberar_nodo(arbol, nodo_a_quitar);
+}
+
+/**
+ * Recibe un puntero a struct nodo_abb, y recorre iterativamente hacia la
+ * derecha, devolviendo un puntero al nodo cuyo hijo derecho no tiene hijo
+ * derecho. Es decir que devuelve un puntero al nodo padre del nodo predecesor
+ * inorden (el inmediatamente menor) al padre del nodo pasado por parámetro.
+*/
+struct nodo_abb *buscar_predecesor_inorden(struct nodo_abb *nodo_actual)
+{
+	while (nodo_actual->derecha->derecha)
+		nodo_actual = nodo_actual->derecha;
+	return nodo_actual;
+}
+
+/**
+ * Recibe un puntero a struct abb y uno a struct nodo_abb, quita el predecesor
+ * inorden de ese nodo (aquel que contiene el elemento inmediatamente menor al
+ * nodo pasado por parámetro), y devuelve el elemento del predecesor.
+*/
+void *quitar_predecesor_a_derecha(abb_t *arbol, struct nodo_abb *nodo_actual)
+{
+	struct nodo_abb *nodo_padre_del_predecesor =
+		buscar_predecesor_inorden(nodo_actual->izquierda);
+	struct nodo_abb *nodo_predecesor = nodo_padre_del_predecesor->derecha;
+	void *elemento_predecesor = nodo_predecesor->elemento;
+	for (struct nodo_abb *nodo = nodo_actual->izquierda;
+	     nodo != nodo_predecesor; nodo = nodo->derecha)
+		nodo->cantidad--;
+	if (nodo_cantidad_hijos(nodo_predecesor) == 0) {
+		quitar_hijo_sin_hijos(arbol, nodo_padre_del_predecesor,
+				      nodo_predecesor, 1);
+	} else {
+		quitar_hijo_con_un_hijo(arbol, nodo_padre_del_predecesor,
+					nodo_predecesor, 1);
+	}
+	return elemento_predecesor;
+}
+
+/**
+ * Recibe un puntero a struct abb y uno a struct nodo_abb, quita su hijo
+ * izquierdo, y devuelve el elemento de ese hijo.
+*/
+void *quitar_hijo_izquierda(abb_t *arbol, struct nodo_abb *nodo_actual)
+{
+	void *elemento_predecesor = nodo_actual->izquierda->elemento;
+	if (nodo_cantidad_hijos(nodo_actual->izquierda) == 0) {
+		quitar_hijo_sin_hijos(arbol, nodo_actual,
+				      nodo_actual->izquierda, 0);
+	} else {
+		quitar_hijo_con_un_hijo(arbol, nodo_actual,
+					nodo_actual->izquierda, 0);
+	}
+	return elemento_predecesor;
+}
+
+/**
+ * Recibe un puntero a struct abb y uno a struct nodo_abb que tiene dos hijos,
+ * quita el nodo predecesor inorden del pasado por parámetro (aquel que contiene
+ * el elemento inmediatamente menor), y copia el elemento predecesor en el nodo
+ * pasado por parámetro. Es decir que quita un nodo con dos hijos de un abb.
+*/
+void quitar_hijo_con_dos_hijos(abb_t *arbol, struct nodo_abb *nodo_a_quitar)
+{
+	void *elemento_predecesor = NULL;
+	nodo_a_quitar->cantidad--;
+	if (nodo_a_quitar->izquierda->derecha) {
+		elemento_predecesor =
+			quitar_predecesor_a_derecha(arbol, nodo_a_quitar);
+	} else {
+		elemento_predecesor =
+			quitar_hijo_izquierda(arbol, nodo_a_quitar);
+	}
+	nodo_a_quitar->elemento = elemento_predecesor;
+}
+
+/**
+ * Recibe un puntero a struct abb, un puntero a struct nodo_abb y un entero
+ * (0 o 1).
+ * Quita el hijo derecho (si el entero es 1) o el izquierdo (si es 0) del nodo
+ * pasado por parámetro, reduce el tamaño del arbol, y devuelve el elemento
+ * que tenía ese hijo.
+*/
+void *quitar_un_hijo(abb_t *arbol, struct nodo_abb *nodo_padre, int posicion)
+{
+	struct nodo_abb *nodo_a_quitar =
+		crear_nodo_a_quitar(nodo_padre, posicion);
+	void *elemento = nodo_a_quitar->elemento;
+	if (nodo_cantidad_hijos(nodo_a_quitar) == 0) {
+		quitar_hijo_sin_hijos(arbol, nodo_padre, nodo_a_quitar,
+				      posicion);
+	} else if (nodo_cantidad_hijos(nodo_a_quitar) == 1) {
+		quitar_hijo_con_un_hijo(arbol, nodo_padre, nodo_a_quitar,
+					posicion);
+	} else {
+		quitar_hijo_con_dos_hijos(arbol, nodo_a_quitar);
+	}
+	arbol->tamanio--;
+	return elemento;
+}
+
+/**
+ * Recibe un puntero a struct abb, un nodo del mismo y un void pointer a un
+ * elemento que no está en el sub-árbol del nodo. Baja desde el nodo siguiendo
+ * el mismo camino que la búsqueda del elemento, y le devuelve a la cantidad
+ * de cada nodo del camino el uno que le descontó abb_quitar_iter.
+*/
+void restaurar_camino(abb_t *arbol, struct nodo_abb *nodo_actual,
+		      void *elemento)
+{
+	while (nodo_actual) {
+		nodo_actual->cantidad++;
+		if (comparar(arbol, nodo_actual->elemento, elemento) > 0)
+			nodo_actual = nodo_actual->izquierda;
+		else
+			nodo_actual = nodo_actual->derecha;
+	}
+}
+
+/**
+ * Recibe un puntero a struct abb, un puntero a struct nodo_abb y un void
+ * pointer a un elemento. Recorre el arbol iterativamente a partir del nodo
+ * pasado por parámetro hasta encontrar el nodo que contiene el elemento
+ * recibido, lo quita del árbol y devuelve su elemento.
+ *
+ * Mientras baja descuenta uno de la cantidad de cada nodo del camino, así no
+ * tiene que volver a bajar para actualizarlas; si el elemento no está, las
+ * restaura.
+*/
+void *abb_quitar_iter(abb_t *arbol, struct nodo_abb *nodo_actual,
+		      void *elemento)
+{
+	struct nodo_abb *inicio = nodo_actual;
+	while (nodo_actual) {
+		nodo_actual->cantidad--;
+		int posicion = -1;
+		if (nodo_actual->derecha &&
+		    comparar(arbol, nodo_actual->derecha->elemento,
+			     elemento) == 0)
+			posicion = 1;
+		else if (nodo_actual->izquierda &&
+			 comparar(arbol, nodo_actual->izquierda->elemento,
+				  elemento) == 0)
+			posicion = 0;
+		if (posicion >= 0)
+			return quitar_un_hijo(arbol, nodo_actual, posicion);
+		if (comparar(arbol, nodo_actual->elemento, elemento) > 0)
+			nodo_actual = nodo_actual->izquierda;
+		else
+			nodo_actual = nodo_actual->derecha;
+	}
+	restaurar_camino(arbol, inicio, elemento);
+	return NULL;
+}
+
+/**
+ * Recibe un puntero a un struct abb que contiene un único elemento. Quita el
+ * único elemento del árbol, reduce su tamaño y devuelve el elemento.
+*/
+void *quitar_unico_elemento(abb_t *arbol)
+{
+	void *elemento = arbol->nodo_raiz->elemento;
+	liberar_nodo(arbol, arbol->nodo_raiz);
+	arbol->nodo_raiz = NULL;
+	arbol->tamanio--;
+	return elemento;
+}
+
+/**
+ * Recibe un puntero a un struct abb cuya raíz tiene un solo hijo, y quita esa
+ * raíz, haciendo que su único hijo sea la nueva raiz.
+*/
+void quitar_raiz_con_un_hijo(abb_t *arbol)
+{
+	struct nodo_abb *raiz = arbol->nodo_raiz;
+	if (raiz->derecha)
+		arbol->nodo_raiz = raiz->derecha;
+	else
+		arbol->nodo_raiz = raiz->izquierda;
+	liberar_nodo(arbol, raiz);
+}
+
+/**
+ * Recibe un puntero a un struct abb y un entero (1 o 2), que indica la
+ * cantidad de hijos de la raíz del arbol, quita la raíz, reduce el tamaño del
+ * árbol y devuelve el elemento de la raíz eliminada.
+*/
+void *quitar_raiz_con_hijos(abb_t *arbol, int cant_hijos)
+{
+	void *elemento = arbol->nodo_raiz->elemento;
+	if (cant_hijos == 1) {
+		quitar_raiz_con_un_hijo(arbol);
+	} else {
+		quitar_hijo_con_dos_hijos(arbol, arbol->nodo_raiz);
+	}
+	arbol->tamanio--;
+	return elemento;
+}
+
+/**
+ * Recibe un puntero a struct abb, un puntero a un struct nodo_abb raíz de un
+ * sub-árbol balanceado que no está vacío y un nodo a reemplazar. Quita el
+ * nodo de mayor elemento del sub-árbol (el que no tiene hijo derecho) y pasa
+ * su elemento, su clave y sus copias repetidas al nodo a reemplazar,
+ * rebalanceando el camino.
+ * Devuelve un puntero a la nueva raíz del sub-árbol.
+*/
+struct nodo_abb *quitar_maximo_balanceado(abb_t *arbol,
+					  struct nodo_abb *nodo_actual,
+					  struct nodo_abb *reemplazado)
+{
+	if (!nodo_actual->derecha) {
+		struct nodo_abb *hijo_izquierdo = nodo_actual->izquierda;
+		reemplazado->elemento = nodo_actual->elemento;
+		if (arbol->extractor)
+			*nodo_clave(reemplazado) = *nodo_clave(nodo_actual);
+		if (arbol->multiconjunto)
+			*nodo_repetidos(reemplazado) =
+				*nodo_repetidos(nodo_actual);
+		liberar_nodo(arbol, nodo_actual);
+		return hijo_izquierdo;
+	}
+	nodo_actual->derecha = quitar_maximo_balanceado(
+		arbol, nodo_actual->derecha, reemplazado);
+	return balancear_nodo(arbol, nodo_actual);
+}
+
+/**
+ * Recibe un puntero a struct abb, un puntero a un struct nodo_abb raíz de un
+ * sub-árbol balanceado, un void pointer a un elemento y su clave (ver
+ * comparar_con_nodo). Busca el primer nodo cuyo elemento es igual al recibido y
+ * lo quita; si tiene dos hijos lo reemplaza con su predecesor inorden. El
+ * elemento quitado se guarda en el puntero recibido, y se rebalancea el camino
+ * a medida que vuelve la recursión.
+ * Devuelve un puntero a la nueva raíz del sub-árbol.
+*/
+struct nodo_abb *abb_quitar_balanceado(abb_t *arbol,
+				       struct nodo_abb *nodo_actual,
+				       void *elemento, uint64_t clave,
+				       void **elemento_quitado, bool *encontrado)
+{
+	if (!nodo_actual)
+		return NULL;
+	int comparacion = comparar_con_nodo(arbol, nodo_actual, elemento, clave);
+	if (comparacion > 0) {
+		nodo_actual->izquierda = abb_quitar_balanceado(
+			arbol, nodo_actual->izquierda, elemento, clave,
+			elemento_quitado, encontrado);
+	} else if (comparacion < 0) {
+		nodo_actual->derecha = abb_quitar_balanceado(
+			arbol, nodo_actual->derecha, elemento, clave,
+			elemento_quitado, encontrado);
+	} else {
+		*elemento_quitado = nodo_actual->elemento;
+		*encontrado = true;
+		if (nodo_cantidad_hijos(nodo_actual) < 2) {
+			struct nodo_abb *hijo = nodo_actual->izquierda ?
+							nodo_actual->izquierda :
+							nodo_actual->derecha;
+			liberar_nodo(arbol, nodo_actual);
+			return hijo;
+		}
+		nodo_actual->izquierda = quitar_maximo_balanceado(
+			arbol, nodo_actual->izquierda, nodo_actual);
+	}
+	return balancear_nodo(arbol, nodo_actual);
+}
+
+/**
+ * Recibe un puntero a struct abb multiconjunto, un void pointer a un elemento
+ * y su clave, y un nodo del arbol igual al elemento que tiene copias
+ * repetidas. Quita la última copia que se insertó (y libera el array si era
+ * la única) sin tocar la forma del arbol.
+ * Devuelve la copia quitada.
+*/
+void *quitar_repetido(abb_t *arbol, void *elemento, uint64_t clave,
+		      struct nodo_abb *nodo)
+{
+	struct repetidos **repetidos = nodo_repetidos(nodo);
+	void *quitado = (*repetidos)->elementos[--(*repetidos)->cantidad];
+	if ((*repetidos)->cantidad == 0) {
+		free(*repetidos);
+		*repetidos = NULL;
+	}
+	sumar_al_camino(arbol, nodo, elemento, clave, -1);
+	arbol->tamanio--;
+	return quitado;
+}
+
+/**
+ * Busca en el arbol un elemento igual al provisto (utilizando la funcion de
+ * comparación) y si lo encuentra lo quita del arbol y lo devuelve.
+ * Devuelve el elemento extraido del árbol o NULL en caso de error.
+ */
+void *abb_quitar(abb_t *arbol, void *elemento)
+{
+	if (!arbol || arbol->mapeado || abb_tamanio(arbol) == 0)
+		return NULL;
+	if (arbol->multiclave)
+		return multiclave_quitar(arbol, elemento);
+	if (arbol->multiconjunto) {
+		uint64_t clave = clave_de(arbol, elemento);
+		struct nodo_abb *igual = buscar_nodo(arbol, elemento, clave);
+		if (igual && *nodo_repetidos(igual))
+			return quitar_repetido(arbol, elemento, clave, igual);
+	}
+	if (arbol->balanceado) {
+		void *elemento_quitado = NULL;
+		bool encontrado = false;
+		arbol->nodo_raiz = abb_quitar_balanceado(
+			arbol, arbol->nodo_raiz, elemento,
+			clave_de(arbol, elemento), &elemento_quitado,
+			&encontrado);
+		if (encontrado)
+			arbol->tamanio--;
+		return elemento_quitado;
+	}
+	if (comparar(arbol, arbol->nodo_raiz->elemento, elemento) == 0) {
+		if (nodo_cantidad_hijos(arbol->nodo_raiz) == 0)
+			return quitar_unico_elemento(arbol);
+		else
+			return quitar_raiz_con_hijos(
+				arbol, nodo_cantidad_hijos(arbol->nodo_raiz));
+	}
+	return abb_quitar_iter(arbol, arbol->nodo_raiz, elemento);
+}
+
+/**
+ * Quita del arbol todos los elementos iguales al provisto, e invoca el
+ * destructor con cada uno (si no es NULL). En un multiconjunto quita el nodo
+ * con todas sus copias de una vez.
+ *
+ * Devuelve la cantidad de elementos quitados.
+ */
+size_t abb_quitar_todos(abb_t *arbol, void *elemento,
+			void (*destructor)(void *))
+{
+	if (!arbol)
+		return 0;
+	if (!arbol->multiconjunto) {
+		size_t cantidad = abb_contar(arbol, elemento);
+		for (size_t i = 0; i < cantidad; i++) {
+			void *quitado = abb_quitar(arbol, elemento);
+			if (destructor)
+				destructor(quitado);
+		}
+		return cantidad;
+	}
+	uint64_t clave = clave_de(arbol, elemento);
+	struct nodo_abb *igual = buscar_nodo(arbol, elemento, clave);
+	if (!igual)
+		return 0;
+	/**
+	 * Las copias se sacan del nodo antes de quitarlo, ya que si tiene dos
+	 * hijos se reutiliza para el predecesor, y se destruyen después, ya
+	 * que al quitarlo se compara su elemento.
+	*/
+	size_t cantidad = nodo_copias(arbol, igual);
+	struct repetidos *repetidos = *nodo_repetidos(igual);
+	*nodo_repetidos(igual) = NULL;
+	void *quitado = NULL;
+	bool encontrado = false;
+	arbol->nodo_raiz = abb_quitar_balanceado(arbol, arbol->nodo_raiz,
+						 elemento, clave, &quitado,
+						 &encontrado);
+	arbol->tamanio -= cantidad;
+	if (destructor) {
+		destructor(quitado);
+		for (size_t i = 0; repetidos && i < repetidos->cantidad; i++)
+			destructor(repetidos->elementos[i]);
+	}
+	free(repetidos);
+	return cantidad;
+}
+
+/**
+ * Recibe un puntero a struct abb, un struct nodo_abb y un void pointer a un
+ * elemento que se quiere buscar en el arbol.
+ * Recorre iterativamente los hijos del nodo pasado por parámetro buscando
+ * el elemento pasado, si lo encuentra lo devuelve, y si no devuelve NULL.
+*/
+void *abb_buscar_iter(abb_t *arbol, struct nodo_abb *nodo_actual,
+		      void *elemento)
+{
+	while (nodo_actual) {
+		int comparacion =
+			comparar(arbol, nodo_actual->elemento, elemento);
+		if (comparacion == 0)
+			return nodo_actual->elemento;
+		if (comparacion < 0)
+			nodo_actual = nodo_actual->derecha;
+		else
+			nodo_actual = nodo_actual->izquierda;
+	}
+	return NULL;
+}
+
+/**
+ * Recibe un puntero a un struct abb con extractor y un void pointer a un
+ * elemento, y lo busca como abb_buscar_iter pero comparando primero las
+ * claves guardadas en los nodos (ver comparar_con_nodo).
+*/
+void *buscar_con_clave(abb_t *arbol, void *elemento)
+{
+	struct nodo_abb *nodo =
+		buscar_nodo(arbol, elemento, arbol->extractor(elemento));
+	return nodo ? nodo->elemento : NULL;
+}
+
+/**
+ * Busca en el arbol un elemento igual al provisto (utilizando la
+ * funcion de comparación).
+ *
+ * Devuelve el elemento encontrado o NULL si no lo encuentra.
+ */
+void *abb_buscar(abb_t *arbol, void *elemento)
+{
+	if (!arbol)
+		return NULL;
+	if (arbol->multiclave)
+		return multiclave_buscar(arbol, elemento);
+	if (arbol->mapeado)
+		return mapeado_buscar(arbol, elemento);
+	if (arbol->extractor)
+		return buscar_con_clave(arbol, elemento);
+	return abb_buscar_iter(arbol, arbol->nodo_raiz, elemento);
+}
+
+/**
+ * Devuelve la cantidad de elementos del arbol iguales al provisto. En un
+ * multiconjunto son las copias del nodo igual; en los demás arboles se
+ * cuentan como un rango.
+ */
+size_t abb_contar(abb_t *arbol, void *elemento)
+{
+	if (!arbol)
+		return 0;
+	if (arbol->multiconjunto) {
+		struct nodo_abb *igual =
+			buscar_nodo(arbol, elemento, clave_de(arbol, elemento));
+		return igual ? nodo_copias(arbol, igual) : 0;
+	}
+	return abb_contar_entre(arbol, elemento, elemento);
+}
+
+/**
+ * Recibe un puntero a un struct abb, y un grupo de a lo sumo BUSQUEDA_GRUPO
+ * claves con su array de resultados, y las busca todas a la vez bajando un
+ * nivel por vuelta. En cada vuelta primero pide los elementos de los nodos
+ * actuales (que se pidieron en la vuelta anterior, y salvo que el arbol tenga
+ * extractor, en cuyo caso casi nunca se leen) y después los compara,
+ * avanza cada búsqueda al hijo que corresponde y pide ese hijo.
+ * Devuelve la cantidad de claves encontradas.
+*/
+size_t buscar_grupo(abb_t *arbol, void **claves, size_t n, void **resultados)
+{
+	struct nodo_abb *nodos[BUSQUEDA_GRUPO];
+	uint64_t claves_extraidas[BUSQUEDA_GRUPO];
+	for (size_t i = 0; i < n; i++) {
+		nodos[i] = arbol->nodo_raiz;
+		claves_extraidas[i] = clave_de(arbol, claves[i]);
+		resultados[i] = NULL;
+	}
+	size_t encontrados = 0;
+	size_t activas = arbol->nodo_raiz ? n : 0;
+	while (activas > 0) {
+		for (size_t i = 0; i < n && !arbol->extractor; i++)
+			if (nodos[i])
+				__builtin_prefetch(nodos[i]->elemento);
+		activas = 0;
+		for (size_t i = 0; i < n; i++) {
+			struct nodo_abb *nodo = nodos[i];
+			if (!nodo)
+				continue;
+			int comparacion = comparar_con_nodo(
+				arbol, nodo, claves[i], claves_extraidas[i]);
+			if (comparacion == 0) {
+				resultados[i] = nodo->elemento;
+				encontrados++;
+				nodo = NULL;
+			} else {
+				nodo = comparacion < 0 ? nodo->derecha :
+							 nodo->izquierda;
+			}
+			if (nodo) {
+				__builtin_prefetch(nodo);
+				activas++;
+			}
+			nodos[i] = nodo;
+		}
+	}
+	return encontrados;
+}
+
+/**
+ * Busca en el arbol los n elementos del array claves, y guarda en la misma
+ * posición del array resultados el elemento encontrado o NULL si no lo
+ * encuentra. En los arboles multiclave y en los mapeados se buscan de a uno,
+ * ya que cada búsqueda toca pocos nodos (o ya precarga los siguientes).
+ *
+ * Devuelve la cantidad de elementos encontrados.
+ */
+size_t abb_buscar_lote(abb_t *arbol, void **claves, size_t n,
+		       void **resultados)
+{
+	if (!arbol || !claves || !resultados)
+		return 0;
+	size_t encontrados = 0;
+	if (arbol->multiclave || arbol->mapeado) {
+		for (size_t i = 0; i < n; i++) {
+			resultados[i] = abb_buscar(arbol, claves[i]);
+			encontrados += resultados[i] != NULL;
+		}
+		return encontrados;
+	}
+	for (size_t i = 0; i < n; i += BUSQUEDA_GRUPO) {
+		size_t grupo = n - i < BUSQUEDA_GRUPO ? n - i : BUSQUEDA_GRUPO;
+		encontrados += buscar_grupo(arbol, claves + i, grupo,
+					    resultados + i);
+	}
+	return encontrados;
+}
+
+/**
+ * Recibe un puntero a un struct abb y devuelve una cota superior de su altura:
+ * la altura exacta si es balanceado, o la mayor profundidad en la que se
+ * insertó un nodo si no lo es (quitar nodos nunca aumenta la altura).
+*/
+size_t abb_cota_altura(abb_t *arbol)
+{
+	if (arbol->balanceado)
+		return nodo_altura(arbol->nodo_raiz);
+	return arbol->altura_maxima;
+}
+
+/**
+ * Determina si el árbol está vacío.
+ *
+ * Devuelve true si está vacío o el arbol es NULL, false si el árbol tiene al
+ * menos un elemento.
+ */
+bool abb_vacio(abb_t *arbol)
+{
+	return !arbol || arbol->tamanio == 0;
+}
+
+/**
+ * Devuelve la cantidad de elementos almacenados en el arbol o 0 si el arbol es
+ * NULL.
+ */
+size_t abb_tamanio(abb_t *arbol)
+{
+	if (!arbol)
+		return 0;
+	return arbol->tamanio;
+}
+
+/**
+ * Recibe un puntero a struct abb, uno de sus nodos y un puntero a una
+ * funcion que recibe un void pointer, la cual se invoca con cada elemento de
+ * los hijos del nodo pasado
+ * (incluidas las copias repetidas, si el destructor no es NULL). Los nodos no
+ * se liberan acá, ya que se liberan todos juntos con el pool, pero sí los
+ * arrays de copias repetidas.
+ *
+ * No usa recursión ni memoria adicional: mientras el nodo actual tenga hijo
+ * izquierdo lo rota hacia la derecha, de manera que el árbol se va
+ * convirtiendo en una lista enlazada por los hijos derechos, y cuando no
+ * tiene hijo izquierdo invoca el destructor y avanza al derecho. Deja el
+ * árbol desarmado, así que solo se usa al destruirlo.
+*/
+void abb_destruir_elementos(abb_t *arbol, struct nodo_abb *nodo_actual,
+			    void (*destructor)(void *))
+{
+	while (nodo_actual) {
+		if (nodo_actual->izquierda) {
+			struct nodo_abb *hijo_izquierdo = nodo_actual->izquierda;
+			nodo_actual->izquierda = hijo_izquierdo->derecha;
+			hijo_izquierdo->derecha = nodo_actual;
+			nodo_actual = hijo_izquierdo;
+			continue;
+		}
+		for (size_t i = 0;
+		     destructor && i < nodo_copias(arbol, nodo_actual); i++)
+			destructor(nodo_copia(nodo_actual, i));
+		if (arbol->multiconjunto)
+			free(*nodo_repetidos(nodo_actual));
+		nodo_actual = nodo_actual->derecha;
+	}
+}
+
+/**
+ * Destruye el arbol liberando la memoria reservada por el mismo. Los nodos
+ * se liberan de a bloques enteros junto con el pool, sin recorrer el arbol
+ * (salvo en un multiconjunto, donde hay que liberar las copias repetidas).
+ */
+void abb_destruir(struct abb *arbol)
+{
+	if (!arbol) {
+		return;
+	}
+	if (arbol->mapeado)
+		mapeado_liberar(arbol);
+	if (arbol->multiconjunto)
+		abb_destruir_elementos(arbol, arbol->nodo_raiz, NULL);
+	abb_pool_destruir(arbol->pool);
+	free(arbol);
+}
+
+/**
+ * Destruye el arbol liberando la memoria reservada por el mismo.
+ *
  * Adicionalmente invoca el destructor en cada uno de los elementos almacenados
  * en el arbol (si la funcion destructor no es NULL).
  */
@@ -421,74 +1724,338 @@ void abb_destruir_todo(abb_t *arbol, void (*destructor)(void *))
 	if (!arbol) {
 		return;
 	}
-	abb_destruir_nodos(arbol->nodo_raiz, destructor);
-	free(arbol);
+	if (destructor && destructor != free && !arbol->mapeado) {
+		/**
+		 * Pongo destructor != free porque si no me tira invalid free
+		 * en mis pruebas, ṕorque creo los elementos del abb en el
+		 * stack.
+		*/
+		if (arbol->multiclave)
+			multiclave_destruir_elementos(arbol, destructor);
+		else
+			abb_destruir_elementos(arbol, arbol->nodo_raiz,
+					       destructor);
+		/**
+		 * El arbol quedó desarmado y sin copias repetidas, así que
+		 * abb_destruir no tiene que volver a recorrerlo.
+		*/
+		arbol->nodo_raiz = NULL;
+	}
+	abb_destruir(arbol);
 }
 
 /**
- * Recorre los hijos del nodo pasado por parámetro de manera inorden e invoca
- * la funcion con el elemento de cada uno. El puntero aux se pasa como segundo
- * parámetro a la función. Si la función devuelve false, se finaliza el
- * recorrido aun si quedan elementos por recorrer. Si devuelve true se sigue
- * recorriendo mientras queden elementos.
+ * Estado de un recorrido de los nodos binarios: el arbol (para saber si los
+ * nodos tienen copias repetidas), y o bien un array con su tamaño donde
+ * copiar los elementos, o bien una función con su aux que se invoca con cada
+ * uno. indice cuenta los elementos copiados o las invocaciones, y cortado
+ * indica si el recorrido terminó antes de tiempo (porque se llenó el array o
+ * la función devolvió false).
+*/
+struct visita {
+	abb_t *arbol;
+	void **array;
+	size_t tamanio_array;
+	bool (*funcion)(void *, void *);
+	void *aux;
+	size_t indice;
+	bool cortado;
+};
+
+/**
+ * Recibe el estado de un recorrido y un nodo, y visita el elemento del nodo y
+ * después sus copias repetidas: las copia al array o invoca la función con
+ * cada una. Devuelve false si el recorrido se cortó.
 */
-bool abb_recorrer_inorden(struct nodo_abb *nodo_actual,
-			  bool (*funcion)(void *, void *), void *aux, size_t *i)
+bool visitar_nodo(struct visita *visita, struct nodo_abb *nodo)
 {
-	if (!nodo_actual)
-		return true;
-	if (abb_recorrer_inorden(nodo_actual->izquierda, funcion, aux, i) ==
-	    false)
-		return false;
-	(*i)++;
-	if (funcion(nodo_actual->elemento, aux) == false)
-		return false;
-	return abb_recorrer_inorden(nodo_actual->derecha, funcion, aux, i);
+	if (visita->array && !visita->arbol->multiconjunto) {
+		visita->array[visita->indice++] = nodo->elemento;
+		visita->cortado = visita->indice == visita->tamanio_array;
+		return !visita->cortado;
+	}
+	size_t copias = nodo_copias(visita->arbol, nodo);
+	for (size_t copia = 0; copia < copias; copia++) {
+		void *elemento = nodo_copia(nodo, copia);
+		if (visita->array) {
+			visita->array[visita->indice++] = elemento;
+			visita->cortado =
+				visita->indice == visita->tamanio_array;
+		} else {
+			visita->indice++;
+			visita->cortado =
+				!visita->funcion(elemento, visita->aux);
+		}
+		if (visita->cortado)
+			return false;
+	}
+	return true;
 }
 
 /**
- * Recorre los hijos del nodo pasado por parámetro de manera preorden e invoca
- * la funcion con el elemento de cada uno. El puntero aux se pasa como segundo
- * parámetro a la función. Si la función devuelve false, se finaliza el
- * recorrido aun si quedan elementos por recorrer. Si devuelve true se sigue
- * recorriendo mientras queden elementos.
+ * Recibe el estado de un recorrido, un nodo y una pila con lugar para la
+ * altura del sub-árbol del nodo, y visita los elementos del sub-árbol en
+ * inorden.
 */
-bool abb_recorrer_preorden(struct nodo_abb *nodo_actual,
-			   bool (*funcion)(void *, void *), void *aux,
-			   size_t *i)
+void recorrer_inorden_con_pila(struct visita *visita, struct nodo_abb *nodo,
+			       struct nodo_abb **pila)
 {
-	if (!nodo_actual)
-		return true;
-	(*i)++;
-	if (funcion(nodo_actual->elemento, aux) == false)
-		return false;
-	if (abb_recorrer_preorden(nodo_actual->izquierda, funcion, aux, i) ==
-	    false)
-		return false;
-	return abb_recorrer_preorden(nodo_actual->derecha, funcion, aux, i);
+	size_t tope = 0;
+	while (true) {
+		for (; nodo; nodo = nodo->izquierda)
+			pila[tope++] = nodo;
+		if (tope == 0)
+			return;
+		nodo = pila[--tope];
+		if (!visitar_nodo(visita, nodo))
+			return;
+		nodo = nodo->derecha;
+	}
 }
 
 /**
- * Recorre los hijos del nodo pasado por parámetro de manera postorden e invoca
- * la funcion con el elemento de cada uno. El puntero aux se pasa como segundo
- * parámetro a la función. Si la función devuelve false, se finaliza el
- * recorrido aun si quedan elementos por recorrer. Si devuelve true se sigue
- * recorriendo mientras queden elementos.
+ * Igual que recorrer_inorden_con_pila pero en preorden. La pila guarda el
+ * hijo derecho de cada nodo del camino actual más el nodo actual, así que
+ * necesita un lugar más que la altura del sub-árbol.
 */
-bool abb_recorrer_postorden(struct nodo_abb *nodo_actual,
-			    bool (*funcion)(void *, void *), void *aux,
-			    size_t *i)
+void recorrer_preorden_con_pila(struct visita *visita, struct nodo_abb *nodo,
+				struct nodo_abb **pila)
 {
-	if (!nodo_actual)
-		return true;
-	if (abb_recorrer_postorden(nodo_actual->izquierda, funcion, aux, i) ==
-	    false)
-		return false;
-	if (abb_recorrer_postorden(nodo_actual->derecha, funcion, aux, i) ==
-	    false)
-		return false;
-	(*i)++;
-	return funcion(nodo_actual->elemento, aux);
+	size_t tope = 0;
+	if (nodo)
+		pila[tope++] = nodo;
+	while (tope > 0) {
+		nodo = pila[--tope];
+		if (!visitar_nodo(visita, nodo))
+			return;
+		if (nodo->derecha)
+			pila[tope++] = nodo->derecha;
+		if (nodo->izquierda)
+			pila[tope++] = nodo->izquierda;
+	}
+}
+
+/**
+ * Igual que recorrer_inorden_con_pila pero en postorden. La pila guarda el
+ * camino desde la raíz hasta el nodo actual, y anterior el último nodo
+ * visitado, para saber si ya se volvió de su hijo derecho.
+*/
+void recorrer_postorden_con_pila(struct visita *visita, struct nodo_abb *nodo,
+				 struct nodo_abb **pila)
+{
+	struct nodo_abb *anterior = NULL;
+	size_t tope = 0;
+	while (true) {
+		for (; nodo; nodo = nodo->izquierda)
+			pila[tope++] = nodo;
+		if (tope == 0)
+			return;
+		nodo = pila[tope - 1];
+		if (nodo->derecha && nodo->derecha != anterior) {
+			nodo = nodo->derecha;
+			continue;
+		}
+		tope--;
+		if (!visitar_nodo(visita, nodo))
+			return;
+		anterior = nodo;
+		nodo = NULL;
+	}
+}
+
+/**
+ * Recibe un nodo con hijo izquierdo y devuelve su predecesor inorden, que es
+ * el nodo más a la derecha del hijo izquierdo, sin contar un hilo que apunte
+ * de vuelta al nodo.
+*/
+struct nodo_abb *predecesor_morris(struct nodo_abb *nodo)
+{
+	struct nodo_abb *predecesor = nodo->izquierda;
+	while (predecesor->derecha && predecesor->derecha != nodo)
+		predecesor = predecesor->derecha;
+	return predecesor;
+}
+
+/**
+ * Recibe el nodo donde se cortó un recorrido de Morris y termina de quitar
+ * los hilos que quedaron puestos. Los hilos solo pueden estar en los
+ * predecesores de los nodos cuyo sub-árbol izquierdo se estaba recorriendo,
+ * así que alcanza con seguir hacia la derecha (por hijos o por hilos) sin
+ * entrar nunca a un sub-árbol izquierdo que no se empezó.
+*/
+void quitar_hilos_morris(struct nodo_abb *nodo)
+{
+	while (nodo) {
+		if (nodo->izquierda) {
+			struct nodo_abb *predecesor = predecesor_morris(nodo);
+			if (predecesor->derecha == nodo)
+				predecesor->derecha = NULL;
+		}
+		nodo = nodo->derecha;
+	}
+}
+
+/**
+ * Recibe el estado de un recorrido y un nodo, y visita los elementos del
+ * sub-árbol en inorden (o en preorden, si preorden es true) sin memoria
+ * extra, con el recorrido de Morris: antes de bajar por la izquierda de un
+ * nodo, hace que su predecesor apunte a él por derecha (un hilo), para poder
+ * volver sin pila. Al terminar el arbol queda como estaba.
+*/
+void recorrer_morris(struct visita *visita, struct nodo_abb *nodo,
+		     bool preorden)
+{
+	bool seguir = true;
+	while (nodo) {
+		if (!nodo->izquierda) {
+			seguir = visitar_nodo(visita, nodo);
+			nodo = nodo->derecha;
+		} else {
+			struct nodo_abb *predecesor = predecesor_morris(nodo);
+			if (!predecesor->derecha) {
+				predecesor->derecha = nodo;
+				if (preorden)
+					seguir = visitar_nodo(visita, nodo);
+				nodo = nodo->izquierda;
+			} else {
+				predecesor->derecha = NULL;
+				if (!preorden)
+					seguir = visitar_nodo(visita, nodo);
+				nodo = nodo->derecha;
+			}
+		}
+		if (!seguir) {
+			quitar_hilos_morris(nodo);
+			return;
+		}
+	}
+}
+
+/**
+ * Recibe dos nodos tales que hasta se alcanza desde desde bajando solo por
+ * derecha, e invierte los punteros derechos de ese camino: cada nodo pasa a
+ * apuntar al anterior. El puntero derecho de desde no cambia.
+*/
+void invertir_derechos(struct nodo_abb *desde, struct nodo_abb *hasta)
+{
+	struct nodo_abb *anterior = desde, *actual = desde->derecha;
+	while (anterior != hasta) {
+		struct nodo_abb *siguiente = actual->derecha;
+		actual->derecha = anterior;
+		anterior = actual;
+		actual = siguiente;
+	}
+}
+
+/**
+ * Recibe el estado de un recorrido y dos nodos como los de
+ * invertir_derechos, y visita (mientras el recorrido no se corte) los nodos
+ * del camino de hasta a desde. Invierte el camino para recorrerlo al revés y
+ * después lo deja como estaba, salvo el puntero derecho de hasta. Devuelve
+ * false si el recorrido se cortó.
+*/
+bool visitar_camino_invertido(struct visita *visita, struct nodo_abb *desde,
+			      struct nodo_abb *hasta)
+{
+	bool seguir = true;
+	invertir_derechos(desde, hasta);
+	for (struct nodo_abb *nodo = hasta;; nodo = nodo->derecha) {
+		if (seguir)
+			seguir = visitar_nodo(visita, nodo);
+		if (nodo == desde)
+			break;
+	}
+	invertir_derechos(hasta, desde);
+	return seguir;
+}
+
+/**
+ * Recibe el estado de un recorrido y un nodo, y visita los elementos del
+ * sub-árbol en postorden sin pila, con la variante del recorrido de Morris
+ * para postorden: cuelga el sub-árbol a la izquierda de un nodo auxiliar, y
+ * al volver por el hilo de un nodo visita, de abajo hacia arriba, el borde
+ * derecho de su sub-árbol izquierdo (invirtiéndolo y restaurándolo en el
+ * lugar). Al terminar el arbol queda como estaba.
+*/
+void recorrer_morris_postorden(struct visita *visita, struct nodo_abb *raiz)
+{
+	struct nodo_abb auxiliar = { .izquierda = raiz };
+	struct nodo_abb *nodo = &auxiliar;
+	while (nodo) {
+		if (!nodo->izquierda) {
+			nodo = nodo->derecha;
+			continue;
+		}
+		struct nodo_abb *predecesor = predecesor_morris(nodo);
+		if (!predecesor->derecha) {
+			predecesor->derecha = nodo;
+			nodo = nodo->izquierda;
+			continue;
+		}
+		bool seguir =
+			visitar_camino_invertido(visita, nodo->izquierda,
+						 predecesor);
+		predecesor->derecha = NULL;
+		nodo = nodo->derecha;
+		if (!seguir) {
+			quitar_hilos_morris(nodo);
+			return;
+		}
+	}
+}
+
+/**
+ * Recibe el estado de un recorrido, un nodo, el recorrido a hacer y una pila
+ * con lugar para la altura del sub-árbol del nodo más uno, y visita los
+ * elementos del sub-árbol. Si la pila es NULL, lo recorre con Morris, que no
+ * necesita memoria pero enlaza temporalmente algunos nodos entre sí.
+*/
+void recorrer_nodos(struct visita *visita, struct nodo_abb *nodo,
+		    abb_recorrido recorrido, struct nodo_abb **pila)
+{
+	if (recorrido == INORDEN && pila)
+		recorrer_inorden_con_pila(visita, nodo, pila);
+	else if (recorrido == PREORDEN && pila)
+		recorrer_preorden_con_pila(visita, nodo, pila);
+	else if (recorrido == POSTORDEN && pila)
+		recorrer_postorden_con_pila(visita, nodo, pila);
+	else if (recorrido == INORDEN || recorrido == PREORDEN)
+		recorrer_morris(visita, nodo, recorrido == PREORDEN);
+	else if (recorrido == POSTORDEN)
+		recorrer_morris_postorden(visita, nodo);
+}
+
+/**
+ * Recibe un puntero a struct abb, uno de sus nodos, el recorrido a hacer,
+ * una funcion con su aux y un contador, y recorre el sub-árbol del nodo
+ * invocando la función con cada elemento y sumando uno al contador antes de
+ * cada invocación.
+ *
+ * La altura del sub-árbol no supera la cota del arbol ni su cantidad de
+ * elementos: si no pasa de RECORRER_PILA, la pila es local, y si no, se
+ * reserva del tamaño justo. Solo si no hay memoria para ella se recorre con
+ * Morris. Devuelve false si la función devolvió false.
+*/
+bool recorrer_sub_arbol(abb_t *arbol, struct nodo_abb *nodo,
+			abb_recorrido recorrido,
+			bool (*funcion)(void *, void *), void *aux,
+			size_t *invocaciones)
+{
+	struct visita visita = { .arbol = arbol,
+				 .funcion = funcion,
+				 .aux = aux };
+	size_t altura = abb_cota_altura(arbol);
+	if (nodo && nodo->cantidad < altura)
+		altura = nodo->cantidad;
+	struct nodo_abb *pila_local[RECORRER_PILA + 1];
+	struct nodo_abb **pila = pila_local;
+	if (altura > RECORRER_PILA)
+		pila = malloc((altura + 1) * sizeof(struct nodo_abb *));
+	recorrer_nodos(&visita, nodo, recorrido, pila);
+	if (pila != pila_local)
+		free(pila);
+	*invocaciones += visita.indice;
+	return !visita.cortado;
 }
 
 /**
@@ -498,7 +2065,16 @@ bool abb_recorrer_postorden(struct nodo_abb *nodo_actual,
  * elementos por recorrer. Si devuelve true se sigue recorriendo mientras queden
  * elementos.
  *
- * Recorrido especifica el tipo de recorrido a realizar.
+ * Recorrido especifica el tipo de recorrido a realizar. En los arboles
+ * multiclave los elementos están solo en las hojas, así que todos los
+ * recorridos los visitan de menor a mayor.
+ *
+ * No usa recursión: recorre con una pila local, o si el arbol no está
+ * balanceado y es más alto que 128 niveles, con una pila reservada del alto
+ * del arbol. Solo si no hay memoria para esa pila lo recorre como
+ * abb_recorrer, enlazando temporalmente algunos nodos entre sí, y en ese caso
+ * la función no debe usar el arbol y no puede recorrerse a la vez desde otro
+ * hilo.
  *
  * Devuelve la cantidad de veces que fue invocada la función.
 */
@@ -507,16 +2083,15 @@ size_t abb_con_cada_elemento(abb_t *arbol, abb_recorrido recorrido,
 {
 	if (!arbol || !funcion)
 		return 0;
-	size_t contador = 0;
-	if (recorrido == INORDEN)
-		abb_recorrer_inorden(arbol->nodo_raiz, funcion, aux, &contador);
-	else if (recorrido == PREORDEN)
-		abb_recorrer_preorden(arbol->nodo_raiz, funcion, aux,
-				      &contador);
-	else if (recorrido == POSTORDEN)
-		abb_recorrer_postorden(arbol->nodo_raiz, funcion, aux,
-				       &contador);
-	return contador;
+	if (arbol->multiclave)
+		return multiclave_con_cada_elemento(arbol, funcion, aux);
+	if (arbol->mapeado)
+		return mapeado_con_cada_elemento(arbol, recorrido, funcion,
+						 aux);
+	size_t invocaciones = 0;
+	recorrer_sub_arbol(arbol, arbol->nodo_raiz, recorrido, funcion, aux,
+			   &invocaciones);
+	return invocaciones;
 }
 
 /**
@@ -527,25 +2102,22 @@ size_t abb_con_cada_elemento(abb_t *arbol, abb_recorrido recorrido,
 struct estado_array {
 	size_t tamanio_maximo;
 	void **array;
-	int indice;
+	size_t indice;
 };
 
 /**
  * Recibe un void pointer a un elemento y otro que debe ser a un struct
  * estado_array. Almacena el elemento en la posición del índice de estado_array
- * y aumenta el índice en uno. Si se pudo agregar el elemento devuelve true,
- * pero si el array está lleno (indice >= tamaño) devuelve false.
+ * y aumenta el índice en uno. Devuelve false si con este elemento se llenó el
+ * array (o si ya estaba lleno), y true si todavía queda espacio.
 */
 bool agregar_elemento_al_array(void *elemento, void *estado_array)
 {
-	int indice = ((struct estado_array *)estado_array)->indice;
-	int tamanio =
-		(int)((struct estado_array *)estado_array)->tamanio_maximo;
-	if (indice >= tamanio)
+	struct estado_array *estado = estado_array;
+	if (estado->indice >= estado->tamanio_maximo)
 		return false;
-	(((struct estado_array *)estado_array)->array)[indice] = elemento;
-	(((struct estado_array *)estado_array)->indice)++;
-	return true;
+	estado->array[estado->indice++] = elemento;
+	return estado->indice < estado->tamanio_maximo;
 }
 
 /**
@@ -561,16 +2133,404 @@ bool agregar_elemento_al_array(void *elemento, void *estado_array)
 size_t abb_recorrer(abb_t *arbol, abb_recorrido recorrido, void **array,
 		    size_t tamanio_array)
 {
-	if (!array)
+	if (!arbol || !array || tamanio_array == 0)
 		return 0;
-	struct estado_array *estado_array =
-		calloc(1, sizeof(struct estado_array));
-	estado_array->tamanio_maximo = tamanio_array;
-	estado_array->array = array;
-	estado_array->indice = 0;
-	abb_con_cada_elemento(arbol, recorrido, agregar_elemento_al_array,
-			      estado_array);
-	size_t resultado = (size_t)estado_array->indice;
-	free(estado_array);
-	return resultado;
-}
\ No newline at end of file
+	if (arbol->multiclave || arbol->mapeado) {
+		struct estado_array estado_array = { .tamanio_maximo =
+							     tamanio_array,
+						     .array = array };
+		abb_con_cada_elemento(arbol, recorrido,
+				      agregar_elemento_al_array, &estado_array);
+		return estado_array.indice;
+	}
+	struct visita visita = { .arbol = arbol,
+				 .array = array,
+				 .tamanio_array = tamanio_array };
+	struct nodo_abb *pila[RECORRER_PILA + 1];
+	/**
+	 * Un arbol más alto que la pila solo puede ser uno no balanceado que
+	 * se degeneró, así que se recorre con Morris, sin reservar memoria.
+	*/
+	recorrer_nodos(&visita, arbol->nodo_raiz, recorrido,
+		       abb_cota_altura(arbol) <= RECORRER_PILA ? pila : NULL);
+	return visita.indice;
+}
+
+/**
+ * Recibe un iterador y un nodo, y apila el nodo y sus descendientes por la
+ * rama izquierda, hasta llegar a uno sin hijo izquierdo.
+*/
+void iterador_apilar_izquierdos(abb_iterador_t *iterador,
+				struct nodo_abb *nodo)
+{
+	while (nodo) {
+		iterador->pila[iterador->tope++] = nodo;
+		nodo = nodo->izquierda;
+	}
+}
+
+/**
+ * Recibe un iterador y un nodo, y apila el nodo y sus descendientes hasta
+ * llegar a una hoja, yendo por el hijo izquierdo si existe o si no por el
+ * derecho. La hoja queda en el tope, y es el primer nodo postorden del
+ * sub-árbol.
+*/
+void iterador_apilar_hasta_hoja(abb_iterador_t *iterador,
+				struct nodo_abb *nodo)
+{
+	while (nodo) {
+		iterador->pila[iterador->tope++] = nodo;
+		nodo = nodo->izquierda ? nodo->izquierda : nodo->derecha;
+	}
+}
+
+/**
+ * Recibe un puntero a un struct abb y un recorrido, y crea un iterador con la
+ * pila vacía, con lugar suficiente para recorrer el arbol.
+ * Devuelve el iterador o NULL en caso de error.
+*/
+abb_iterador_t *iterador_crear_vacio(abb_t *arbol, abb_recorrido recorrido)
+{
+	size_t capacidad = abb_cota_altura(arbol) + 1;
+	abb_iterador_t *iterador = calloc(
+		1, sizeof(abb_iterador_t) + capacidad * sizeof(struct nodo_abb *));
+	if (!iterador)
+		return NULL;
+	iterador->arbol = arbol;
+	iterador->recorrido = recorrido;
+	return iterador;
+}
+
+/**
+ * Crea un iterador externo que recorre el arbol según el recorrido
+ * especificado. Los arboles multiclave no tienen iterador.
+ *
+ * Devuelve el iterador o NULL en caso de error.
+ */
+abb_iterador_t *abb_iterador_crear(abb_t *arbol, abb_recorrido recorrido)
+{
+	if (!arbol || arbol->multiclave ||
+	    (recorrido != INORDEN && recorrido != PREORDEN &&
+	     recorrido != POSTORDEN))
+		return NULL;
+	abb_iterador_t *iterador = iterador_crear_vacio(arbol, recorrido);
+	if (!iterador)
+		return NULL;
+	if (recorrido == INORDEN)
+		iterador_apilar_izquierdos(iterador, arbol->nodo_raiz);
+	else if (recorrido == POSTORDEN)
+		iterador_apilar_hasta_hoja(iterador, arbol->nodo_raiz);
+	else if (arbol->nodo_raiz)
+		iterador->pila[iterador->tope++] = arbol->nodo_raiz;
+	return iterador;
+}
+
+/**
+ * Devuelve true si al iterador le quedan elementos por recorrer, o false si
+ * ya los recorrió todos o es NULL.
+ */
+bool abb_iterador_tiene_siguiente(abb_iterador_t *iterador)
+{
+	if (!iterador)
+		return false;
+	return iterador->tope > 0 ||
+	       (iterador->ultimo &&
+		iterador->copia + 1 <
+			nodo_copias(iterador->arbol, iterador->ultimo));
+}
+
+/**
+ * Recibe un iterador con la pila no vacía, saca el nodo del tope y apila lo
+ * que haga falta para que el tope sea el siguiente nodo del recorrido.
+ * Devuelve el nodo sacado.
+*/
+struct nodo_abb *iterador_avanzar(abb_iterador_t *iterador)
+{
+	struct nodo_abb *nodo = iterador->pila[--iterador->tope];
+	if (iterador->recorrido == INORDEN) {
+		iterador_apilar_izquierdos(iterador, nodo->derecha);
+	} else if (iterador->recorrido == PREORDEN) {
+		if (nodo->derecha)
+			iterador->pila[iterador->tope++] = nodo->derecha;
+		if (nodo->izquierda)
+			iterador->pila[iterador->tope++] = nodo->izquierda;
+	} else if (iterador->tope > 0) {
+		struct nodo_abb *padre = iterador->pila[iterador->tope - 1];
+		if (padre->izquierda == nodo)
+			iterador_apilar_hasta_hoja(iterador, padre->derecha);
+	}
+	return nodo;
+}
+
+/**
+ * Avanza el iterador y devuelve el siguiente elemento del recorrido, o NULL si
+ * no quedan elementos.
+ */
+void *abb_iterador_siguiente(abb_iterador_t *iterador)
+{
+	if (!abb_iterador_tiene_siguiente(iterador))
+		return NULL;
+	if (iterador->ultimo &&
+	    iterador->copia + 1 <
+		    nodo_copias(iterador->arbol, iterador->ultimo))
+		return nodo_copia(iterador->ultimo, ++iterador->copia);
+	iterador->ultimo = iterador_avanzar(iterador);
+	iterador->copia = 0;
+	return iterador->ultimo->elemento;
+}
+
+/**
+ * Destruye el iterador. No modifica el arbol.
+ */
+void abb_iterador_destruir(abb_iterador_t *iterador)
+{
+	free(iterador);
+}
+
+/**
+ * Recibe el estado de un recorrido y dos elementos, mínimo y máximo, y visita
+ * en inorden los elementos del arbol que están entre ellos. Baja desde la
+ * raíz apilando solo los nodos mayores o iguales al mínimo (los sub-árboles
+ * izquierdos de los nodos menores se descartan enteros), de manera que el
+ * tope de la pila es el primero del rango, y desde ahí avanza como
+ * recorrer_inorden_con_pila hasta pasarse del máximo.
+ *
+ * La pila es local si el arbol no es más alto que RECORRER_PILA, y si no se
+ * reserva de su altura. Si no hay memoria para ella no visita nada.
+*/
+void recorrer_rango(struct visita *visita, void *minimo, void *maximo)
+{
+	abb_t *arbol = visita->arbol;
+	size_t altura = abb_cota_altura(arbol);
+	struct nodo_abb *pila_local[RECORRER_PILA + 1];
+	struct nodo_abb **pila = pila_local;
+	if (altura > RECORRER_PILA)
+		pila = malloc((altura + 1) * sizeof(struct nodo_abb *));
+	if (!pila)
+		return;
+	size_t tope = 0;
+	struct nodo_abb *nodo = arbol->nodo_raiz;
+	while (nodo) {
+		if (comparar(arbol, nodo->elemento, minimo) >= 0) {
+			pila[tope++] = nodo;
+			nodo = nodo->izquierda;
+		} else {
+			nodo = nodo->derecha;
+		}
+	}
+	while (tope > 0) {
+		nodo = pila[--tope];
+		if (comparar(arbol, nodo->elemento, maximo) > 0 ||
+		    !visitar_nodo(visita, nodo))
+			break;
+		for (nodo = nodo->derecha; nodo; nodo = nodo->izquierda)
+			pila[tope++] = nodo;
+	}
+	if (pila != pila_local)
+		free(pila);
+}
+
+/**
+ * Invoca la funcion con cada elemento del arbol que esté entre minimo y maximo
+ * (inclusive), en orden de menor a mayor. El puntero aux se pasa como segundo
+ * parámetro a la función. Si la función devuelve false, se finaliza el
+ * recorrido aun si quedan elementos en el rango.
+ *
+ * Devuelve la cantidad de veces que fue invocada la función.
+ */
+size_t abb_rango(abb_t *arbol, void *minimo, void *maximo,
+		 bool (*funcion)(void *, void *), void *aux)
+{
+	if (!arbol || !funcion)
+		return 0;
+	if (arbol->multiclave)
+		return multiclave_rango(arbol, minimo, maximo, funcion, aux);
+	struct visita visita = { .arbol = arbol,
+				 .funcion = funcion,
+				 .aux = aux };
+	recorrer_rango(&visita, minimo, maximo);
+	return visita.indice;
+}
+
+/**
+ * Devuelve la cantidad de elementos del arbol que están entre minimo y maximo
+ * (inclusive). Es lo mismo que abb_contar_entre.
+ */
+size_t abb_rango_contar(abb_t *arbol, void *minimo, void *maximo)
+{
+	return abb_contar_entre(arbol, minimo, maximo);
+}
+
+/**
+ * Almacena en el array, de menor a mayor, los elementos del arbol que están
+ * entre minimo y maximo (inclusive), hasta completar el rango o quedarse sin
+ * espacio en el array.
+ *
+ * Devuelve la cantidad de elementos que fueron almacenados en el array.
+ */
+size_t abb_rango_recorrer(abb_t *arbol, void *minimo, void *maximo,
+			  void **array, size_t tamanio_array)
+{
+	if (!arbol || !array || tamanio_array == 0)
+		return 0;
+	if (arbol->multiclave) {
+		struct estado_array estado_array = { .tamanio_maximo =
+							     tamanio_array,
+						     .array = array };
+		multiclave_rango(arbol, minimo, maximo,
+				 agregar_elemento_al_array, &estado_array);
+		return estado_array.indice;
+	}
+	struct visita visita = { .arbol = arbol,
+				 .array = array,
+				 .tamanio_array = tamanio_array };
+	recorrer_rango(&visita, minimo, maximo);
+	return visita.indice;
+}
+
+/**
+ * Devuelve el elemento que ocupa la posición k (empezando en 0) en el orden
+ * del arbol, es decir, el k-ésimo menor, o NULL si el arbol tiene k elementos
+ * o menos.
+ */
+void *abb_seleccionar(abb_t *arbol, size_t k)
+{
+	if (!arbol || arbol->multiclave || k >= arbol->tamanio)
+		return NULL;
+	struct nodo_abb *nodo_actual = arbol->nodo_raiz;
+	while (nodo_actual) {
+		size_t cantidad_izquierda = nodo_cantidad(nodo_actual->izquierda);
+		size_t copias = nodo_copias(arbol, nodo_actual);
+		if (k >= cantidad_izquierda && k < cantidad_izquierda + copias)
+			return nodo_copia(nodo_actual, k - cantidad_izquierda);
+		if (k < cantidad_izquierda) {
+			nodo_actual = nodo_actual->izquierda;
+		} else {
+			k -= cantidad_izquierda + copias;
+			nodo_actual = nodo_actual->derecha;
+		}
+	}
+	return NULL;
+}
+
+/**
+ * Recibe un puntero a struct abb, un void pointer a un elemento y un booleano.
+ * Devuelve la cantidad de elementos del arbol menores al recibido, o menores o
+ * iguales si incluir_iguales es true.
+*/
+size_t contar_menores(abb_t *arbol, void *elemento, bool incluir_iguales)
+{
+	size_t menores = 0;
+	struct nodo_abb *nodo_actual = arbol->nodo_raiz;
+	while (nodo_actual) {
+		int comparacion =
+			comparar(arbol, nodo_actual->elemento, elemento);
+		if (comparacion < 0 || (comparacion == 0 && incluir_iguales)) {
+			menores += nodo_cantidad(nodo_actual->izquierda) +
+				   nodo_copias(arbol, nodo_actual);
+			nodo_actual = nodo_actual->derecha;
+		} else {
+			nodo_actual = nodo_actual->izquierda;
+		}
+	}
+	return menores;
+}
+
+/**
+ * Devuelve la cantidad de elementos del arbol estrictamente menores al
+ * recibido, que es la posición que ocupa (o que ocuparía) el elemento en el
+ * orden del arbol.
+ */
+size_t abb_rango_de(abb_t *arbol, void *elemento)
+{
+	if (!arbol || arbol->multiclave)
+		return 0;
+	return contar_menores(arbol, elemento, false);
+}
+
+/**
+ * Devuelve la cantidad de elementos del arbol que están entre a y b
+ * (inclusive), o 0 si a es mayor que b.
+ */
+size_t abb_contar_entre(abb_t *arbol, void *a, void *b)
+{
+	if (!arbol || comparar(arbol, a, b) > 0)
+		return 0;
+	if (arbol->multiclave)
+		return multiclave_contar_entre(arbol, a, b);
+	return contar_menores(arbol, b, true) - contar_menores(arbol, a, false);
+}
+
+/**
+ * Recibe un puntero a struct abb, un void pointer a un elemento y dos
+ * booleanos. Si hacia_mayores es false, devuelve el mayor elemento del arbol
+ * que sea menor al recibido; si es true, el menor elemento que sea mayor al
+ * recibido. Si incluir_iguales es true, un elemento igual al recibido también
+ * cuenta. Baja una sola vez desde la raíz, invocando el comparador una vez por
+ * nivel, y devuelve NULL si no hay tal elemento.
+*/
+void *buscar_vecino(abb_t *arbol, void *elemento, bool hacia_mayores,
+		    bool incluir_iguales)
+{
+	void *candidato = NULL;
+	struct nodo_abb *nodo_actual = arbol->nodo_raiz;
+	while (nodo_actual) {
+		int comparacion =
+			comparar(arbol, nodo_actual->elemento, elemento);
+		if (comparacion == 0 && incluir_iguales)
+			return nodo_actual->elemento;
+		if (hacia_mayores ? comparacion > 0 : comparacion < 0) {
+			candidato = nodo_actual->elemento;
+			nodo_actual = hacia_mayores ? nodo_actual->izquierda :
+						      nodo_actual->derecha;
+		} else {
+			nodo_actual = hacia_mayores ? nodo_actual->derecha :
+						      nodo_actual->izquierda;
+		}
+	}
+	return candidato;
+}
+
+/**
+ * Devuelve el mayor elemento del arbol que es menor o igual al recibido, o
+ * NULL si no hay ninguno.
+ */
+void *abb_piso(abb_t *arbol, void *elemento)
+{
+	if (!arbol || arbol->multiclave)
+		return NULL;
+	return buscar_vecino(arbol, elemento, false, true);
+}
+
+/**
+ * Devuelve el menor elemento del arbol que es mayor o igual al recibido, o
+ * NULL si no hay ninguno.
+ */
+void *abb_techo(abb_t *arbol, void *elemento)
+{
+	if (!arbol || arbol->multiclave)
+		return NULL;
+	return buscar_vecino(arbol, elemento, true, true);
+}
+
+/**
+ * Devuelve el mayor elemento del arbol que es estrictamente menor al
+ * recibido, o NULL si no hay ninguno.
+ */
+void *abb_predecesor(abb_t *arbol, void *elemento)
+{
+	if (!arbol || arbol->multiclave)
+		return NULL;
+	return buscar_vecino(arbol, elemento, false, false);
+}
+
+/**
+ * Devuelve el menor elemento del arbol que es estrictamente mayor al
+ * recibido, o NULL si no hay ninguno.
+ */
+void *abb_sucesor(abb_t *arbol, void *elemento)
+{
+	if (!arbol || arbol->multiclave)
+		return NULL;
+	return buscar_vecino(arbol, elemento, true, false);
+}
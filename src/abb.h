@@ -2,6 +2,7 @@
 #define __ABB__H__
 
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
 
 typedef enum { INORDEN, PREORDEN, POSTORDEN } abb_recorrido;
@@ -13,10 +14,21 @@ typedef enum { INORDEN, PREORDEN, POSTORDEN } abb_recorrido;
  */
 typedef int (*abb_comparador)(void *, void *);
 
+/**
+ * Extractor de claves. Recibe un elemento y devuelve una clave de 64 bits que
+ * respeta el orden del comparador: si un elemento es menor que otro, su clave
+ * debe ser menor o igual. Puede ser un prefijo del elemento (por ejemplo, los
+ * primeros 8 bytes de un string), ya que si dos claves son iguales se decide
+ * con el comparador.
+ */
+typedef uint64_t (*abb_extractor_clave)(void *);
+
 typedef struct nodo_abb nodo_abb_t;
 
 typedef struct abb abb_t;
 
+typedef struct abb_iterador abb_iterador_t;
+
 /**
  * Crea un arbol binario de búsqueda. Comparador es una función que se utiliza
  * para comparar dos elementos. La funcion de comparación no puede ser nula.
@@ -25,6 +37,152 @@ typedef struct abb abb_t;
  */
 abb_t *abb_crear(abb_comparador comparador);
 
+/**
+ * Crea un arbol binario de búsqueda balanceado (AVL). Se comporta igual que un
+ * arbol creado con abb_crear, pero cada inserción y eliminación rebalancea el
+ * arbol, por lo que su altura es siempre O(log n), aun si los elementos se
+ * insertan ordenados.
+ *
+ * Devuelve un puntero al arbol creado o NULL en caso de error.
+ */
+abb_t *abb_crear_balanceado(abb_comparador comparador);
+
+/**
+ * Crea un arbol balanceado (ver abb_crear_balanceado) con los n elementos del
+ * array, que deben estar ordenados de menor a mayor según el comparador. El
+ * arbol se arma en O(n) con altura mínima, y todos sus nodos se reservan en
+ * un único bloque de memoria.
+ *
+ * Devuelve un puntero al arbol creado o NULL en caso de error.
+ */
+abb_t *abb_crear_desde_ordenado(abb_comparador comparador, void **elementos,
+				size_t n);
+
+/**
+ * Igual que abb_crear_desde_ordenado, pero los elementos del array pueden
+ * estar en cualquier orden: primero se ordena una copia del array (el array
+ * recibido no se modifica), en O(n log n).
+ *
+ * Devuelve un puntero al arbol creado o NULL en caso de error.
+ */
+abb_t *abb_crear_desde_desordenado(abb_comparador comparador,
+				   void **elementos, size_t n);
+
+/**
+ * Crea un arbol balanceado (ver abb_crear_balanceado) con los elementos que
+ * están en a, en b o en los dos. Si un elemento de a es igual a uno de b
+ * (según el comparador de a), queda solo el de a. Los dos arboles tienen que
+ * ordenar con el mismo criterio y no se modifican.
+ *
+ * Los elementos de cada arbol se recorren en orden a la vez, así que tarda
+ * O(n + m), y se reservan solo los nodos del resultado. Si a tiene extractor
+ * de clave, el resultado también.
+ *
+ * Devuelve un puntero al arbol creado o NULL en caso de error.
+ */
+abb_t *abb_union(abb_t *a, abb_t *b);
+
+/**
+ * Igual que abb_union, pero con los elementos de a que son iguales a alguno
+ * de b.
+ *
+ * Devuelve un puntero al arbol creado o NULL en caso de error.
+ */
+abb_t *abb_interseccion(abb_t *a, abb_t *b);
+
+/**
+ * Igual que abb_union, pero con los elementos de a que no son iguales a
+ * ninguno de b.
+ *
+ * Devuelve un puntero al arbol creado o NULL en caso de error.
+ */
+abb_t *abb_diferencia(abb_t *a, abb_t *b);
+
+/**
+ * Separa el arbol en dos: menores, con los elementos menores al pivote, y
+ * mayores, con el resto. No reserva nodos ni copia elementos: los nodos del
+ * arbol se reparten entre los dos, que comparten su pool, y el arbol recibido
+ * pasa a ser menores (no hay que destruirlo aparte). Hay que destruir los dos
+ * resultados.
+ *
+ * Como el pool compartido no es seguro para varios hilos, los dos resultados
+ * no se pueden modificar (insertar, quitar o unir) a la vez desde hilos
+ * distintos; sí se pueden leer a la vez y destruir desde cualquier hilo. Para
+ * repartirlos entre hilos que los modifiquen, se puede copiar uno a un arbol
+ * con su propio pool, por ejemplo con abb_union con un arbol vacío.
+ *
+ * En un arbol balanceado tarda O(log n) y los dos resultados quedan
+ * balanceados; en uno que no lo es tarda O(altura). No funciona con arboles
+ * multiclave.
+ *
+ * Devuelve true si se pudo dividir, o false (sin modificar el arbol) en caso
+ * de error.
+ */
+bool abb_dividir(abb_t *arbol, void *pivote, abb_t **menores,
+		 abb_t **mayores);
+
+/**
+ * Une dos arboles creados de la misma forma (con el mismo comparador, y los
+ * dos balanceados o los dos sin balancear), donde todos los elementos de a
+ * son menores o iguales a todos los de b. Reutiliza los nodos de los dos
+ * arboles: el resultado es a, y b deja de existir (no hay que destruirlo).
+ *
+ * Si los dos son balanceados tarda O(log n + log m), y si no, O(altura de
+ * a). Si los dos arboles comparten su pool con otros (por haber salido de
+ * abb_dividir sin que se destruyera la otra parte), los elementos de b se
+ * pasan a nodos nuevos, en O(m). No funciona con arboles multiclave.
+ *
+ * Devuelve a, o NULL (sin modificar ninguno de los dos) en caso de error o
+ * si algún elemento de a es mayor a alguno de b.
+ */
+abb_t *abb_unir(abb_t *a, abb_t *b);
+
+/**
+ * Crea un arbol balanceado (ver abb_crear_balanceado) que guarda en cada nodo
+ * la clave que el extractor devuelve para su elemento. Al buscar, insertar y
+ * quitar compara primero las claves, que están en el nodo, y solo invoca al
+ * comparador (que tiene que leer el elemento) cuando son iguales. Así, si las
+ * claves distinguen a casi todos los elementos, bajar por el arbol no lee
+ * ningún elemento. El extractor no puede ser nulo.
+ *
+ * Devuelve un puntero al arbol creado o NULL en caso de error.
+ */
+abb_t *abb_crear_con_clave(abb_comparador comparador,
+			   abb_extractor_clave extractor);
+
+/**
+ * Crea un arbol multiclave: en vez de un elemento por nodo, guarda hasta 14
+ * elementos por nodo en nodos de 128 bytes alineados a línea de cache (un
+ * arbol B+), por lo que cada búsqueda toca muchos menos nodos que en un arbol
+ * binario. Los elementos están solo en las hojas, que están enlazadas de
+ * menor a mayor, así que recorrerlo en orden es leer las hojas una tras otra.
+ *
+ * Se usa con las mismas funciones que el resto de los arboles (insertar,
+ * buscar, quitar, recorrer, abb_rango, abb_contar_entre y destruir). Todos los
+ * recorridos visitan los elementos de menor a mayor. No tiene iterador, y
+ * abb_seleccionar, abb_rango_de, abb_piso, abb_techo, abb_predecesor y
+ * abb_sucesor devuelven siempre NULL o 0.
+ *
+ * Devuelve un puntero al arbol creado o NULL en caso de error.
+ */
+abb_t *abb_crear_multiclave(abb_comparador comparador);
+
+/**
+ * Crea un arbol balanceado (ver abb_crear_balanceado) que agrupa los
+ * elementos iguales en un único nodo: el primero que se insertó queda en el
+ * nodo, y los demás en un array del nodo. Así, insertar muchas veces el mismo
+ * elemento no alarga el arbol, y contar o quitar todas sus copias tarda lo
+ * mismo que buscarlo.
+ *
+ * abb_buscar devuelve la primera copia, abb_quitar quita la última que se
+ * insertó, y los recorridos, el iterador y las consultas por posición ven
+ * todas las copias, seguidas. No admite abb_union, abb_interseccion,
+ * abb_diferencia, abb_dividir ni abb_unir.
+ *
+ * Devuelve un puntero al arbol creado o NULL en caso de error.
+ */
+abb_t *abb_crear_multiconjunto(abb_comparador comparador);
+
 /**
  * Inserta un elemento en el arbol.
  * El arbol admite elementos con valores repetidos.
@@ -44,6 +202,16 @@ abb_t *abb_insertar(abb_t *arbol, void *elemento);
  */
 void *abb_quitar(abb_t *arbol, void *elemento);
 
+/**
+ * Quita del arbol todos los elementos iguales al provisto, e invoca el
+ * destructor con cada uno (si no es NULL). En un multiconjunto los quita a
+ * todos de una vez; en los demás arboles, de a uno con abb_quitar.
+ *
+ * Devuelve la cantidad de elementos quitados.
+ */
+size_t abb_quitar_todos(abb_t *arbol, void *elemento,
+			void (*destructor)(void *));
+
 /**
  * Busca en el arbol un elemento igual al provisto (utilizando la
  * funcion de comparación).
@@ -52,6 +220,28 @@ void *abb_quitar(abb_t *arbol, void *elemento);
  */
 void *abb_buscar(abb_t *arbol, void *elemento);
 
+/**
+ * Devuelve la cantidad de elementos del arbol iguales al provisto, o 0 si el
+ * arbol es NULL. En un multiconjunto tarda lo mismo que abb_buscar; en los
+ * demás arboles es abb_contar_entre(arbol, elemento, elemento).
+ */
+size_t abb_contar(abb_t *arbol, void *elemento);
+
+/**
+ * Busca en el arbol los n elementos del array claves, y guarda en la misma
+ * posición del array resultados el elemento encontrado o NULL si no lo
+ * encuentra (como si se llamara a abb_buscar con cada uno).
+ *
+ * Las búsquedas avanzan de a grupos, un nivel por vez, pidiendo de antemano
+ * los nodos siguientes de todas las del grupo, así los fallos de cache se
+ * esperan en paralelo y no uno después del otro. Conviene cuando el arbol
+ * no entra en cache.
+ *
+ * Devuelve la cantidad de elementos encontrados.
+ */
+size_t abb_buscar_lote(abb_t *arbol, void **claves, size_t n,
+		       void **resultados);
+
 /**
  * Determina si el árbol está vacío.
  *
@@ -75,6 +265,13 @@ size_t abb_tamanio(abb_t *arbol);
  *
  * Recorrido especifica el tipo de recorrido a realizar.
  *
+ * No usa recursión: recorre con una pila local, o si el arbol no está
+ * balanceado y es más alto que 128 niveles, con una pila reservada del alto
+ * del arbol. Solo si no hay memoria para esa pila lo recorre como
+ * abb_recorrer, enlazando temporalmente algunos nodos entre sí, y en ese caso
+ * la función no debe usar el arbol y no puede recorrerse a la vez desde otro
+ * hilo.
+ *
  * Devuelve la cantidad de veces que fue invocada la función.
 */
 size_t abb_con_cada_elemento(abb_t *arbol, abb_recorrido recorrido,
@@ -87,12 +284,133 @@ size_t abb_con_cada_elemento(abb_t *arbol, abb_recorrido recorrido,
  *
  * El array tiene un tamaño maximo especificado por tamanio_array.
  *
+ * No reserva memoria. Si el arbol no está balanceado y es más alto que la
+ * pila que usa (128 niveles), lo recorre enlazando temporalmente algunos
+ * nodos entre sí y lo deja como estaba al terminar, así que en ese caso no
+ * puede recorrerse a la vez desde otro hilo.
+ *
  * Devuelve la cantidad de elementos que fueron almacenados exitosamente en el
  * array.
  */
 size_t abb_recorrer(abb_t *arbol, abb_recorrido recorrido, void **array,
 		    size_t tamanio_array);
 
+/**
+ * Invoca la funcion con cada elemento del arbol que esté entre minimo y maximo
+ * (inclusive, según el comparador), en orden de menor a mayor. El puntero aux
+ * se pasa como segundo parámetro a la función. Si la función devuelve false,
+ * se finaliza el recorrido aun si quedan elementos en el rango.
+ *
+ * Los sub-árboles que quedan fuera del rango no se recorren, así que en un
+ * arbol balanceado cuesta O(log n + k), siendo k la cantidad de elementos en
+ * el rango. No reserva memoria, salvo que el arbol no esté balanceado y sea
+ * más alto que 128 niveles.
+ *
+ * Devuelve la cantidad de veces que fue invocada la función.
+ */
+size_t abb_rango(abb_t *arbol, void *minimo, void *maximo,
+		 bool (*funcion)(void *, void *), void *aux);
+
+/**
+ * Almacena en el array, de menor a mayor, los elementos del arbol que están
+ * entre minimo y maximo (inclusive), hasta completar el rango o quedarse sin
+ * espacio en el array.
+ *
+ * El array tiene un tamaño maximo especificado por tamanio_array.
+ *
+ * Devuelve la cantidad de elementos que fueron almacenados en el array.
+ */
+size_t abb_rango_recorrer(abb_t *arbol, void *minimo, void *maximo,
+			  void **array, size_t tamanio_array);
+
+/**
+ * Devuelve la cantidad de elementos del arbol que están entre minimo y maximo
+ * (inclusive), o 0 si el arbol es NULL. Es lo mismo que abb_contar_entre.
+ */
+size_t abb_rango_contar(abb_t *arbol, void *minimo, void *maximo);
+
+/**
+ * Devuelve el elemento que ocupa la posición k (empezando en 0) en el orden
+ * del arbol, es decir, el k-ésimo menor, o NULL si el arbol tiene k elementos
+ * o menos.
+ *
+ * Cada nodo guarda la cantidad de elementos de su sub-árbol, por lo que esta
+ * función y las dos siguientes cuestan O(altura).
+ */
+void *abb_seleccionar(abb_t *arbol, size_t k);
+
+/**
+ * Devuelve la cantidad de elementos del arbol estrictamente menores al
+ * recibido, que es la posición que ocupa (o que ocuparía) el elemento en el
+ * orden del arbol. Devuelve 0 si el arbol es NULL.
+ */
+size_t abb_rango_de(abb_t *arbol, void *elemento);
+
+/**
+ * Devuelve la cantidad de elementos del arbol que están entre a y b
+ * (inclusive), o 0 si a es mayor que b o el arbol es NULL.
+ */
+size_t abb_contar_entre(abb_t *arbol, void *a, void *b);
+
+/**
+ * Devuelve el mayor elemento del arbol que es menor o igual al recibido, o
+ * NULL si no hay ninguno o el arbol es NULL.
+ *
+ * Esta función y las tres siguientes bajan una sola vez desde la raíz,
+ * invocando el comparador una vez por nivel.
+ */
+void *abb_piso(abb_t *arbol, void *elemento);
+
+/**
+ * Devuelve el menor elemento del arbol que es mayor o igual al recibido, o
+ * NULL si no hay ninguno o el arbol es NULL.
+ */
+void *abb_techo(abb_t *arbol, void *elemento);
+
+/**
+ * Devuelve el mayor elemento del arbol que es estrictamente menor al
+ * recibido, o NULL si no hay ninguno o el arbol es NULL.
+ */
+void *abb_predecesor(abb_t *arbol, void *elemento);
+
+/**
+ * Devuelve el menor elemento del arbol que es estrictamente mayor al
+ * recibido, o NULL si no hay ninguno o el arbol es NULL.
+ */
+void *abb_sucesor(abb_t *arbol, void *elemento);
+
+/**
+ * Crea un iterador externo que recorre el arbol según el recorrido
+ * especificado, de a un elemento por vez con abb_iterador_siguiente. Permite
+ * pausar un recorrido y retomarlo más tarde, o recorrer varios arboles a la
+ * vez, sin copiar los elementos.
+ *
+ * El iterador reserva de una sola vez una pila acotada por la altura del
+ * arbol, y no reserva memoria al avanzar. Cada paso cuesta O(1) amortizado.
+ * Si se inserta o se quita un elemento del arbol, el iterador deja de ser
+ * válido y solo se puede destruir.
+ *
+ * Devuelve el iterador o NULL en caso de error.
+ */
+abb_iterador_t *abb_iterador_crear(abb_t *arbol, abb_recorrido recorrido);
+
+/**
+ * Devuelve true si al iterador le quedan elementos por recorrer, o false si
+ * ya los recorrió todos o es NULL.
+ */
+bool abb_iterador_tiene_siguiente(abb_iterador_t *iterador);
+
+/**
+ * Avanza el iterador y devuelve el siguiente elemento del recorrido, o NULL si
+ * no quedan elementos.
+ */
+void *abb_iterador_siguiente(abb_iterador_t *iterador);
+
+/**
+ * Destruye el iterador. No modifica el arbol.
+ */
+void abb_iterador_destruir(abb_iterador_t *iterador);
+
 /**
  * Destruye el arbol liberando la memoria reservada por el mismo.
  */
@@ -0,0 +1,456 @@
+#include "abb_archivo.h"
+#include "abb_estructura_privada.h"
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define ARCHIVO_FIRMA "TDA-ABB"
+#define ARCHIVO_VERSION 2
+#define ARCHIVO_ALINEACION 8
+#define ARCHIVO_BUFFER 65536
+#define ARCHIVO_NIVELES_PRECARGA 3
+#define FNV_BASE UINT64_C(0xcbf29ce484222325)
+#define FNV_PRIMO UINT64_C(0x100000001b3)
+
+/**
+ * Cabecera del archivo, que ocupa justo 64 bytes. Después vienen los
+ * cantidad + 1 desplazamientos (uint64_t) y los bytes_datos bytes de datos.
+ * La suma es la de suma_agregar sobre los datos seguidos de los
+ * desplazamientos.
+*/
+struct cabecera_archivo {
+	char firma[8];
+	uint32_t version;
+	uint32_t alineacion;
+	uint64_t cantidad;
+	uint64_t bytes_datos;
+	uint64_t suma;
+	uint64_t reservado[3];
+};
+
+/**
+ * Buffer donde se serializan los elementos, que crece cuando el serializador
+ * pide más lugar.
+*/
+struct serializacion {
+	abb_serializador serializador;
+	char *buffer;
+	size_t capacidad;
+};
+
+/**
+ * Buffer de escritura del archivo, para no hacer una llamada a write por
+ * cada elemento.
+*/
+struct escritura_archivo {
+	int fd;
+	char buffer[ARCHIVO_BUFFER];
+	size_t usados;
+};
+
+/**
+ * Recibe una suma parcial y una palabra de 64 bits, y devuelve la suma con la
+ * palabra agregada: la mezcla como FNV-1a mezcla un byte, y después pliega
+ * los bits altos sobre los bajos, que si no solo dependerían de los bits
+ * bajos de las palabras.
+*/
+uint64_t suma_palabra(uint64_t suma, uint64_t palabra)
+{
+	suma = (suma ^ palabra) * FNV_PRIMO;
+	return suma ^ (suma >> 32);
+}
+
+/**
+ * Recibe una suma parcial y un tramo de bytes, y devuelve la suma con esos
+ * bytes agregados de a palabras de 64 bits. Si el tramo no ocupa palabras
+ * enteras, la última se completa con ceros, así que es lo mismo que agregar
+ * el tramo seguido de su relleno.
+*/
+uint64_t suma_agregar(uint64_t suma, const void *bytes, size_t cantidad)
+{
+	const char *actual = bytes;
+	uint64_t palabra;
+	for (; cantidad >= sizeof(palabra); cantidad -= sizeof(palabra)) {
+		memcpy(&palabra, actual, sizeof(palabra));
+		suma = suma_palabra(suma, palabra);
+		actual += sizeof(palabra);
+	}
+	if (cantidad > 0) {
+		palabra = 0;
+		memcpy(&palabra, actual, cantidad);
+		suma = suma_palabra(suma, palabra);
+	}
+	return suma;
+}
+
+/**
+ * Recibe un tamaño y devuelve cuántos bytes de relleno le faltan para ser
+ * múltiplo de ARCHIVO_ALINEACION.
+*/
+size_t archivo_relleno(size_t tamanio)
+{
+	return (ARCHIVO_ALINEACION - tamanio % ARCHIVO_ALINEACION) %
+	       ARCHIVO_ALINEACION;
+}
+
+/**
+ * Recibe los elementos ordenados, el array donde van por niveles, su
+ * cantidad, una posición de Eytzinger y el índice del próximo ordenado. Llena
+ * el sub-árbol de la posición en inorden (como congelado_llenar), dejando el
+ * elemento de la posición k en niveles[k - 1].
+*/
+void ordenar_por_niveles(void **ordenados, void **niveles, size_t cantidad,
+			 size_t posicion, size_t *siguiente)
+{
+	if (posicion > cantidad)
+		return;
+	ordenar_por_niveles(ordenados, niveles, cantidad, 2 * posicion,
+			    siguiente);
+	niveles[posicion - 1] = ordenados[(*siguiente)++];
+	ordenar_por_niveles(ordenados, niveles, cantidad, 2 * posicion + 1,
+			    siguiente);
+}
+
+/**
+ * Recibe el estado de serialización, un elemento y un puntero donde guardar
+ * su tamaño, y lo serializa, agrandando el buffer si hace falta. Devuelve
+ * los bytes del elemento (que valen hasta la próxima llamada), o NULL en
+ * caso de error.
+*/
+const char *serializar(struct serializacion *serializacion, void *elemento,
+		       size_t *tamanio)
+{
+	*tamanio = serializacion->serializador(
+		elemento, serializacion->buffer, serializacion->capacidad);
+	if (*tamanio <= serializacion->capacidad)
+		return serializacion->buffer;
+	size_t capacidad = 2 * serializacion->capacidad;
+	if (capacidad < *tamanio)
+		capacidad = *tamanio;
+	char *buffer = realloc(serializacion->buffer, capacidad);
+	if (!buffer)
+		return NULL;
+	serializacion->buffer = buffer;
+	serializacion->capacidad = capacidad;
+	size_t necesario = *tamanio;
+	*tamanio = serializacion->serializador(elemento, buffer, capacidad);
+	return *tamanio == necesario ? buffer : NULL;
+}
+
+/**
+ * Recibe un fd y un tramo de bytes, y los escribe todos, reintentando si
+ * write escribe una parte. Devuelve false en caso de error.
+*/
+bool escribir_todo(int fd, const void *bytes, size_t cantidad)
+{
+	const char *actual = bytes;
+	while (cantidad > 0) {
+		ssize_t escritos = write(fd, actual, cantidad);
+		if (escritos <= 0)
+			return false;
+		actual += escritos;
+		cantidad -= (size_t)escritos;
+	}
+	return true;
+}
+
+/**
+ * Recibe el buffer de escritura y un tramo de bytes, y los agrega al buffer,
+ * escribiéndolo en el archivo cada vez que se llena. Devuelve false en caso
+ * de error.
+*/
+bool escritura_agregar(struct escritura_archivo *escritura, const void *bytes,
+		       size_t cantidad)
+{
+	const char *actual = bytes;
+	while (cantidad > 0) {
+		size_t libres = ARCHIVO_BUFFER - escritura->usados;
+		size_t copiar = cantidad < libres ? cantidad : libres;
+		memcpy(escritura->buffer + escritura->usados, actual, copiar);
+		escritura->usados += copiar;
+		actual += copiar;
+		cantidad -= copiar;
+		if (escritura->usados == ARCHIVO_BUFFER) {
+			if (!escribir_todo(escritura->fd, escritura->buffer,
+					   escritura->usados))
+				return false;
+			escritura->usados = 0;
+		}
+	}
+	return true;
+}
+
+/**
+ * Recibe los elementos por niveles, su cantidad, el estado de serialización,
+ * el array de desplazamientos y un puntero a una suma, y serializa cada
+ * elemento para calcular dónde empieza el siguiente. Guarda en suma la de
+ * los datos, que todavía no incluye los desplazamientos. Como cada elemento
+ * empieza alineado a 8 bytes, sumarlos de a uno es lo mismo que sumar todos
+ * los datos juntos. Devuelve false en caso de error.
+*/
+bool medir_elementos(void **niveles, size_t cantidad,
+		     struct serializacion *serializacion,
+		     uint64_t *desplazamientos, uint64_t *suma)
+{
+	*suma = FNV_BASE;
+	desplazamientos[0] = 0;
+	for (size_t i = 0; i < cantidad; i++) {
+		size_t tamanio;
+		const char *bytes =
+			serializar(serializacion, niveles[i], &tamanio);
+		if (!bytes)
+			return false;
+		size_t relleno = archivo_relleno(tamanio);
+		*suma = suma_agregar(*suma, bytes, tamanio);
+		desplazamientos[i + 1] = desplazamientos[i] + tamanio + relleno;
+	}
+	return true;
+}
+
+/**
+ * Igual que medir_elementos, pero escribe los elementos serializados en el
+ * archivo. Devuelve false en caso de error o si algún elemento no ocupa lo
+ * mismo que cuando se midió.
+*/
+bool escribir_elementos(void **niveles, size_t cantidad,
+			struct serializacion *serializacion,
+			const uint64_t *desplazamientos, int fd)
+{
+	static const char ceros[ARCHIVO_ALINEACION];
+	struct escritura_archivo *escritura =
+		malloc(sizeof(struct escritura_archivo));
+	if (!escritura)
+		return false;
+	escritura->fd = fd;
+	escritura->usados = 0;
+	bool ok = true;
+	for (size_t i = 0; i < cantidad && ok; i++) {
+		size_t tamanio;
+		const char *bytes =
+			serializar(serializacion, niveles[i], &tamanio);
+		size_t relleno = archivo_relleno(tamanio);
+		ok = bytes &&
+		     desplazamientos[i] + tamanio + relleno ==
+			     desplazamientos[i + 1] &&
+		     escritura_agregar(escritura, bytes, tamanio) &&
+		     escritura_agregar(escritura, ceros, relleno);
+	}
+	ok = ok && escribir_todo(fd, escritura->buffer, escritura->usados);
+	free(escritura);
+	return ok;
+}
+
+bool abb_guardar(abb_t *arbol, int fd, abb_serializador serializador)
+{
+	if (!arbol || fd < 0 || !serializador)
+		return false;
+	size_t cantidad = abb_tamanio(arbol);
+	if (cantidad >= SIZE_MAX / (2 * sizeof(uint64_t)))
+		return false;
+	void **ordenados = malloc(2 * cantidad * sizeof(void *));
+	uint64_t *desplazamientos =
+		malloc((cantidad + 1) * sizeof(uint64_t));
+	struct serializacion serializacion = { .serializador = serializador };
+	uint64_t suma;
+	bool ok = (ordenados || cantidad == 0) && desplazamientos &&
+		  abb_recorrer(arbol, INORDEN, ordenados, cantidad) == cantidad;
+	void **niveles = NULL;
+	if (ok) {
+		niveles = ordenados + cantidad;
+		size_t siguiente = 0;
+		ordenar_por_niveles(ordenados, niveles, cantidad, 1,
+				    &siguiente);
+		ok = medir_elementos(niveles, cantidad, &serializacion,
+				     desplazamientos, &suma);
+	}
+	if (ok) {
+		struct cabecera_archivo cabecera = {
+			.firma = ARCHIVO_FIRMA,
+			.version = ARCHIVO_VERSION,
+			.alineacion = ARCHIVO_ALINEACION,
+			.cantidad = cantidad,
+			.bytes_datos = desplazamientos[cantidad],
+			.suma = suma_agregar(suma, desplazamientos,
+					     (cantidad + 1) * sizeof(uint64_t))
+		};
+		ok = escribir_todo(fd, &cabecera, sizeof(cabecera)) &&
+		     escribir_todo(fd, desplazamientos,
+				   (cantidad + 1) * sizeof(uint64_t)) &&
+		     escribir_elementos(niveles, cantidad, &serializacion,
+					desplazamientos, fd);
+	}
+	free(serializacion.buffer);
+	free(desplazamientos);
+	free(ordenados);
+	return ok;
+}
+
+/**
+ * Recibe un archivo mapeado y su tamaño, y verifica que tenga la cabecera,
+ * los tamaños y los desplazamientos que escribe abb_guardar, que alcanzan
+ * para que buscar no lea fuera del archivo. La suma de los datos la verifica
+ * abb_verificar_mmap. Devuelve la cabecera si es válido, o NULL si no.
+*/
+const struct cabecera_archivo *validar_archivo(const char *mapa, size_t bytes)
+{
+	const struct cabecera_archivo *cabecera =
+		(const struct cabecera_archivo *)mapa;
+	if (bytes < sizeof(*cabecera) + sizeof(uint64_t) ||
+	    memcmp(cabecera->firma, ARCHIVO_FIRMA, sizeof(ARCHIVO_FIRMA)) != 0 ||
+	    cabecera->version != ARCHIVO_VERSION ||
+	    cabecera->alineacion != ARCHIVO_ALINEACION)
+		return NULL;
+	size_t lugar = (bytes - sizeof(*cabecera)) / sizeof(uint64_t) - 1;
+	if (cabecera->cantidad > lugar ||
+	    cabecera->bytes_datos != bytes - sizeof(*cabecera) -
+					     (cabecera->cantidad + 1) *
+						     sizeof(uint64_t) ||
+	    cabecera->bytes_datos % ARCHIVO_ALINEACION != 0)
+		return NULL;
+	const uint64_t *desplazamientos =
+		(const uint64_t *)(mapa + sizeof(*cabecera));
+	size_t cantidad = cabecera->cantidad;
+	if (desplazamientos[0] != 0 ||
+	    desplazamientos[cantidad] != cabecera->bytes_datos)
+		return NULL;
+	for (size_t i = 0; i < cantidad; i++)
+		if (desplazamientos[i] > desplazamientos[i + 1])
+			return NULL;
+	return cabecera;
+}
+
+abb_t *abb_cargar_mmap(const char *ruta, abb_comparador comparador)
+{
+	if (!ruta || !comparador)
+		return NULL;
+	int fd = open(ruta, O_RDONLY);
+	if (fd < 0)
+		return NULL;
+	struct stat estado;
+	void *mapa = MAP_FAILED;
+	if (fstat(fd, &estado) == 0 && estado.st_size > 0)
+		mapa = mmap(NULL, (size_t)estado.st_size, PROT_READ,
+			    MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (mapa == MAP_FAILED)
+		return NULL;
+	size_t bytes = (size_t)estado.st_size;
+	const struct cabecera_archivo *cabecera = validar_archivo(mapa, bytes);
+	abb_t *arbol = cabecera ? calloc(1, sizeof(struct abb)) : NULL;
+	struct abb_mapeado *mapeado =
+		arbol ? malloc(sizeof(struct abb_mapeado)) : NULL;
+	if (!mapeado) {
+		free(arbol);
+		munmap(mapa, bytes);
+		return NULL;
+	}
+	mapeado->mapa = mapa;
+	mapeado->bytes = bytes;
+	mapeado->desplazamientos =
+		(const uint64_t *)((const char *)mapa + sizeof(*cabecera));
+	mapeado->datos = (const char *)(mapeado->desplazamientos +
+					cabecera->cantidad + 1);
+	arbol->comparador = comparador;
+	arbol->tamanio = cabecera->cantidad;
+	arbol->mapeado = mapeado;
+	return arbol;
+}
+
+bool abb_verificar_mmap(abb_t *arbol)
+{
+	if (!arbol || !arbol->mapeado)
+		return false;
+	struct abb_mapeado *mapeado = arbol->mapeado;
+	const struct cabecera_archivo *cabecera = mapeado->mapa;
+	uint64_t suma = suma_agregar(FNV_BASE, mapeado->datos,
+				     cabecera->bytes_datos);
+	suma = suma_agregar(suma, mapeado->desplazamientos,
+			    (cabecera->cantidad + 1) * sizeof(uint64_t));
+	return suma == cabecera->suma;
+}
+
+/**
+ * Recibe un arbol mapeado y una posición de Eytzinger (entre 1 y la
+ * cantidad), y devuelve un puntero a los bytes del elemento de esa posición.
+*/
+void *mapeado_elemento(struct abb_mapeado *mapeado, size_t posicion)
+{
+	return (void *)(mapeado->datos +
+			mapeado->desplazamientos[posicion - 1]);
+}
+
+void *mapeado_buscar(abb_t *arbol, void *elemento)
+{
+	struct abb_mapeado *mapeado = arbol->mapeado;
+	size_t cantidad = arbol->tamanio;
+	size_t posicion = 1;
+	while (posicion <= cantidad) {
+		__builtin_prefetch(mapeado->desplazamientos +
+				   (posicion << ARCHIVO_NIVELES_PRECARGA));
+		posicion = 2 * posicion +
+			   (comparar(arbol, mapeado_elemento(mapeado, posicion),
+				     elemento) < 0);
+	}
+	/**
+	 * Igual que en abb_congelado_buscar, el primer elemento mayor o igual
+	 * al buscado es el último donde se bajó a la izquierda.
+	*/
+	posicion >>= __builtin_ffsll((long long)~posicion);
+	if (posicion == 0)
+		return NULL;
+	void *encontrado = mapeado_elemento(mapeado, posicion);
+	return comparar(arbol, encontrado, elemento) == 0 ? encontrado : NULL;
+}
+
+/**
+ * Recibe un arbol mapeado, una posición de Eytzinger, un recorrido, la
+ * función con su aux y un contador, y recorre el sub-árbol de la posición
+ * (cuyos hijos son 2k y 2k + 1) invocando la función con cada elemento.
+ * Devuelve false si la función devolvió false.
+*/
+bool recorrer_mapeado(abb_t *arbol, size_t posicion, abb_recorrido recorrido,
+		      bool (*funcion)(void *, void *), void *aux,
+		      size_t *contador)
+{
+	if (posicion > arbol->tamanio)
+		return true;
+	void *elemento = mapeado_elemento(arbol->mapeado, posicion);
+	if (recorrido == PREORDEN) {
+		(*contador)++;
+		if (!funcion(elemento, aux))
+			return false;
+	}
+	if (!recorrer_mapeado(arbol, 2 * posicion, recorrido, funcion, aux,
+			      contador))
+		return false;
+	if (recorrido == INORDEN) {
+		(*contador)++;
+		if (!funcion(elemento, aux))
+			return false;
+	}
+	if (!recorrer_mapeado(arbol, 2 * posicion + 1, recorrido, funcion, aux,
+			      contador))
+		return false;
+	if (recorrido == POSTORDEN) {
+		(*contador)++;
+		return funcion(elemento, aux);
+	}
+	return true;
+}
+
+size_t mapeado_con_cada_elemento(abb_t *arbol, abb_recorrido recorrido,
+				 bool (*funcion)(void *, void *), void *aux)
+{
+	size_t contador = 0;
+	recorrer_mapeado(arbol, 1, recorrido, funcion, aux, &contador);
+	return contador;
+}
+
+void mapeado_liberar(abb_t *arbol)
+{
+	munmap(arbol->mapeado->mapa, arbol->mapeado->bytes);
+	free(arbol->mapeado);
+}
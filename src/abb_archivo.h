@@ -0,0 +1,61 @@
+#ifndef __ABB_ARCHIVO__H__
+#define __ABB_ARCHIVO__H__
+
+#include "abb.h"
+
+/**
+ * Recibe un elemento, un buffer y su tamaño, y escribe en el buffer los bytes
+ * que representan al elemento, solo si entran. Devuelve la cantidad de bytes
+ * que ocupa el elemento (aunque no hayan entrado, para que se pueda volver a
+ * llamar con un buffer más grande). Tiene que escribir siempre lo mismo para
+ * el mismo elemento.
+ */
+typedef size_t (*abb_serializador)(void *elemento, void *buffer,
+				   size_t tamanio);
+
+/**
+ * Escribe en el archivo abierto fd, desde su posición actual, una foto del
+ * arbol que se puede cargar con abb_cargar_mmap (si el archivo empieza ahí,
+ * por ejemplo si se acaba de crear). El archivo tiene una cabecera con una
+ * firma, la versión del formato, la cantidad de elementos y una suma de
+ * verificación de 64 bits (FNV-1a aplicado de a palabras de 8 bytes), y
+ * después los elementos serializados en el orden por niveles de un arbol
+ * completo (el de abb_congelar), cada uno alineado a 8 bytes.
+ *
+ * Los enteros del archivo se guardan en el orden de bytes de la máquina, así
+ * que solo se puede cargar en una con el mismo orden.
+ *
+ * Devuelve true si pudo escribir todo, o false en caso de error (y en ese
+ * caso lo que haya escrito no se puede cargar).
+ */
+bool abb_guardar(abb_t *arbol, int fd, abb_serializador serializador);
+
+/**
+ * Mapea en memoria (de solo lectura) el archivo escrito con abb_guardar y
+ * devuelve un arbol que busca directamente en las páginas del archivo, sin
+ * leerlo ni insertar nada: el comparador recibe punteros a los bytes que
+ * escribió el serializador. Solo se verifican la cabecera y los
+ * desplazamientos de los elementos, que alcanzan para que buscar no lea fuera
+ * del archivo; los datos no se leen hasta que se buscan, así que para
+ * detectar un archivo dañado hay que llamar a abb_verificar_mmap.
+ *
+ * El arbol cargado admite abb_buscar, abb_buscar_lote, abb_tamanio,
+ * abb_vacio, abb_con_cada_elemento y abb_recorrer, y se libera con
+ * abb_destruir (abb_destruir_todo no invoca el destructor, ya que los
+ * elementos son parte del archivo). Las operaciones que lo modifican
+ * devuelven NULL o false, y las demás consultas lo tratan como vacío.
+ *
+ * Devuelve el arbol o NULL en caso de error, o si el archivo no tiene el
+ * formato o la versión esperados.
+ */
+abb_t *abb_cargar_mmap(const char *ruta, abb_comparador comparador);
+
+/**
+ * Recorre el archivo entero de un arbol cargado con abb_cargar_mmap y
+ * verifica que su suma coincida con la que escribió abb_guardar.
+ *
+ * Devuelve true si coincide, o false si no, o si el arbol no es uno mapeado.
+ */
+bool abb_verificar_mmap(abb_t *arbol);
+
+#endif // __ABB_ARCHIVO__H__
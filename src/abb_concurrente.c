@@ -0,0 +1,159 @@
+#include "abb_concurrente.h"
+#include "abb_estructura_privada.h"
+#include <sched.h>
+#include <string.h>
+
+/**
+ * Ranura de lectores de cada hilo, que se elige la primera vez que lee
+ * repartiendo los hilos en orden entre las ranuras.
+ */
+static _Thread_local size_t ranura_del_hilo = CONCURRENTE_RANURAS;
+static atomic_size_t proxima_ranura;
+
+abb_concurrente_t *abb_concurrente_crear(abb_t *arbol)
+{
+	if (!arbol)
+		return NULL;
+	abb_concurrente_t *concurrente =
+		aligned_alloc(CONCURRENTE_LINEA_CACHE, sizeof(*concurrente));
+	if (!concurrente)
+		return NULL;
+	memset(concurrente, 0, sizeof(*concurrente));
+	if (pthread_mutex_init(&concurrente->escritores, NULL) != 0) {
+		free(concurrente);
+		return NULL;
+	}
+	concurrente->arbol = arbol;
+	atomic_init(&concurrente->escribiendo, false);
+	for (size_t i = 0; i < CONCURRENTE_RANURAS; i++)
+		atomic_init(&concurrente->ranuras[i].lectores, 0);
+	return concurrente;
+}
+
+/**
+ * Recibe un envoltorio y anota al hilo actual como lector en su ranura,
+ * esperando si hay un escritor. Devuelve la ranura, que hay que pasarle a
+ * concurrente_salir_lector.
+ *
+ * Primero incrementa el contador y después mira si hay un escritor, y el
+ * escritor primero se anota y después mira los contadores (las dos cosas con
+ * orden secuencialmente consistente), así que al menos uno de los dos ve al
+ * otro: o el lector ve al escritor y se retira, o el escritor espera al
+ * lector.
+*/
+struct ranura_lectores *concurrente_entrar_lector(abb_concurrente_t *concurrente)
+{
+	if (ranura_del_hilo == CONCURRENTE_RANURAS)
+		ranura_del_hilo = atomic_fetch_add_explicit(
+					  &proxima_ranura, 1,
+					  memory_order_relaxed) %
+				  CONCURRENTE_RANURAS;
+	struct ranura_lectores *ranura =
+		&concurrente->ranuras[ranura_del_hilo];
+	while (true) {
+		atomic_fetch_add(&ranura->lectores, 1);
+		if (!atomic_load(&concurrente->escribiendo))
+			return ranura;
+		atomic_fetch_sub(&ranura->lectores, 1);
+		while (atomic_load_explicit(&concurrente->escribiendo,
+					    memory_order_relaxed))
+			sched_yield();
+	}
+}
+
+/**
+ * Recibe la ranura devuelta por concurrente_entrar_lector y saca al hilo
+ * actual de los lectores.
+*/
+void concurrente_salir_lector(struct ranura_lectores *ranura)
+{
+	atomic_fetch_sub_explicit(&ranura->lectores, 1, memory_order_release);
+}
+
+/**
+ * Recibe un envoltorio y toma el arbol para escribir: espera a los demás
+ * escritores, se anota como escritor y espera a que salgan todos los
+ * lectores.
+*/
+void concurrente_entrar_escritor(abb_concurrente_t *concurrente)
+{
+	pthread_mutex_lock(&concurrente->escritores);
+	atomic_store(&concurrente->escribiendo, true);
+	for (size_t i = 0; i < CONCURRENTE_RANURAS; i++)
+		while (atomic_load(&concurrente->ranuras[i].lectores) != 0)
+			sched_yield();
+}
+
+/**
+ * Recibe un envoltorio tomado con concurrente_entrar_escritor y lo libera.
+*/
+void concurrente_salir_escritor(abb_concurrente_t *concurrente)
+{
+	atomic_store_explicit(&concurrente->escribiendo, false,
+			      memory_order_release);
+	pthread_mutex_unlock(&concurrente->escritores);
+}
+
+bool abb_concurrente_insertar(abb_concurrente_t *concurrente, void *elemento)
+{
+	if (!concurrente)
+		return false;
+	concurrente_entrar_escritor(concurrente);
+	abb_t *arbol = abb_insertar(concurrente->arbol, elemento);
+	concurrente_salir_escritor(concurrente);
+	return arbol != NULL;
+}
+
+void *abb_concurrente_quitar(abb_concurrente_t *concurrente, void *elemento)
+{
+	if (!concurrente)
+		return NULL;
+	concurrente_entrar_escritor(concurrente);
+	void *quitado = abb_quitar(concurrente->arbol, elemento);
+	concurrente_salir_escritor(concurrente);
+	return quitado;
+}
+
+void *abb_concurrente_buscar(abb_concurrente_t *concurrente, void *elemento)
+{
+	if (!concurrente)
+		return NULL;
+	struct ranura_lectores *ranura = concurrente_entrar_lector(concurrente);
+	void *encontrado = abb_buscar(concurrente->arbol, elemento);
+	concurrente_salir_lector(ranura);
+	return encontrado;
+}
+
+size_t abb_concurrente_tamanio(abb_concurrente_t *concurrente)
+{
+	if (!concurrente)
+		return 0;
+	struct ranura_lectores *ranura = concurrente_entrar_lector(concurrente);
+	size_t tamanio = abb_tamanio(concurrente->arbol);
+	concurrente_salir_lector(ranura);
+	return tamanio;
+}
+
+size_t abb_concurrente_con_cada_elemento(abb_concurrente_t *concurrente,
+					 abb_recorrido recorrido,
+					 bool (*funcion)(void *, void *),
+					 void *aux)
+{
+	if (!concurrente)
+		return 0;
+	struct ranura_lectores *ranura = concurrente_entrar_lector(concurrente);
+	size_t invocaciones = abb_con_cada_elemento(concurrente->arbol,
+						    recorrido, funcion, aux);
+	concurrente_salir_lector(ranura);
+	return invocaciones;
+}
+
+void abb_concurrente_destruir(abb_concurrente_t *concurrente,
+			      void (*destructor)(void *))
+{
+	if (!concurrente)
+		return;
+	abb_destruir_todo(concurrente->arbol, destructor);
+	pthread_mutex_destroy(&concurrente->escritores);
+	free(concurrente);
+}
@@ -0,0 +1,73 @@
+#ifndef __ABB_CONCURRENTE__H__
+#define __ABB_CONCURRENTE__H__
+
+#include "abb.h"
+
+typedef struct abb_concurrente abb_concurrente_t;
+
+/**
+ * Envuelve un arbol (de cualquier tipo) para poder compartirlo entre hilos
+ * que casi siempre leen. Los lectores no se bloquean entre sí: cada hilo anota
+ * que está leyendo en un contador de una de varias ranuras, cada una en su
+ * propia línea de cache, así las lecturas de distintos hilos no escriben en
+ * la misma memoria. Un escritor marca que quiere escribir, espera a que todos
+ * los contadores queden en cero y modifica el arbol; los escritores se
+ * excluyen entre sí con un mutex.
+ *
+ * El arbol pasa a ser del envoltorio: no debe usarse directamente mientras
+ * haya hilos usándolo a través de él, y se destruye junto con el envoltorio.
+ * Hace falta compilar con -pthread.
+ *
+ * Devuelve el envoltorio o NULL en caso de error.
+ */
+abb_concurrente_t *abb_concurrente_crear(abb_t *arbol);
+
+/**
+ * Inserta un elemento en el arbol (ver abb_insertar), excluyendo a los
+ * lectores y a los demás escritores.
+ *
+ * Devuelve true si lo pudo insertar o false en caso de error.
+ */
+bool abb_concurrente_insertar(abb_concurrente_t *concurrente, void *elemento);
+
+/**
+ * Quita un elemento del arbol (ver abb_quitar), excluyendo a los lectores y
+ * a los demás escritores.
+ *
+ * Devuelve el elemento quitado o NULL si no lo encuentra.
+ */
+void *abb_concurrente_quitar(abb_concurrente_t *concurrente, void *elemento);
+
+/**
+ * Busca un elemento en el arbol (ver abb_buscar). Puede ejecutarse a la vez
+ * que otras búsquedas y recorridos.
+ *
+ * Devuelve el elemento encontrado o NULL si no lo encuentra.
+ */
+void *abb_concurrente_buscar(abb_concurrente_t *concurrente, void *elemento);
+
+/**
+ * Devuelve la cantidad de elementos del arbol, o 0 si el envoltorio es NULL.
+ */
+size_t abb_concurrente_tamanio(abb_concurrente_t *concurrente);
+
+/**
+ * Recorre el arbol como abb_con_cada_elemento, como un lector más: la función
+ * no puede modificar el arbol, y los escritores esperan a que termine.
+ *
+ * Devuelve la cantidad de veces que fue invocada la función.
+ */
+size_t abb_concurrente_con_cada_elemento(abb_concurrente_t *concurrente,
+					 abb_recorrido recorrido,
+					 bool (*funcion)(void *, void *),
+					 void *aux);
+
+/**
+ * Destruye el envoltorio y el arbol, invocando el destructor con cada
+ * elemento si no es NULL (ver abb_destruir_todo). No puede haber otros hilos
+ * usándolo.
+ */
+void abb_concurrente_destruir(abb_concurrente_t *concurrente,
+			      void (*destructor)(void *));
+
+#endif // __ABB_CONCURRENTE__H__
@@ -0,0 +1,269 @@
+#include "abb_congelado.h"
+#include "abb_estructura_privada.h"
+#include <stdint.h>
+#include <stdlib.h>
+
+#define CONGELADO_ALINEACION 64
+/**
+ * Cantidad de niveles que se precargan por adelantado. Los descendientes de
+ * la posición k a 3 niveles de distancia son las 8 posiciones contiguas a
+ * partir de 8k, que ocupan exactamente una línea de cache de 64 bytes.
+*/
+#define CONGELADO_NIVELES_PRECARGA 3
+#define VEB_NINGUNO UINT32_MAX
+
+/**
+ * Recibe un arbol no vacío y devuelve un array nuevo con sus elementos en
+ * orden, copiados con abb_recorrer (que, a diferencia del iterador, también
+ * recorre los arboles multiclave y los mapeados), o NULL en caso de error.
+*/
+void **congelado_ordenados(abb_t *arbol)
+{
+	void **ordenados = malloc(arbol->tamanio * sizeof(void *));
+	if (ordenados &&
+	    abb_recorrer(arbol, INORDEN, ordenados, arbol->tamanio) !=
+		    arbol->tamanio) {
+		free(ordenados);
+		return NULL;
+	}
+	return ordenados;
+}
+
+/**
+ * Recibe una foto con el array de elementos reservado, los elementos del
+ * arbol original en orden, un puntero al índice del próximo a ubicar y una
+ * posición. Llena recursivamente el sub-árbol de esa posición en orden
+ * inorden (primero el hijo izquierdo 2k, después la posición k y por último
+ * el hijo derecho 2k + 1), de manera que al terminar el array queda en orden
+ * de Eytzinger.
+*/
+void congelado_llenar(abb_congelado_t *congelado, void **ordenados,
+		      size_t *siguiente, size_t posicion)
+{
+	if (posicion > congelado->cantidad)
+		return;
+	congelado_llenar(congelado, ordenados, siguiente, 2 * posicion);
+	congelado->elementos[posicion] = ordenados[(*siguiente)++];
+	congelado_llenar(congelado, ordenados, siguiente, 2 * posicion + 1);
+}
+
+abb_congelado_t *abb_congelar(abb_t *arbol)
+{
+	if (!arbol)
+		return NULL;
+	abb_congelado_t *congelado = calloc(1, sizeof(abb_congelado_t));
+	if (!congelado)
+		return NULL;
+	congelado->comparador = arbol->comparador;
+	congelado->cantidad = arbol->tamanio;
+	/**
+	 * La posición 0 no se usa: la raíz está en la 1, así los hijos de k
+	 * son 2k y 2k + 1, y cada grupo de 8 hermanos empieza en una línea de
+	 * cache.
+	*/
+	size_t bytes = (congelado->cantidad + 1) * sizeof(void *);
+	bytes = (bytes + CONGELADO_ALINEACION - 1) / CONGELADO_ALINEACION *
+		CONGELADO_ALINEACION;
+	congelado->elementos = aligned_alloc(CONGELADO_ALINEACION, bytes);
+	if (!congelado->elementos) {
+		abb_congelado_destruir(congelado);
+		return NULL;
+	}
+	congelado->elementos[0] = NULL;
+	if (congelado->cantidad == 0)
+		return congelado;
+	void **ordenados = congelado_ordenados(arbol);
+	if (!ordenados) {
+		abb_congelado_destruir(congelado);
+		return NULL;
+	}
+	size_t siguiente = 0;
+	congelado_llenar(congelado, ordenados, &siguiente, 1);
+	free(ordenados);
+	return congelado;
+}
+
+/**
+ * Estado de la construcción de una foto van Emde Boas: los elementos del
+ * arbol en orden, la posición que le tocó a cada uno en el array de nodos, y
+ * la próxima posición libre.
+*/
+struct armado_veb {
+	void **ordenados;
+	uint32_t *posiciones;
+	uint32_t siguiente;
+};
+
+/**
+ * Devuelve la altura del arbol de altura mínima que se arma con cantidad
+ * elementos tomando siempre el del medio como raíz.
+*/
+size_t veb_altura(size_t cantidad)
+{
+	size_t altura = 0;
+	while (cantidad > 0) {
+		cantidad /= 2;
+		altura++;
+	}
+	return altura;
+}
+
+void veb_ubicar(struct armado_veb *armado, size_t inicio, size_t fin,
+		size_t altura);
+
+/**
+ * Recibe el estado de la construcción, el rango [inicio, fin) de un
+ * sub-árbol, una profundidad y una altura. Ubica, de izquierda a derecha,
+ * cada sub-árbol que está a esa profundidad por debajo del recibido, con la
+ * altura recibida.
+*/
+void veb_ubicar_debajo(struct armado_veb *armado, size_t inicio, size_t fin,
+		       size_t profundidad, size_t altura)
+{
+	if (inicio >= fin)
+		return;
+	if (profundidad == 0) {
+		veb_ubicar(armado, inicio, fin, altura);
+		return;
+	}
+	size_t medio = inicio + (fin - inicio) / 2;
+	veb_ubicar_debajo(armado, inicio, medio, profundidad - 1, altura);
+	veb_ubicar_debajo(armado, medio + 1, fin, profundidad - 1, altura);
+}
+
+/**
+ * Recibe el estado de la construcción, el rango [inicio, fin) de un sub-árbol
+ * (cuya raíz es el elemento del medio) y una altura. Asigna posiciones
+ * consecutivas a los nodos de los primeros niveles del sub-árbol (tantos como
+ * la altura) en orden van Emde Boas: primero la mitad de arriba y después
+ * cada sub-árbol de la mitad de abajo, recursivamente.
+*/
+void veb_ubicar(struct armado_veb *armado, size_t inicio, size_t fin,
+		size_t altura)
+{
+	if (inicio >= fin || altura == 0)
+		return;
+	if (altura == 1) {
+		size_t medio = inicio + (fin - inicio) / 2;
+		armado->posiciones[medio] = armado->siguiente++;
+		return;
+	}
+	size_t altura_arriba = altura / 2;
+	veb_ubicar(armado, inicio, fin, altura_arriba);
+	veb_ubicar_debajo(armado, inicio, fin, altura_arriba,
+			  altura - altura_arriba);
+}
+
+/**
+ * Recibe una foto con los nodos reservados, el estado de la construcción (con
+ * las posiciones ya asignadas) y el rango [inicio, fin) de un sub-árbol.
+ * Guarda el elemento del medio en su posición y le asigna como hijos las
+ * posiciones de las raíces de cada mitad.
+ * Devuelve la posición de la raíz del sub-árbol, o VEB_NINGUNO si está vacío.
+*/
+uint32_t veb_enlazar(abb_congelado_t *congelado, struct armado_veb *armado,
+		     size_t inicio, size_t fin)
+{
+	if (inicio >= fin)
+		return VEB_NINGUNO;
+	size_t medio = inicio + (fin - inicio) / 2;
+	struct nodo_veb *nodo = &congelado->nodos[armado->posiciones[medio]];
+	nodo->elemento = armado->ordenados[medio];
+	nodo->hijos[0] = veb_enlazar(congelado, armado, inicio, medio);
+	nodo->hijos[1] = veb_enlazar(congelado, armado, medio + 1, fin);
+	return armado->posiciones[medio];
+}
+
+abb_congelado_t *abb_congelar_veb(abb_t *arbol)
+{
+	if (!arbol || arbol->tamanio >= VEB_NINGUNO)
+		return NULL;
+	abb_congelado_t *congelado = calloc(1, sizeof(abb_congelado_t));
+	if (!congelado)
+		return NULL;
+	congelado->comparador = arbol->comparador;
+	congelado->cantidad = arbol->tamanio;
+	congelado->disposicion = CONGELADO_VEB;
+	size_t cantidad = congelado->cantidad;
+	if (cantidad == 0)
+		return congelado;
+	struct armado_veb armado = { 0 };
+	armado.ordenados = congelado_ordenados(arbol);
+	armado.posiciones = malloc(cantidad * sizeof(uint32_t));
+	congelado->nodos = malloc(cantidad * sizeof(struct nodo_veb));
+	if (!armado.ordenados || !armado.posiciones || !congelado->nodos) {
+		free(armado.ordenados);
+		free(armado.posiciones);
+		abb_congelado_destruir(congelado);
+		return NULL;
+	}
+	veb_ubicar(&armado, 0, cantidad, veb_altura(cantidad));
+	veb_enlazar(congelado, &armado, 0, cantidad);
+	free(armado.ordenados);
+	free(armado.posiciones);
+	return congelado;
+}
+
+/**
+ * Recibe una foto van Emde Boas y un elemento, y lo busca bajando desde la
+ * raíz (que siempre está en la posición 0).
+ * Devuelve el elemento encontrado o NULL si no lo encuentra.
+*/
+void *congelado_buscar_veb(abb_congelado_t *congelado, void *elemento)
+{
+	struct nodo_veb *nodos = congelado->nodos;
+	uint32_t posicion = congelado->cantidad > 0 ? 0 : VEB_NINGUNO;
+	while (posicion != VEB_NINGUNO) {
+		int comparacion =
+			congelado->comparador(nodos[posicion].elemento, elemento);
+		if (comparacion == 0)
+			return nodos[posicion].elemento;
+		posicion = nodos[posicion].hijos[comparacion < 0];
+	}
+	return NULL;
+}
+
+void *abb_congelado_buscar(abb_congelado_t *congelado, void *elemento)
+{
+	if (!congelado)
+		return NULL;
+	if (congelado->disposicion == CONGELADO_VEB)
+		return congelado_buscar_veb(congelado, elemento);
+	void **elementos = congelado->elementos;
+	size_t cantidad = congelado->cantidad;
+	size_t posicion = 1;
+	while (posicion <= cantidad) {
+		__builtin_prefetch(elementos +
+				   (posicion << CONGELADO_NIVELES_PRECARGA));
+		posicion = 2 * posicion +
+			   (congelado->comparador(elementos[posicion],
+						  elemento) < 0);
+	}
+	/**
+	 * Cada vez que se bajó a la derecha se agregó un 1 al final de la
+	 * posición, y a la izquierda un 0. El último nodo donde se bajó a la
+	 * izquierda es el primer elemento mayor o igual al buscado: se llega a
+	 * él sacando los 1 del final y el 0 que los precede.
+	*/
+	posicion >>= __builtin_ffsll((long long)~posicion);
+	if (posicion == 0 ||
+	    congelado->comparador(elementos[posicion], elemento) != 0)
+		return NULL;
+	return elementos[posicion];
+}
+
+size_t abb_congelado_tamanio(abb_congelado_t *congelado)
+{
+	if (!congelado)
+		return 0;
+	return congelado->cantidad;
+}
+
+void abb_congelado_destruir(abb_congelado_t *congelado)
+{
+	if (!congelado)
+		return;
+	free(congelado->elementos);
+	free(congelado->nodos);
+	free(congelado);
+}
@@ -0,0 +1,61 @@
+#ifndef __ABB_CONGELADO__H__
+#define __ABB_CONGELADO__H__
+
+#include "abb.h"
+
+typedef struct abb_congelado abb_congelado_t;
+
+/**
+ * Crea una copia inmutable del arbol (una foto) pensada para tablas que se
+ * leen mucho y cambian poco. Los elementos se guardan en un único array
+ * contiguo, en el orden por niveles de un arbol completo (orden de
+ * Eytzinger): los hijos de la posición k están en 2k y 2k + 1. Así las
+ * búsquedas no siguen punteros entre nodos dispersos en memoria.
+ *
+ * La foto no se actualiza si después se modifica el arbol. Los elementos no
+ * se copian: la foto guarda los mismos punteros que el arbol (en un arbol
+ * mapeado, punteros al archivo, que valen mientras no se destruya el arbol).
+ * Se puede congelar cualquier tipo de arbol, incluidos los multiclave y los
+ * mapeados.
+ *
+ * Devuelve la foto o NULL en caso de error.
+ */
+abb_congelado_t *abb_congelar(abb_t *arbol);
+
+/**
+ * Igual que abb_congelar, pero la foto se guarda con la disposición de van
+ * Emde Boas: se arma el arbol de altura mínima con los elementos en orden, se
+ * corta a la mitad de su altura, y se guarda primero el sub-árbol de arriba y
+ * después cada uno de los de abajo, aplicando lo mismo recursivamente dentro
+ * de cada uno. Así, cualquier sub-árbol de altura h ocupa un tramo contiguo de
+ * memoria, y una búsqueda toca O(log_B n) bloques para cualquier tamaño de
+ * bloque B (línea de cache, página, etc.) sin tener que conocerlo.
+ *
+ * Admite hasta 2^32 - 2 elementos.
+ *
+ * Devuelve la foto o NULL en caso de error.
+ */
+abb_congelado_t *abb_congelar_veb(abb_t *arbol);
+
+/**
+ * Busca en la foto un elemento igual al provisto (utilizando la funcion de
+ * comparación del arbol original). La búsqueda no tiene saltos condicionales
+ * según el resultado de la comparación (el siguiente índice se calcula a
+ * partir de ella). En la disposición de Eytzinger, además, va precargando en
+ * la cache las posiciones de varios niveles más abajo.
+ *
+ * Devuelve el elemento encontrado o NULL si no lo encuentra.
+ */
+void *abb_congelado_buscar(abb_congelado_t *congelado, void *elemento);
+
+/**
+ * Devuelve la cantidad de elementos de la foto o 0 si es NULL.
+ */
+size_t abb_congelado_tamanio(abb_congelado_t *congelado);
+
+/**
+ * Destruye la foto. No modifica el arbol original ni sus elementos.
+ */
+void abb_congelado_destruir(abb_congelado_t *congelado);
+
+#endif /* __ABB_CONGELADO__H__ */
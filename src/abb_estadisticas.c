@@ -0,0 +1,147 @@
+#include "abb_estadisticas.h"
+#include "abb_estructura_privada.h"
+#include "abb_pool.h"
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Un nodo pendiente del recorrido de abb_estadisticas, con su nivel.
+*/
+struct pendiente_estadisticas {
+	struct nodo_abb *nodo;
+	size_t nivel;
+};
+
+/**
+ * Recibe unas estadísticas, un nivel (desde 1), una cantidad de nodos de ese
+ * nivel y la de elementos que guardan entre todos, y suma los nodos al
+ * histograma, la altura y la suma de profundidades (que queda en
+ * profundidad_promedio hasta dividirla).
+*/
+void estadisticas_sumar_nodos(abb_estadisticas_t *estadisticas, size_t nivel,
+			      size_t nodos, size_t elementos)
+{
+	size_t i = nivel - 1 < ABB_ESTADISTICAS_NIVELES ?
+			   nivel - 1 :
+			   ABB_ESTADISTICAS_NIVELES - 1;
+	estadisticas->histograma[i] += nodos;
+	estadisticas->nodos += nodos;
+	if (nivel > estadisticas->altura)
+		estadisticas->altura = nivel;
+	estadisticas->profundidad_promedio += (double)nivel * (double)elementos;
+}
+
+/**
+ * Recibe un arbol de nodos binarios y sus estadísticas, y las completa
+ * recorriéndolo en preorden con una pila de a lo sumo abb_cota_altura + 1
+ * nodos. Devuelve false si no hay memoria para la pila.
+*/
+bool estadisticas_binario(abb_t *arbol, abb_estadisticas_t *estadisticas)
+{
+	if (!arbol->nodo_raiz)
+		return true;
+	struct pendiente_estadisticas *pila =
+		malloc((abb_cota_altura(arbol) + 1) * sizeof(*pila));
+	if (!pila)
+		return false;
+	size_t tope = 0;
+	pila[tope++] = (struct pendiente_estadisticas){ arbol->nodo_raiz, 1 };
+	while (tope > 0) {
+		struct pendiente_estadisticas actual = pila[--tope];
+		struct nodo_abb *nodo = actual.nodo;
+		size_t copias = 1;
+		struct repetidos *repetidos =
+			arbol->multiconjunto ? *nodo_repetidos(nodo) : NULL;
+		if (repetidos) {
+			copias += repetidos->cantidad;
+			estadisticas->memoria_nodos +=
+				sizeof(struct repetidos) +
+				repetidos->capacidad * sizeof(void *);
+		}
+		estadisticas_sumar_nodos(estadisticas, actual.nivel, 1, copias);
+		if (nodo->derecha)
+			pila[tope++] = (struct pendiente_estadisticas){
+				nodo->derecha, actual.nivel + 1
+			};
+		if (nodo->izquierda)
+			pila[tope++] = (struct pendiente_estadisticas){
+				nodo->izquierda, actual.nivel + 1
+			};
+	}
+	free(pila);
+	estadisticas->memoria_nodos +=
+		estadisticas->nodos * arbol->pool->tamanio_objeto;
+	return true;
+}
+
+/**
+ * Recibe un nodo multiclave, su nivel y unas estadísticas, y suma a ellas el
+ * nodo y sus descendientes. Los elementos están solo en las hojas, todas en
+ * el último nivel.
+*/
+void estadisticas_multiclave(struct nodo_multiclave *nodo, size_t nivel,
+			     abb_estadisticas_t *estadisticas)
+{
+	if (nodo->es_hoja) {
+		estadisticas_sumar_nodos(estadisticas, nivel, 1, nodo->cantidad);
+		return;
+	}
+	estadisticas_sumar_nodos(estadisticas, nivel, 1, 0);
+	struct interno_multiclave *interno = (struct interno_multiclave *)nodo;
+	for (size_t i = 0; i <= nodo->cantidad; i++)
+		estadisticas_multiclave(interno->hijos[i], nivel + 1,
+					estadisticas);
+}
+
+/**
+ * Recibe un arbol mapeado y sus estadísticas, y las completa sin leer el
+ * archivo: el arbol es completo, así que el nivel k tiene 2^(k - 1) nodos,
+ * salvo el último, que tiene los que sobran.
+*/
+void estadisticas_mapeado(abb_t *arbol, abb_estadisticas_t *estadisticas)
+{
+	size_t restantes = arbol->tamanio;
+	for (size_t nivel = 1, ancho = 1; restantes > 0; nivel++, ancho *= 2) {
+		size_t nodos = ancho < restantes ? ancho : restantes;
+		estadisticas_sumar_nodos(estadisticas, nivel, nodos, nodos);
+		restantes -= nodos;
+	}
+	estadisticas->memoria_nodos = arbol->mapeado->bytes;
+	estadisticas->memoria_reservada = arbol->mapeado->bytes;
+}
+
+bool abb_estadisticas(abb_t *arbol, abb_estadisticas_t *estadisticas)
+{
+	if (!arbol || !estadisticas)
+		return false;
+	memset(estadisticas, 0, sizeof(*estadisticas));
+	estadisticas->cantidad = arbol->tamanio;
+	if (arbol->mapeado) {
+		estadisticas_mapeado(arbol, estadisticas);
+	} else if (arbol->multiclave) {
+		if (arbol->raiz_multiclave)
+			estadisticas_multiclave(arbol->raiz_multiclave, 1,
+						estadisticas);
+		estadisticas->memoria_nodos =
+			estadisticas->nodos * arbol->pool->tamanio_objeto;
+	} else if (!estadisticas_binario(arbol, estadisticas)) {
+		return false;
+	}
+	if (arbol->pool)
+		estadisticas->memoria_reservada = abb_pool_memoria(arbol->pool);
+	if (arbol->tamanio > 0)
+		estadisticas->profundidad_promedio /= (double)arbol->tamanio;
+
+#ifdef ABB_CONTADORES
+	struct abb_contadores *contadores = &arbol->contadores;
+	estadisticas->comparaciones = atomic_load_explicit(
+		&contadores->comparaciones, memory_order_relaxed);
+	estadisticas->nodos_reservados = atomic_load_explicit(
+		&contadores->nodos_reservados, memory_order_relaxed);
+	estadisticas->nodos_liberados = atomic_load_explicit(
+		&contadores->nodos_liberados, memory_order_relaxed);
+	estadisticas->rebalanceos = atomic_load_explicit(
+		&contadores->rebalanceos, memory_order_relaxed);
+#endif
+	return true;
+}
@@ -0,0 +1,60 @@
+#ifndef __ABB_ESTADISTICAS__H__
+#define __ABB_ESTADISTICAS__H__
+
+#include "abb.h"
+#include <stdint.h>
+
+#define ABB_ESTADISTICAS_NIVELES 64
+
+/**
+ * Estadísticas de un arbol. La forma (altura, profundidades, histograma y
+ * memoria) se calcula recorriéndolo; los contadores los va acumulando el
+ * arbol en cada operación desde que se creó.
+ *
+ * Los niveles se cuentan desde 1 (la raíz): la profundidad de un elemento es
+ * la cantidad de nodos que hay que visitar para llegar a él, así que
+ * profundidad_promedio es lo que cuesta en promedio encontrar un elemento que
+ * está, y altura es la profundidad máxima. histograma[i] es la cantidad de
+ * nodos del nivel i + 1; el último lugar acumula también los más profundos.
+ *
+ * memoria_nodos son los bytes de los nodos en uso (más las copias de los
+ * multiconjuntos), y memoria_reservada los que reservó el pool de nodos,
+ * incluidos los libres (si el pool se comparte con otro arbol, como después
+ * de abb_dividir, es el del pool entero). En un arbol mapeado (ver
+ * abb_archivo.h) las dos son el tamaño del archivo.
+ *
+ * Los contadores son las invocaciones al comparador (las comparaciones de
+ * claves de abb_crear_con_clave que no llegan a él no cuentan), los nodos
+ * reservados y devueltos al pool de a uno (destruir el arbol libera el pool
+ * entero sin contarlos), y los rebalanceos: las rotaciones de los AVL (dos
+ * por rotación doble) y las divisiones, préstamos y fusiones de nodos de los
+ * multiclave. Solo se cuentan compilando con -DABB_CONTADORES (si no valen
+ * 0), ya que cada búsqueda escribe en ellos y con varios lectores a la vez
+ * (abb_concurrente) se disputan su línea de cache y pueden perder algunos
+ * incrementos.
+ */
+typedef struct abb_estadisticas {
+	size_t cantidad;
+	size_t nodos;
+	size_t altura;
+	double profundidad_promedio;
+	size_t histograma[ABB_ESTADISTICAS_NIVELES];
+	size_t memoria_nodos;
+	size_t memoria_reservada;
+	uint64_t comparaciones;
+	uint64_t nodos_reservados;
+	uint64_t nodos_liberados;
+	uint64_t rebalanceos;
+} abb_estadisticas_t;
+
+/**
+ * Completa las estadísticas del arbol en O(n), sin modificarlo (se puede
+ * llamar a la vez que otras consultas, pero no que una inserción o
+ * eliminación).
+ *
+ * Devuelve true si pudo, o false si alguno de los punteros es NULL o no hay
+ * memoria para recorrer el arbol.
+ */
+bool abb_estadisticas(abb_t *arbol, abb_estadisticas_t *estadisticas);
+
+#endif // __ABB_ESTADISTICAS__H__
@@ -2,17 +2,266 @@
 #define ABB_ESTRUCTURA_PRIVADA_H_
 
 #include "abb.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+
+/**
+ * Copias de un elemento de un multiconjunto, además de la que está en el
+ * nodo, en el orden en que se insertaron.
+ */
+struct repetidos {
+	size_t cantidad;
+	size_t capacidad;
+	void *elementos[];
+};
 
 struct nodo_abb {
 	void *elemento;
 	struct nodo_abb *izquierda;
 	struct nodo_abb *derecha;
+	size_t altura;
+	size_t cantidad;
+};
+
+/**
+ * Nodo de los arboles creados con abb_crear_con_clave: un nodo común seguido
+ * de la clave de su elemento. Solo el pool de esos arboles reserva nodos de
+ * este tamaño, así que los demás no pagan la clave.
+ */
+struct nodo_con_clave {
+	struct nodo_abb nodo;
+	uint64_t clave;
+};
+
+/**
+ * Nodo de los arboles creados con abb_crear_multiconjunto: un nodo común
+ * seguido de sus copias repetidas (NULL si no tiene). Como con struct
+ * nodo_con_clave, solo el pool de los multiconjuntos reserva este tamaño.
+ */
+struct nodo_multiconjunto {
+	struct nodo_abb nodo;
+	struct repetidos *repetidos;
+};
+
+#define MULTICLAVE_TAMANIO_NODO 128
+#define MULTICLAVE_CLAVES_HOJA 14
+#define MULTICLAVE_CLAVES_INTERNO 7
+
+/**
+ * Nodos del arbol multiclave (B+). Los dos tipos de nodo empiezan con la misma
+ * cabecera y ocupan MULTICLAVE_TAMANIO_NODO bytes (dos líneas de cache). Los
+ * elementos se guardan solo en las hojas, que están enlazadas de menor a
+ * mayor; los nodos internos guardan copias de elementos como separadores.
+ */
+struct nodo_multiclave {
+	uint32_t cantidad;
+	bool es_hoja;
+};
+
+struct hoja_multiclave {
+	struct nodo_multiclave cabecera;
+	struct hoja_multiclave *siguiente;
+	void *elementos[MULTICLAVE_CLAVES_HOJA];
+};
+
+struct interno_multiclave {
+	struct nodo_multiclave cabecera;
+	void *claves[MULTICLAVE_CLAVES_INTERNO];
+	struct nodo_multiclave *hijos[MULTICLAVE_CLAVES_INTERNO + 1];
 };
 
+#define CONCURRENTE_LINEA_CACHE 64
+
+/**
+ * Contadores acumulados de las operaciones de un arbol (ver
+ * abb_estadisticas). Solo existen compilando con -DABB_CONTADORES: cada
+ * comparación escribe en ellos, así que con varios lectores a la vez
+ * (abb_concurrente) todos escriben la misma línea de cache y las búsquedas
+ * dejan de escalar con los núcleos. Sin el flag desaparecen del struct y
+ * ABB_CONTAR no hace nada.
+ *
+ * Los incrementos son una lectura y una escritura atómicas relajadas, no una
+ * operación atómica de lectura-modificación-escritura: no hay carreras ni
+ * instrucciones con lock, a cambio de que dos lectores simultáneos puedan
+ * perder un incremento.
+ */
+#ifdef ABB_CONTADORES
+struct abb_contadores {
+	atomic_uint_fast64_t comparaciones;
+	atomic_uint_fast64_t nodos_reservados;
+	atomic_uint_fast64_t nodos_liberados;
+	atomic_uint_fast64_t rebalanceos;
+};
+
+#define ABB_CONTAR(arbol, contador, n)                                        \
+	atomic_store_explicit(                                                \
+		&(arbol)->contadores.contador,                                \
+		atomic_load_explicit(&(arbol)->contadores.contador,           \
+				     memory_order_relaxed) +                  \
+			(n),                                                  \
+		memory_order_relaxed)
+#else
+#define ABB_CONTAR(arbol, contador, n) ((void)(arbol))
+#endif
+
 struct abb {
 	nodo_abb_t *nodo_raiz;
 	abb_comparador comparador;
 	size_t tamanio;
+	bool balanceado;
+	struct abb_pool *pool;
+	size_t altura_maxima;
+	bool multiclave;
+	struct nodo_multiclave *raiz_multiclave;
+	abb_extractor_clave extractor;
+	struct abb_mapeado *mapeado;
+	bool multiconjunto;
+#ifdef ABB_CONTADORES
+	/**
+	 * Una línea de cache entera separa los contadores de los campos que
+	 * leen las búsquedas, para que escribirlos no invalide esa línea en
+	 * los demás lectores.
+	 */
+	char separacion[CONCURRENTE_LINEA_CACHE];
+	struct abb_contadores contadores;
+#endif
+};
+
+/**
+ * En los multiconjuntos, ultimo es el último nodo que devolvió el iterador y
+ * copia la próxima de sus copias repetidas que falta devolver.
+ */
+struct abb_iterador {
+	abb_t *arbol;
+	abb_recorrido recorrido;
+	struct nodo_abb *ultimo;
+	size_t copia;
+	size_t tope;
+	struct nodo_abb *pila[];
+};
+
+enum disposicion_congelado { CONGELADO_EYTZINGER, CONGELADO_VEB };
+
+struct nodo_veb {
+	void *elemento;
+	uint32_t hijos[2];
+};
+
+struct abb_congelado {
+	abb_comparador comparador;
+	size_t cantidad;
+	enum disposicion_congelado disposicion;
+	void **elementos;
+	struct nodo_veb *nodos;
 };
 
+#define CONCURRENTE_RANURAS 64
+
+/**
+ * Contador de lectores de una ranura, solo en su línea de cache para que los
+ * lectores de distintas ranuras no se la disputen.
+ */
+struct ranura_lectores {
+	_Alignas(CONCURRENTE_LINEA_CACHE) atomic_size_t lectores;
+};
+
+struct abb_concurrente {
+	abb_t *arbol;
+	pthread_mutex_t escritores;
+	_Alignas(CONCURRENTE_LINEA_CACHE) atomic_bool escribiendo;
+	struct ranura_lectores ranuras[CONCURRENTE_RANURAS];
+};
+
+/**
+ * Nodo de un arbol RCU. Una vez publicado no se modifica nunca: los
+ * escritores arman copias. Version es la escritura en la que se creó, y
+ * siguiente enlaza al nodo en las listas de nodos reservados o retirados.
+ */
+struct nodo_rcu {
+	void *elemento;
+	struct nodo_rcu *izquierda;
+	struct nodo_rcu *derecha;
+	size_t altura;
+	uint64_t version;
+	struct nodo_rcu *siguiente;
+};
+
+#define RCU_EPOCAS 3
+
+struct abb_rcu_lector {
+	_Alignas(CONCURRENTE_LINEA_CACHE) atomic_uint_fast64_t epoca;
+	struct abb_rcu *rcu;
+	struct abb_rcu_lector *siguiente;
+};
+
+struct abb_rcu {
+	_Atomic(struct nodo_rcu *) raiz;
+	atomic_uint_fast64_t epoca;
+	atomic_size_t tamanio;
+	abb_comparador comparador;
+	pthread_mutex_t escritores;
+	uint64_t version;
+	struct abb_pool *pool;
+	struct abb_rcu_lector *lectores;
+	struct nodo_rcu *retirados[RCU_EPOCAS];
+};
+
+/**
+ * Nodo de un arbol persistente. Una vez creado no se modifica nunca, así que
+ * lo pueden compartir varias versiones (y varios padres): referencias cuenta
+ * los padres y versiones que apuntan a él, y el nodo se libera cuando llega a
+ * 0.
+ */
+struct nodo_persistente {
+	void *elemento;
+	struct nodo_persistente *izquierda;
+	struct nodo_persistente *derecha;
+	size_t altura;
+	atomic_size_t referencias;
+};
+
+struct abb_version {
+	struct nodo_persistente *raiz;
+	abb_comparador comparador;
+	size_t tamanio;
+	atomic_size_t referencias;
+};
+
+/**
+ * Un arbol cargado con abb_cargar_mmap: el archivo mapeado, y dentro de él
+ * los desplazamientos de los elementos (el de la posición k de Eytzinger va
+ * de desplazamientos[k - 1] a desplazamientos[k]) y los datos.
+ */
+struct abb_mapeado {
+	void *mapa;
+	size_t bytes;
+	const uint64_t *desplazamientos;
+	const char *datos;
+};
+
+/**
+ * Funciones de abb_archivo.c que usa abb.c con los arboles mapeados.
+ */
+void *mapeado_buscar(abb_t *arbol, void *elemento);
+size_t mapeado_con_cada_elemento(abb_t *arbol, abb_recorrido recorrido,
+				 bool (*funcion)(void *, void *), void *aux);
+void mapeado_liberar(abb_t *arbol);
+
+/**
+ * Funciones de abb.c que también usan los demás módulos.
+ */
+int comparar(abb_t *arbol, void *a, void *b);
+void nodo_actualizar(abb_t *arbol, struct nodo_abb *nodo);
+struct repetidos **nodo_repetidos(struct nodo_abb *nodo);
+struct nodo_abb *nodo_en(abb_t *arbol, struct nodo_abb *nodos, size_t posicion);
+struct nodo_abb *armar_sub_arbol_ordenado(abb_t *arbol, struct nodo_abb *nodos,
+					  void **elementos, size_t inicio,
+					  size_t fin);
+size_t abb_cota_altura(abb_t *arbol);
+bool recorrer_sub_arbol(abb_t *arbol, struct nodo_abb *nodo,
+			abb_recorrido recorrido,
+			bool (*funcion)(void *, void *), void *aux,
+			size_t *invocaciones);
+
 #endif // ABB_ESTRUCTURA_PRIVADA_H_
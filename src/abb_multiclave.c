@@ -0,0 +1,562 @@
+#include "abb_multiclave.h"
+#include "abb_estructura_privada.h"
+#include "abb_pool.h"
+#include <string.h>
+
+#define MULTICLAVE_MINIMO_HOJA (MULTICLAVE_CLAVES_HOJA / 2)
+#define MULTICLAVE_MINIMO_INTERNO (MULTICLAVE_CLAVES_INTERNO / 2)
+#define MULTICLAVE_PROFUNDIDAD_MAXIMA 64
+
+_Static_assert(sizeof(struct hoja_multiclave) <= MULTICLAVE_TAMANIO_NODO,
+	       "la hoja no entra en un nodo multiclave");
+_Static_assert(sizeof(struct interno_multiclave) <= MULTICLAVE_TAMANIO_NODO,
+	       "el nodo interno no entra en un nodo multiclave");
+
+/**
+ * Camino desde la raíz hasta una hoja: los nodos internos recorridos, el
+ * índice del hijo por el que se bajó en cada uno, la hoja y una posición
+ * dentro de ella.
+*/
+struct camino_multiclave {
+	struct interno_multiclave *internos[MULTICLAVE_PROFUNDIDAD_MAXIMA];
+	size_t indices[MULTICLAVE_PROFUNDIDAD_MAXIMA];
+	size_t profundidad;
+	struct hoja_multiclave *hoja;
+	size_t indice;
+};
+
+/**
+ * Recibe un arbol multiclave, un array de claves ordenado, su cantidad y un
+ * elemento, y devuelve la posición de la primera clave mayor o igual
+ * al elemento (o mayor, si estricto es true). Con a lo sumo
+ * MULTICLAVE_CLAVES_HOJA claves, recorrerlas en orden es más rápido que una
+ * búsqueda binaria, y todas están en las mismas dos líneas de cache.
+*/
+size_t multiclave_posicion(abb_t *arbol, void **claves, size_t cantidad,
+			   void *elemento, bool estricto)
+{
+	size_t i = 0;
+	if (estricto)
+		while (i < cantidad &&
+		       comparar(arbol, claves[i], elemento) <= 0)
+			i++;
+	else
+		while (i < cantidad && comparar(arbol, claves[i], elemento) < 0)
+			i++;
+	return i;
+}
+
+/**
+ * Recibe un arbol multiclave no vacío, un elemento y un struct
+ * camino_multiclave, y baja desde la raíz hasta la hoja donde debería estar
+ * el elemento, guardando el camino. Si estricto es false, la posición
+ * guardada es la del primer elemento de la hoja mayor o igual al recibido
+ * (que puede ser igual a la cantidad de la hoja), y si es true la del primero
+ * mayor.
+ *
+ * Mientras lee un nodo pide la segunda línea de cache del hijo por el que va
+ * a bajar, así las dos líneas del nodo se traen a la vez.
+*/
+void multiclave_bajar(abb_t *arbol, void *elemento,
+		      struct camino_multiclave *camino, bool estricto)
+{
+	struct nodo_multiclave *nodo = arbol->raiz_multiclave;
+	camino->profundidad = 0;
+	while (!nodo->es_hoja) {
+		struct interno_multiclave *interno =
+			(struct interno_multiclave *)nodo;
+		size_t i = multiclave_posicion(arbol, interno->claves,
+					       interno->cabecera.cantidad,
+					       elemento, estricto);
+		camino->internos[camino->profundidad] = interno;
+		camino->indices[camino->profundidad++] = i;
+		nodo = interno->hijos[i];
+		__builtin_prefetch((char *)nodo + MULTICLAVE_TAMANIO_NODO / 2);
+	}
+	camino->hoja = (struct hoja_multiclave *)nodo;
+	camino->indice = multiclave_posicion(arbol, camino->hoja->elementos,
+					     nodo->cantidad, elemento,
+					     estricto);
+}
+
+/**
+ * Recibe un camino cuya posición quedó al final de su hoja y lo mueve al
+ * primer elemento de la hoja siguiente, actualizando también los nodos
+ * internos (para poder modificar esa hoja). Devuelve false si no hay hoja
+ * siguiente.
+*/
+bool multiclave_avanzar_hoja(struct camino_multiclave *camino)
+{
+	size_t nivel = camino->profundidad;
+	while (nivel > 0 && camino->indices[nivel - 1] ==
+				    camino->internos[nivel - 1]->cabecera.cantidad)
+		nivel--;
+	if (nivel == 0)
+		return false;
+	camino->indices[nivel - 1]++;
+	struct nodo_multiclave *nodo =
+		camino->internos[nivel - 1]->hijos[camino->indices[nivel - 1]];
+	while (!nodo->es_hoja) {
+		camino->internos[nivel] = (struct interno_multiclave *)nodo;
+		camino->indices[nivel++] = 0;
+		nodo = ((struct interno_multiclave *)nodo)->hijos[0];
+	}
+	camino->hoja = (struct hoja_multiclave *)nodo;
+	camino->indice = 0;
+	return true;
+}
+
+/**
+ * Recibe un arbol multiclave, un elemento y un puntero a un índice, y
+ * devuelve la hoja que contiene al primer elemento del arbol mayor o igual al
+ * recibido, guardando su posición en el índice. Devuelve NULL si no hay tal
+ * elemento.
+ *
+ * Las hojas a la izquierda del camino solo tienen elementos menores, así que
+ * si la posición queda al final de la hoja, el elemento buscado es el primero
+ * de la hoja siguiente.
+*/
+struct hoja_multiclave *multiclave_cota_inferior(abb_t *arbol, void *elemento,
+						 size_t *indice)
+{
+	if (!arbol->raiz_multiclave)
+		return NULL;
+	struct camino_multiclave camino;
+	multiclave_bajar(arbol, elemento, &camino, false);
+	if (camino.indice < camino.hoja->cabecera.cantidad) {
+		*indice = camino.indice;
+		return camino.hoja;
+	}
+	*indice = 0;
+	return camino.hoja->siguiente;
+}
+
+void *multiclave_buscar(abb_t *arbol, void *elemento)
+{
+	size_t indice = 0;
+	struct hoja_multiclave *hoja =
+		multiclave_cota_inferior(arbol, elemento, &indice);
+	if (!hoja || comparar(arbol, hoja->elementos[indice], elemento) != 0)
+		return NULL;
+	return hoja->elementos[indice];
+}
+
+/**
+ * Recibe una hoja llena, una hoja vacía, una posición y un elemento, y reparte
+ * entre las dos hojas los elementos de la llena más el recibido (insertado en
+ * esa posición). La hoja nueva queda enlazada a continuación de la llena.
+*/
+void multiclave_partir_hoja(struct hoja_multiclave *hoja,
+			    struct hoja_multiclave *nueva, size_t posicion,
+			    void *elemento)
+{
+	void *todos[MULTICLAVE_CLAVES_HOJA + 1];
+	memcpy(todos, hoja->elementos, posicion * sizeof(void *));
+	todos[posicion] = elemento;
+	memcpy(todos + posicion + 1, hoja->elementos + posicion,
+	       (MULTICLAVE_CLAVES_HOJA - posicion) * sizeof(void *));
+
+	size_t izquierda = (MULTICLAVE_CLAVES_HOJA + 1) / 2;
+	size_t derecha = MULTICLAVE_CLAVES_HOJA + 1 - izquierda;
+	memcpy(hoja->elementos, todos, izquierda * sizeof(void *));
+	memcpy(nueva->elementos, todos + izquierda, derecha * sizeof(void *));
+	hoja->cabecera.cantidad = (uint32_t)izquierda;
+	nueva->cabecera.cantidad = (uint32_t)derecha;
+	nueva->cabecera.es_hoja = true;
+	nueva->siguiente = hoja->siguiente;
+	hoja->siguiente = nueva;
+}
+
+/**
+ * Recibe un nodo interno lleno, uno vacío, una posición, y la clave y el hijo
+ * que hay que agregar en esa posición (el hijo queda a la derecha de la
+ * clave). Reparte las claves y los hijos entre los dos nodos y guarda en
+ * separador la clave del medio, que no queda en ninguno de los dos y hay que
+ * subir al padre.
+*/
+void multiclave_partir_interno(struct interno_multiclave *interno,
+			       struct interno_multiclave *nuevo,
+			       size_t posicion, void *clave,
+			       struct nodo_multiclave *hijo, void **separador)
+{
+	void *claves[MULTICLAVE_CLAVES_INTERNO + 1];
+	struct nodo_multiclave *hijos[MULTICLAVE_CLAVES_INTERNO + 2];
+	memcpy(claves, interno->claves, posicion * sizeof(void *));
+	claves[posicion] = clave;
+	memcpy(claves + posicion + 1, interno->claves + posicion,
+	       (MULTICLAVE_CLAVES_INTERNO - posicion) * sizeof(void *));
+	memcpy(hijos, interno->hijos, (posicion + 1) * sizeof(void *));
+	hijos[posicion + 1] = hijo;
+	memcpy(hijos + posicion + 2, interno->hijos + posicion + 1,
+	       (MULTICLAVE_CLAVES_INTERNO - posicion) * sizeof(void *));
+
+	size_t izquierda = (MULTICLAVE_CLAVES_INTERNO + 1) / 2;
+	size_t derecha = MULTICLAVE_CLAVES_INTERNO - izquierda;
+	memcpy(interno->claves, claves, izquierda * sizeof(void *));
+	memcpy(interno->hijos, hijos, (izquierda + 1) * sizeof(void *));
+	*separador = claves[izquierda];
+	memcpy(nuevo->claves, claves + izquierda + 1, derecha * sizeof(void *));
+	memcpy(nuevo->hijos, hijos + izquierda + 1,
+	       (derecha + 1) * sizeof(void *));
+	interno->cabecera.cantidad = (uint32_t)izquierda;
+	nuevo->cabecera.cantidad = (uint32_t)derecha;
+}
+
+/**
+ * Recibe un camino hasta la hoja donde se va a insertar y devuelve cuántos
+ * nodos nuevos hacen falta para la inserción: uno por cada nodo lleno que se
+ * parte, empezando por la hoja, más uno para la raíz nueva si se parten
+ * todos.
+*/
+size_t multiclave_nodos_necesarios(struct camino_multiclave *camino)
+{
+	if (camino->hoja->cabecera.cantidad < MULTICLAVE_CLAVES_HOJA)
+		return 0;
+	size_t necesarios = 1;
+	size_t nivel = camino->profundidad;
+	while (nivel > 0 && camino->internos[nivel - 1]->cabecera.cantidad ==
+				    MULTICLAVE_CLAVES_INTERNO) {
+		necesarios++;
+		nivel--;
+	}
+	if (nivel == 0)
+		necesarios++;
+	return necesarios;
+}
+
+abb_t *multiclave_insertar(abb_t *arbol, void *elemento)
+{
+	if (!arbol->raiz_multiclave) {
+		struct hoja_multiclave *hoja = abb_pool_obtener(arbol->pool);
+		if (!hoja)
+			return NULL;
+		ABB_CONTAR(arbol, nodos_reservados, 1);
+		hoja->cabecera.es_hoja = true;
+		arbol->raiz_multiclave = &hoja->cabecera;
+		arbol->altura_maxima = 1;
+	}
+	struct camino_multiclave camino;
+	multiclave_bajar(arbol, elemento, &camino, true);
+
+	/**
+	 * Reservo antes de modificar nada todos los nodos que va a hacer falta
+	 * partir, así si no hay memoria el arbol queda como estaba.
+	*/
+	struct nodo_multiclave *nuevos[MULTICLAVE_PROFUNDIDAD_MAXIMA + 1];
+	size_t necesarios = multiclave_nodos_necesarios(&camino);
+	for (size_t i = 0; i < necesarios; i++) {
+		nuevos[i] = abb_pool_obtener(arbol->pool);
+		if (!nuevos[i]) {
+			while (i-- > 0)
+				abb_pool_devolver(arbol->pool, nuevos[i]);
+			return NULL;
+		}
+	}
+	ABB_CONTAR(arbol, nodos_reservados, necesarios);
+
+	struct hoja_multiclave *hoja = camino.hoja;
+	size_t usados = 0;
+	if (hoja->cabecera.cantidad < MULTICLAVE_CLAVES_HOJA) {
+		memmove(hoja->elementos + camino.indice + 1,
+			hoja->elementos + camino.indice,
+			(hoja->cabecera.cantidad - camino.indice) *
+				sizeof(void *));
+		hoja->elementos[camino.indice] = elemento;
+		hoja->cabecera.cantidad++;
+		arbol->tamanio++;
+		return arbol;
+	}
+	struct hoja_multiclave *nueva_hoja =
+		(struct hoja_multiclave *)nuevos[usados++];
+	multiclave_partir_hoja(hoja, nueva_hoja, camino.indice, elemento);
+	ABB_CONTAR(arbol, rebalanceos, 1);
+	void *separador = nueva_hoja->elementos[0];
+	struct nodo_multiclave *nuevo = &nueva_hoja->cabecera;
+
+	for (size_t nivel = camino.profundidad; nuevo && nivel > 0; nivel--) {
+		struct interno_multiclave *interno = camino.internos[nivel - 1];
+		size_t i = camino.indices[nivel - 1];
+		size_t cantidad = interno->cabecera.cantidad;
+		if (cantidad < MULTICLAVE_CLAVES_INTERNO) {
+			memmove(interno->claves + i + 1, interno->claves + i,
+				(cantidad - i) * sizeof(void *));
+			memmove(interno->hijos + i + 2, interno->hijos + i + 1,
+				(cantidad - i) * sizeof(void *));
+			interno->claves[i] = separador;
+			interno->hijos[i + 1] = nuevo;
+			interno->cabecera.cantidad++;
+			nuevo = NULL;
+		} else {
+			struct interno_multiclave *nuevo_interno =
+				(struct interno_multiclave *)nuevos[usados++];
+			multiclave_partir_interno(interno, nuevo_interno, i,
+						  separador, nuevo,
+						  &separador);
+			ABB_CONTAR(arbol, rebalanceos, 1);
+			nuevo = &nuevo_interno->cabecera;
+		}
+	}
+	if (nuevo) {
+		struct interno_multiclave *raiz =
+			(struct interno_multiclave *)nuevos[usados++];
+		raiz->cabecera.cantidad = 1;
+		raiz->claves[0] = separador;
+		raiz->hijos[0] = arbol->raiz_multiclave;
+		raiz->hijos[1] = nuevo;
+		arbol->raiz_multiclave = &raiz->cabecera;
+		arbol->altura_maxima++;
+	}
+	arbol->tamanio++;
+	return arbol;
+}
+
+/**
+ * Recibe un nodo interno y la posición de un hijo que quedó con menos claves
+ * que el mínimo, y le pasa la última clave (y el último hijo, si no es hoja)
+ * del hermano izquierdo, actualizando el separador del padre.
+*/
+void multiclave_prestar_de_izquierda(struct interno_multiclave *padre,
+				     size_t i)
+{
+	struct nodo_multiclave *nodo = padre->hijos[i];
+	struct nodo_multiclave *hermano = padre->hijos[i - 1];
+	if (nodo->es_hoja) {
+		struct hoja_multiclave *hoja = (struct hoja_multiclave *)nodo;
+		struct hoja_multiclave *izquierda =
+			(struct hoja_multiclave *)hermano;
+		memmove(hoja->elementos + 1, hoja->elementos,
+			nodo->cantidad * sizeof(void *));
+		hoja->elementos[0] = izquierda->elementos[--hermano->cantidad];
+		padre->claves[i - 1] = hoja->elementos[0];
+	} else {
+		struct interno_multiclave *interno =
+			(struct interno_multiclave *)nodo;
+		struct interno_multiclave *izquierdo =
+			(struct interno_multiclave *)hermano;
+		memmove(interno->claves + 1, interno->claves,
+			nodo->cantidad * sizeof(void *));
+		memmove(interno->hijos + 1, interno->hijos,
+			(nodo->cantidad + 1) * sizeof(void *));
+		interno->claves[0] = padre->claves[i - 1];
+		interno->hijos[0] = izquierdo->hijos[hermano->cantidad];
+		padre->claves[i - 1] = izquierdo->claves[--hermano->cantidad];
+	}
+	nodo->cantidad++;
+}
+
+/**
+ * Igual que multiclave_prestar_de_izquierda, pero le pasa al hijo la primera
+ * clave (y el primer hijo) del hermano derecho.
+*/
+void multiclave_prestar_de_derecha(struct interno_multiclave *padre, size_t i)
+{
+	struct nodo_multiclave *nodo = padre->hijos[i];
+	struct nodo_multiclave *hermano = padre->hijos[i + 1];
+	if (nodo->es_hoja) {
+		struct hoja_multiclave *hoja = (struct hoja_multiclave *)nodo;
+		struct hoja_multiclave *derecha =
+			(struct hoja_multiclave *)hermano;
+		hoja->elementos[nodo->cantidad] = derecha->elementos[0];
+		memmove(derecha->elementos, derecha->elementos + 1,
+			(hermano->cantidad - 1) * sizeof(void *));
+		padre->claves[i] = derecha->elementos[0];
+	} else {
+		struct interno_multiclave *interno =
+			(struct interno_multiclave *)nodo;
+		struct interno_multiclave *derecho =
+			(struct interno_multiclave *)hermano;
+		interno->claves[nodo->cantidad] = padre->claves[i];
+		interno->hijos[nodo->cantidad + 1] = derecho->hijos[0];
+		padre->claves[i] = derecho->claves[0];
+		memmove(derecho->claves, derecho->claves + 1,
+			(hermano->cantidad - 1) * sizeof(void *));
+		memmove(derecho->hijos, derecho->hijos + 1,
+			hermano->cantidad * sizeof(void *));
+	}
+	hermano->cantidad--;
+	nodo->cantidad++;
+}
+
+/**
+ * Recibe un arbol multiclave, un nodo interno y una posición, y junta en el
+ * hijo de esa posición todo el contenido del hijo siguiente (más el separador
+ * entre ambos, si no son hojas). Saca del padre el separador y el hijo
+ * siguiente, y devuelve ese hijo al pool.
+*/
+void multiclave_fusionar(abb_t *arbol, struct interno_multiclave *padre,
+			 size_t i)
+{
+	struct nodo_multiclave *nodo = padre->hijos[i];
+	struct nodo_multiclave *hermano = padre->hijos[i + 1];
+	if (nodo->es_hoja) {
+		struct hoja_multiclave *hoja = (struct hoja_multiclave *)nodo;
+		struct hoja_multiclave *derecha =
+			(struct hoja_multiclave *)hermano;
+		memcpy(hoja->elementos + nodo->cantidad, derecha->elementos,
+		       hermano->cantidad * sizeof(void *));
+		nodo->cantidad += hermano->cantidad;
+		hoja->siguiente = derecha->siguiente;
+	} else {
+		struct interno_multiclave *interno =
+			(struct interno_multiclave *)nodo;
+		struct interno_multiclave *derecho =
+			(struct interno_multiclave *)hermano;
+		interno->claves[nodo->cantidad] = padre->claves[i];
+		memcpy(interno->claves + nodo->cantidad + 1, derecho->claves,
+		       hermano->cantidad * sizeof(void *));
+		memcpy(interno->hijos + nodo->cantidad + 1, derecho->hijos,
+		       (hermano->cantidad + 1) * sizeof(void *));
+		nodo->cantidad += hermano->cantidad + 1;
+	}
+	size_t cantidad = padre->cabecera.cantidad;
+	memmove(padre->claves + i, padre->claves + i + 1,
+		(cantidad - i - 1) * sizeof(void *));
+	memmove(padre->hijos + i + 1, padre->hijos + i + 2,
+		(cantidad - i - 1) * sizeof(void *));
+	padre->cabecera.cantidad--;
+	ABB_CONTAR(arbol, nodos_liberados, 1);
+	abb_pool_devolver(arbol->pool, hermano);
+}
+
+/**
+ * Recibe un arbol multiclave, un nodo interno y la posición de un hijo que
+ * quedó con menos claves que el mínimo, y lo arregla: si algún hermano tiene
+ * claves de sobra le pide una, y si no lo junta con uno de ellos (lo que le
+ * saca una clave al padre).
+*/
+void multiclave_reparar_hijo(abb_t *arbol, struct interno_multiclave *padre,
+			     size_t i)
+{
+	size_t minimo = padre->hijos[i]->es_hoja ? MULTICLAVE_MINIMO_HOJA :
+						   MULTICLAVE_MINIMO_INTERNO;
+	ABB_CONTAR(arbol, rebalanceos, 1);
+	if (i > 0 && padre->hijos[i - 1]->cantidad > minimo)
+		multiclave_prestar_de_izquierda(padre, i);
+	else if (i < padre->cabecera.cantidad &&
+		 padre->hijos[i + 1]->cantidad > minimo)
+		multiclave_prestar_de_derecha(padre, i);
+	else if (i > 0)
+		multiclave_fusionar(arbol, padre, i - 1);
+	else
+		multiclave_fusionar(arbol, padre, i);
+}
+
+void *multiclave_quitar(abb_t *arbol, void *elemento)
+{
+	if (!arbol->raiz_multiclave)
+		return NULL;
+	struct camino_multiclave camino;
+	multiclave_bajar(arbol, elemento, &camino, false);
+	if (camino.indice == camino.hoja->cabecera.cantidad &&
+	    !multiclave_avanzar_hoja(&camino))
+		return NULL;
+	struct hoja_multiclave *hoja = camino.hoja;
+	void *quitado = hoja->elementos[camino.indice];
+	if (comparar(arbol, quitado, elemento) != 0)
+		return NULL;
+	memmove(hoja->elementos + camino.indice,
+		hoja->elementos + camino.indice + 1,
+		(hoja->cabecera.cantidad - camino.indice - 1) * sizeof(void *));
+	hoja->cabecera.cantidad--;
+	arbol->tamanio--;
+
+	/**
+	 * Los separadores de los nodos internos pueden quedar con elementos que
+	 * ya no están en el arbol: siguen sirviendo como cotas.
+	*/
+	struct nodo_multiclave *nodo = &hoja->cabecera;
+	for (size_t nivel = camino.profundidad; nivel > 0; nivel--) {
+		size_t minimo = nodo->es_hoja ? MULTICLAVE_MINIMO_HOJA :
+						MULTICLAVE_MINIMO_INTERNO;
+		if (nodo->cantidad >= minimo)
+			break;
+		multiclave_reparar_hijo(arbol, camino.internos[nivel - 1],
+					camino.indices[nivel - 1]);
+		nodo = &camino.internos[nivel - 1]->cabecera;
+	}
+
+	struct nodo_multiclave *raiz = arbol->raiz_multiclave;
+	if (raiz->cantidad == 0) {
+		arbol->raiz_multiclave =
+			raiz->es_hoja ?
+				NULL :
+				((struct interno_multiclave *)raiz)->hijos[0];
+		arbol->altura_maxima--;
+		ABB_CONTAR(arbol, nodos_liberados, 1);
+		abb_pool_devolver(arbol->pool, raiz);
+	}
+	return quitado;
+}
+
+/**
+ * Recibe un arbol multiclave y devuelve su hoja de más a la izquierda, o
+ * NULL si está vacío.
+*/
+struct hoja_multiclave *multiclave_primera_hoja(abb_t *arbol)
+{
+	struct nodo_multiclave *nodo = arbol->raiz_multiclave;
+	while (nodo && !nodo->es_hoja)
+		nodo = ((struct interno_multiclave *)nodo)->hijos[0];
+	return (struct hoja_multiclave *)nodo;
+}
+
+size_t multiclave_con_cada_elemento(abb_t *arbol,
+				    bool (*funcion)(void *, void *), void *aux)
+{
+	size_t contador = 0;
+	for (struct hoja_multiclave *hoja = multiclave_primera_hoja(arbol);
+	     hoja; hoja = hoja->siguiente) {
+		for (size_t i = 0; i < hoja->cabecera.cantidad; i++) {
+			contador++;
+			if (funcion(hoja->elementos[i], aux) == false)
+				return contador;
+		}
+	}
+	return contador;
+}
+
+size_t multiclave_rango(abb_t *arbol, void *minimo, void *maximo,
+			bool (*funcion)(void *, void *), void *aux)
+{
+	size_t i = 0;
+	size_t contador = 0;
+	for (struct hoja_multiclave *hoja =
+		     multiclave_cota_inferior(arbol, minimo, &i);
+	     hoja; hoja = hoja->siguiente, i = 0) {
+		for (; i < hoja->cabecera.cantidad; i++) {
+			if (comparar(arbol, hoja->elementos[i], maximo) > 0)
+				return contador;
+			contador++;
+			if (funcion(hoja->elementos[i], aux) == false)
+				return contador;
+		}
+	}
+	return contador;
+}
+
+size_t multiclave_contar_entre(abb_t *arbol, void *a, void *b)
+{
+	size_t i = 0;
+	size_t contador = 0;
+	for (struct hoja_multiclave *hoja =
+		     multiclave_cota_inferior(arbol, a, &i);
+	     hoja; hoja = hoja->siguiente, i = 0) {
+		size_t ultimo = hoja->cabecera.cantidad - 1;
+		if (comparar(arbol, hoja->elementos[ultimo], b) <= 0) {
+			contador += hoja->cabecera.cantidad - i;
+			continue;
+		}
+		return contador + multiclave_posicion(arbol,
+						      hoja->elementos + i,
+						      ultimo + 1 - i, b, true);
+	}
+	return contador;
+}
+
+void multiclave_destruir_elementos(abb_t *arbol, void (*destructor)(void *))
+{
+	for (struct hoja_multiclave *hoja = multiclave_primera_hoja(arbol);
+	     hoja; hoja = hoja->siguiente)
+		for (size_t i = 0; i < hoja->cabecera.cantidad; i++)
+			destructor(hoja->elementos[i]);
+}
@@ -0,0 +1,54 @@
+#ifndef ABB_MULTICLAVE_H_
+#define ABB_MULTICLAVE_H_
+
+#include "abb.h"
+
+/**
+ * Operaciones de los arboles creados con abb_crear_multiclave. Las funciones
+ * públicas de abb.h las invocan cuando el arbol es multiclave; no deben
+ * usarse con otros arboles.
+ */
+
+/**
+ * Inserta el elemento después de los iguales que ya haya en el arbol.
+ * Devuelve el arbol o NULL en caso de error (y en ese caso no lo modifica).
+ */
+abb_t *multiclave_insertar(abb_t *arbol, void *elemento);
+
+/**
+ * Devuelve el primer elemento del arbol igual al recibido, o NULL si no hay.
+ */
+void *multiclave_buscar(abb_t *arbol, void *elemento);
+
+/**
+ * Quita del arbol el primer elemento igual al recibido y lo devuelve, o
+ * devuelve NULL si no hay ninguno.
+ */
+void *multiclave_quitar(abb_t *arbol, void *elemento);
+
+/**
+ * Invoca la función con cada elemento del arbol, de menor a mayor, hasta que
+ * devuelva false. Devuelve la cantidad de veces que fue invocada.
+ */
+size_t multiclave_con_cada_elemento(abb_t *arbol,
+				    bool (*funcion)(void *, void *), void *aux);
+
+/**
+ * Igual que multiclave_con_cada_elemento, pero solo con los elementos que
+ * están entre minimo y maximo (inclusive).
+ */
+size_t multiclave_rango(abb_t *arbol, void *minimo, void *maximo,
+			bool (*funcion)(void *, void *), void *aux);
+
+/**
+ * Devuelve la cantidad de elementos del arbol entre a y b (inclusive).
+ */
+size_t multiclave_contar_entre(abb_t *arbol, void *a, void *b);
+
+/**
+ * Invoca el destructor con cada elemento del arbol. Los nodos no se liberan,
+ * ya que se liberan todos juntos con el pool.
+ */
+void multiclave_destruir_elementos(abb_t *arbol, void (*destructor)(void *));
+
+#endif // ABB_MULTICLAVE_H_
@@ -0,0 +1,355 @@
+#include "abb_paralelo.h"
+#include "abb_estructura_privada.h"
+#include "abb_pool.h"
+#include <sched.h>
+#include <string.h>
+
+#define PARALELO_UMBRAL 1024
+#define PARALELO_HILOS_MAXIMOS 64
+#define PARALELO_COLA_INICIAL 64
+#define PARALELO_COLA_MAXIMA 4096
+
+/**
+ * Cola de sub-árboles pendientes de un hilo. El dueño agrega y saca por el
+ * final (así sigue con lo último que dejó, que es lo más chico), y los demás
+ * roban por el principio (lo más cercano a la raíz, lo más grande). Es un
+ * buffer circular protegido por un mutex: las operaciones son pocas y cortas
+ * comparadas con recorrer un sub-árbol. Empieza chico y se agranda al doble
+ * cuando se llena, hasta PARALELO_COLA_MAXIMA sub-árboles.
+*/
+struct cola_tareas {
+	pthread_mutex_t mutex;
+	struct nodo_abb **tareas;
+	size_t capacidad;
+	size_t inicio;
+	size_t cantidad;
+};
+
+struct recorrido_paralelo {
+	abb_t *arbol;
+	bool (*funcion)(void *, void *);
+	void **aux;
+	size_t hilos;
+	struct cola_tareas *colas;
+	atomic_size_t pendientes;
+	atomic_size_t invocaciones;
+	atomic_bool cortado;
+};
+
+struct trabajador {
+	struct recorrido_paralelo *recorrido;
+	size_t indice;
+};
+
+/**
+ * Recibe una cola llena, con su mutex tomado, y duplica su capacidad. Los
+ * sub-árboles que habían dado la vuelta al buffer pasan a continuación de
+ * los demás. Devuelve false si la cola ya tiene la capacidad máxima o si no
+ * hay memoria.
+*/
+bool cola_agrandar(struct cola_tareas *cola)
+{
+	if (cola->capacidad >= PARALELO_COLA_MAXIMA)
+		return false;
+	size_t capacidad = 2 * cola->capacidad;
+	struct nodo_abb **tareas =
+		realloc(cola->tareas, capacidad * sizeof(struct nodo_abb *));
+	if (!tareas)
+		return false;
+	memcpy(tareas + cola->capacidad, tareas,
+	       cola->inicio * sizeof(struct nodo_abb *));
+	cola->tareas = tareas;
+	cola->capacidad = capacidad;
+	return true;
+}
+
+/**
+ * Recibe una cola y un sub-árbol, y lo agrega al final de la cola,
+ * agrandándola si está llena. Devuelve false si no pudo agrandarla.
+*/
+bool cola_agregar(struct cola_tareas *cola, struct nodo_abb *nodo)
+{
+	pthread_mutex_lock(&cola->mutex);
+	bool hay_lugar =
+		cola->cantidad < cola->capacidad || cola_agrandar(cola);
+	if (hay_lugar)
+		cola->tareas[(cola->inicio + cola->cantidad++) %
+			     cola->capacidad] = nodo;
+	pthread_mutex_unlock(&cola->mutex);
+	return hay_lugar;
+}
+
+/**
+ * Recibe una cola y un booleano, y saca un sub-árbol de su final (o de su
+ * principio, si robar es true). Devuelve NULL si la cola está vacía.
+*/
+struct nodo_abb *cola_sacar(struct cola_tareas *cola, bool robar)
+{
+	struct nodo_abb *nodo = NULL;
+	pthread_mutex_lock(&cola->mutex);
+	if (cola->cantidad > 0) {
+		cola->cantidad--;
+		if (robar) {
+			nodo = cola->tareas[cola->inicio];
+			cola->inicio = (cola->inicio + 1) % cola->capacidad;
+		} else {
+			nodo = cola->tareas[(cola->inicio + cola->cantidad) %
+					    cola->capacidad];
+		}
+	}
+	pthread_mutex_unlock(&cola->mutex);
+	return nodo;
+}
+
+/**
+ * Recibe un recorrido, el índice de un hilo y un sub-árbol, y lo recorre.
+ * Mientras el sub-árbol sea grande, invoca la función con la raíz, deja el
+ * hijo derecho en la cola del hilo (para él mismo o para que lo robe otro)
+ * y sigue por el izquierdo. Los sub-árboles chicos los recorre enteros, y
+ * también el hijo derecho si la cola ya no se puede agrandar: con tantos
+ * sub-árboles pendientes, los demás hilos tienen trabajo de sobra.
+ * Devuelve la cantidad de veces que invocó la función.
+*/
+size_t recorrer_tarea(struct recorrido_paralelo *recorrido, size_t indice,
+		      struct nodo_abb *nodo)
+{
+	void *aux = recorrido->aux ? recorrido->aux[indice] : NULL;
+	size_t invocaciones = 0;
+	while (nodo && !atomic_load_explicit(&recorrido->cortado,
+					     memory_order_relaxed)) {
+		if (nodo->cantidad <= PARALELO_UMBRAL) {
+			if (!recorrer_sub_arbol(recorrido->arbol, nodo, INORDEN,
+						recorrido->funcion, aux,
+						&invocaciones))
+				atomic_store(&recorrido->cortado, true);
+			break;
+		}
+		if (nodo->derecha) {
+			atomic_fetch_add(&recorrido->pendientes, 1);
+			if (!cola_agregar(&recorrido->colas[indice],
+					  nodo->derecha)) {
+				atomic_fetch_sub(&recorrido->pendientes, 1);
+				if (!recorrer_sub_arbol(recorrido->arbol,
+							nodo->derecha, INORDEN,
+							recorrido->funcion, aux,
+							&invocaciones)) {
+					atomic_store(&recorrido->cortado, true);
+					break;
+				}
+			}
+		}
+		invocaciones++;
+		if (!recorrido->funcion(nodo->elemento, aux)) {
+			atomic_store(&recorrido->cortado, true);
+			break;
+		}
+		nodo = nodo->izquierda;
+	}
+	return invocaciones;
+}
+
+/**
+ * Recibe un struct trabajador y procesa sub-árboles, primero de su propia
+ * cola y si está vacía robándole a las demás, hasta que no quede ninguno
+ * pendiente en ningún hilo.
+*/
+void *trabajar(void *datos)
+{
+	struct trabajador *trabajador = datos;
+	struct recorrido_paralelo *recorrido = trabajador->recorrido;
+	size_t indice = trabajador->indice;
+	size_t invocaciones = 0;
+	while (atomic_load(&recorrido->pendientes) > 0) {
+		struct nodo_abb *nodo =
+			cola_sacar(&recorrido->colas[indice], false);
+		for (size_t i = 1; !nodo && i < recorrido->hilos; i++)
+			nodo = cola_sacar(
+				&recorrido->colas[(indice + i) %
+						  recorrido->hilos],
+				true);
+		if (!nodo) {
+			sched_yield();
+			continue;
+		}
+		invocaciones += recorrer_tarea(recorrido, indice, nodo);
+		atomic_fetch_sub(&recorrido->pendientes, 1);
+	}
+	atomic_fetch_add(&recorrido->invocaciones, invocaciones);
+	return NULL;
+}
+
+/**
+ * Recibe un recorrido y libera sus colas.
+*/
+void destruir_colas(struct recorrido_paralelo *recorrido)
+{
+	for (size_t i = 0; i < recorrido->hilos; i++) {
+		pthread_mutex_destroy(&recorrido->colas[i].mutex);
+		free(recorrido->colas[i].tareas);
+	}
+	free(recorrido->colas);
+}
+
+/**
+ * Recibe un recorrido con los hilos ya elegidos y una capacidad, y reserva
+ * una cola con esa capacidad para cada hilo. Devuelve false en caso de error.
+*/
+bool crear_colas(struct recorrido_paralelo *recorrido, size_t capacidad)
+{
+	recorrido->colas =
+		calloc(recorrido->hilos, sizeof(struct cola_tareas));
+	if (!recorrido->colas)
+		return false;
+	bool creadas = true;
+	for (size_t i = 0; i < recorrido->hilos; i++) {
+		pthread_mutex_init(&recorrido->colas[i].mutex, NULL);
+		recorrido->colas[i].tareas =
+			malloc(capacidad * sizeof(struct nodo_abb *));
+		recorrido->colas[i].capacidad = capacidad;
+		creadas = creadas && recorrido->colas[i].tareas;
+	}
+	if (!creadas)
+		destruir_colas(recorrido);
+	return creadas;
+}
+
+size_t abb_con_cada_elemento_paralelo(abb_t *arbol,
+				      bool (*funcion)(void *, void *),
+				      void **aux, size_t hilos)
+{
+	if (!arbol || !funcion)
+		return 0;
+	if (hilos > PARALELO_HILOS_MAXIMOS)
+		hilos = PARALELO_HILOS_MAXIMOS;
+	if (arbol->multiclave || arbol->mapeado || arbol->multiconjunto ||
+	    hilos <= 1 || arbol->tamanio <= PARALELO_UMBRAL)
+		return abb_con_cada_elemento(arbol, INORDEN, funcion,
+					     aux ? aux[0] : NULL);
+
+	/**
+	 * Cada hilo deja en su cola a lo sumo un sub-árbol por nivel del camino
+	 * que está recorriendo, y solo roba cuando su cola está vacía, así que
+	 * ninguna cola tiene más sub-árboles que la altura del arbol.
+	 * Pero no se reservan de ese tamaño, que en un arbol degenerado
+	 * puede ser enorme: empiezan con lugar para PARALELO_COLA_INICIAL
+	 * y se agrandan si hace falta.
+	*/
+	size_t capacidad = abb_cota_altura(arbol) + 1;
+	if (capacidad > PARALELO_COLA_INICIAL)
+		capacidad = PARALELO_COLA_INICIAL;
+	struct recorrido_paralelo recorrido = { .arbol = arbol,
+						.funcion = funcion,
+						.aux = aux,
+						.hilos = hilos };
+	if (!crear_colas(&recorrido, capacidad))
+		return abb_con_cada_elemento(arbol, INORDEN, funcion,
+					     aux ? aux[0] : NULL);
+	atomic_init(&recorrido.pendientes, 1);
+	atomic_init(&recorrido.invocaciones, 0);
+	atomic_init(&recorrido.cortado, false);
+	cola_agregar(&recorrido.colas[0], arbol->nodo_raiz);
+
+	pthread_t ids[PARALELO_HILOS_MAXIMOS];
+	struct trabajador trabajadores[PARALELO_HILOS_MAXIMOS];
+	size_t creados = 0;
+	for (size_t i = 0; i < hilos; i++)
+		trabajadores[i] = (struct trabajador){ .recorrido = &recorrido,
+						       .indice = i };
+	while (creados + 1 < hilos &&
+	       pthread_create(&ids[creados], NULL, trabajar,
+			      &trabajadores[creados + 1]) == 0)
+		creados++;
+	/**
+	 * Si no se pudieron crear todos los hilos, los sub-árboles que queden
+	 * en colas sin dueño los roban los demás, así que no se pierde ninguno.
+	*/
+	trabajar(&trabajadores[0]);
+	for (size_t i = 0; i < creados; i++)
+		pthread_join(ids[i], NULL);
+
+	destruir_colas(&recorrido);
+	return atomic_load(&recorrido.invocaciones);
+}
+
+/**
+ * Un pedido de armado en paralelo: el arbol, el rango [inicio, fin) de los
+ * arrays de nodos y elementos, cuántos hilos puede usar, y dónde queda la
+ * raíz.
+*/
+struct armado_paralelo {
+	abb_t *arbol;
+	struct nodo_abb *nodos;
+	void **elementos;
+	size_t inicio;
+	size_t fin;
+	size_t hilos;
+	struct nodo_abb *raiz;
+};
+
+/**
+ * Recibe un struct armado_paralelo y arma su sub-árbol como
+ * armar_sub_arbol_ordenado. Si puede usar más de un hilo y el rango no es
+ * chico, arma la mitad izquierda en un hilo nuevo con la mitad de los hilos,
+ * y la derecha en el actual con el resto. Como los nodos ya están reservados,
+ * los hilos no se tienen que coordinar para nada más que esperar al otro.
+*/
+void *armar_en_paralelo(void *datos)
+{
+	struct armado_paralelo *armado = datos;
+	if (armado->hilos <= 1 ||
+	    armado->fin - armado->inicio <= PARALELO_UMBRAL) {
+		armado->raiz = armar_sub_arbol_ordenado(
+			armado->arbol, armado->nodos, armado->elementos,
+			armado->inicio, armado->fin);
+		return NULL;
+	}
+	size_t medio = armado->inicio + (armado->fin - armado->inicio) / 2;
+	struct armado_paralelo izquierda = *armado, derecha = *armado;
+	izquierda.fin = medio;
+	izquierda.hilos = armado->hilos / 2;
+	derecha.inicio = medio + 1;
+	derecha.hilos = armado->hilos - izquierda.hilos;
+	pthread_t id;
+	bool creado = pthread_create(&id, NULL, armar_en_paralelo,
+				     &izquierda) == 0;
+	armar_en_paralelo(&derecha);
+	if (creado)
+		pthread_join(id, NULL);
+	else
+		armar_en_paralelo(&izquierda);
+
+	struct nodo_abb *nodo = nodo_en(armado->arbol, armado->nodos, medio);
+	nodo->elemento = armado->elementos[medio];
+	nodo->izquierda = izquierda.raiz;
+	nodo->derecha = derecha.raiz;
+	nodo_actualizar(armado->arbol, nodo);
+	armado->raiz = nodo;
+	return NULL;
+}
+
+abb_t *abb_crear_desde_ordenado_paralelo(abb_comparador comparador,
+					 void **elementos, size_t n,
+					 size_t hilos)
+{
+	if (!elementos && n > 0)
+		return NULL;
+	abb_t *arbol = abb_crear_balanceado(comparador);
+	if (!arbol || n == 0)
+		return arbol;
+	struct nodo_abb *nodos = abb_pool_obtener_contiguos(arbol->pool, n);
+	if (!nodos) {
+		abb_destruir(arbol);
+		return NULL;
+	}
+	ABB_CONTAR(arbol, nodos_reservados, n);
+	struct armado_paralelo armado = { .arbol = arbol,
+					  .nodos = nodos,
+					  .elementos = elementos,
+					  .inicio = 0,
+					  .fin = n,
+					  .hilos = hilos };
+	armar_en_paralelo(&armado);
+	arbol->nodo_raiz = armado.raiz;
+	arbol->tamanio = n;
+	return arbol;
+}
@@ -0,0 +1,39 @@
+#ifndef __ABB_PARALELO__H__
+#define __ABB_PARALELO__H__
+
+#include "abb.h"
+
+/**
+ * Invoca la funcion con cada elemento del arbol usando la cantidad de hilos
+ * recibida (el hilo que llama es uno de ellos). El hilo i pasa aux[i] como
+ * segundo parámetro, así cada hilo puede acumular en su propio lugar sin
+ * sincronizarse con los demás; aux puede ser NULL, y entonces se pasa NULL.
+ *
+ * Los sub-árboles se reparten entre los hilos a medida que se recorren: cada
+ * hilo tiene una cola de sub-árboles pendientes, y cuando se le vacía le
+ * roba a otro el más grande que tenga. Los elementos no se visitan en ningún
+ * orden en particular, y la función puede ejecutarse a la vez en distintos
+ * hilos. Si devuelve false, los hilos dejan de invocarla lo antes posible.
+ * En los arboles multiclave, en los multiconjuntos y en los mapeados (ver
+ * abb_archivo.h) el recorrido es secuencial, con aux[0].
+ *
+ * Hace falta compilar con -pthread.
+ *
+ * Devuelve la cantidad de veces que fue invocada la función.
+ */
+size_t abb_con_cada_elemento_paralelo(abb_t *arbol,
+				      bool (*funcion)(void *, void *),
+				      void **aux, size_t hilos);
+
+/**
+ * Igual que abb_crear_desde_ordenado, pero arma los sub-árboles izquierdo y
+ * derecho de los primeros niveles en hilos distintos, hasta usar la cantidad
+ * de hilos recibida.
+ *
+ * Devuelve un puntero al arbol creado o NULL en caso de error.
+ */
+abb_t *abb_crear_desde_ordenado_paralelo(abb_comparador comparador,
+					 void **elementos, size_t n,
+					 size_t hilos);
+
+#endif // __ABB_PARALELO__H__
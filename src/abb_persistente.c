@@ -0,0 +1,392 @@
+#include "abb_persistente.h"
+#include "abb_estructura_privada.h"
+#include <stdlib.h>
+
+/**
+ * Recibe un nodo (o NULL) y le agrega una referencia. Devuelve el nodo.
+*/
+struct nodo_persistente *persistente_retener(struct nodo_persistente *nodo)
+{
+	if (nodo)
+		atomic_fetch_add_explicit(&nodo->referencias, 1,
+					  memory_order_relaxed);
+	return nodo;
+}
+
+/**
+ * Recibe un nodo (o NULL) y le quita una referencia. Si era la última, libera
+ * el nodo y les quita una referencia a sus hijos.
+ *
+ * La resta es acq_rel, para que las lecturas que otros hilos hicieron del nodo
+ * antes de soltarlo terminen antes del free.
+*/
+void persistente_soltar(struct nodo_persistente *nodo)
+{
+	while (nodo && atomic_fetch_sub_explicit(&nodo->referencias, 1,
+						 memory_order_acq_rel) == 1) {
+		struct nodo_persistente *derecha = nodo->derecha;
+		persistente_soltar(nodo->izquierda);
+		free(nodo);
+		nodo = derecha;
+	}
+}
+
+size_t persistente_altura(struct nodo_persistente *nodo)
+{
+	return nodo ? nodo->altura : 0;
+}
+
+/**
+ * Recibe un elemento y dos hijos, de los que se queda con una referencia
+ * cada uno, y crea un nodo con ellos. Si no hay memoria, suelta los hijos y
+ * pone error en true.
+ * Devuelve el nodo creado, o NULL en caso de error.
+*/
+struct nodo_persistente *persistente_nodo(void *elemento,
+					  struct nodo_persistente *izquierda,
+					  struct nodo_persistente *derecha,
+					  bool *error)
+{
+	struct nodo_persistente *nodo = malloc(sizeof(struct nodo_persistente));
+	if (!nodo) {
+		persistente_soltar(izquierda);
+		persistente_soltar(derecha);
+		*error = true;
+		return NULL;
+	}
+	nodo->elemento = elemento;
+	nodo->izquierda = izquierda;
+	nodo->derecha = derecha;
+	size_t altura_izquierda = persistente_altura(izquierda);
+	size_t altura_derecha = persistente_altura(derecha);
+	nodo->altura = (altura_izquierda > altura_derecha ? altura_izquierda :
+							    altura_derecha) +
+		       1;
+	atomic_init(&nodo->referencias, 1);
+	return nodo;
+}
+
+/**
+ * Igual que persistente_nodo, pero si las alturas de los hijos difieren en 2
+ * arma el resultado de la rotación de AVL que corresponda con nodos nuevos,
+ * ya que el hijo alto puede estar compartido y no se puede rotar en el lugar.
+ * Se queda con las referencias a los dos hijos en cualquier caso.
+*/
+struct nodo_persistente *persistente_balancear(
+	void *elemento, struct nodo_persistente *izquierda,
+	struct nodo_persistente *derecha, bool *error)
+{
+	size_t altura_izquierda = persistente_altura(izquierda);
+	size_t altura_derecha = persistente_altura(derecha);
+	if (altura_izquierda > altura_derecha + 1) {
+		struct nodo_persistente *alto = izquierda, *medio = alto->derecha;
+		struct nodo_persistente *nuevo_derecho, *raiz;
+		if (persistente_altura(medio) >
+		    persistente_altura(alto->izquierda)) {
+			struct nodo_persistente *nuevo_izquierdo =
+				persistente_nodo(
+					alto->elemento,
+					persistente_retener(alto->izquierda),
+					persistente_retener(medio->izquierda),
+					error);
+			nuevo_derecho = persistente_nodo(
+				elemento, persistente_retener(medio->derecha),
+				derecha, error);
+			raiz = persistente_nodo(medio->elemento,
+						nuevo_izquierdo, nuevo_derecho,
+						error);
+		} else {
+			nuevo_derecho = persistente_nodo(
+				elemento, persistente_retener(medio), derecha,
+				error);
+			raiz = persistente_nodo(
+				alto->elemento,
+				persistente_retener(alto->izquierda),
+				nuevo_derecho, error);
+		}
+		persistente_soltar(alto);
+		if (*error) {
+			persistente_soltar(raiz);
+			return NULL;
+		}
+		return raiz;
+	}
+	if (altura_derecha > altura_izquierda + 1) {
+		struct nodo_persistente *alto = derecha, *medio = alto->izquierda;
+		struct nodo_persistente *nuevo_izquierdo, *raiz;
+		if (persistente_altura(medio) >
+		    persistente_altura(alto->derecha)) {
+			nuevo_izquierdo = persistente_nodo(
+				elemento, izquierda,
+				persistente_retener(medio->izquierda), error);
+			struct nodo_persistente *nuevo_derecho =
+				persistente_nodo(
+					alto->elemento,
+					persistente_retener(medio->derecha),
+					persistente_retener(alto->derecha),
+					error);
+			raiz = persistente_nodo(medio->elemento,
+						nuevo_izquierdo, nuevo_derecho,
+						error);
+		} else {
+			nuevo_izquierdo = persistente_nodo(
+				elemento, izquierda, persistente_retener(medio),
+				error);
+			raiz = persistente_nodo(
+				alto->elemento, nuevo_izquierdo,
+				persistente_retener(alto->derecha), error);
+		}
+		persistente_soltar(alto);
+		if (*error) {
+			persistente_soltar(raiz);
+			return NULL;
+		}
+		return raiz;
+	}
+	return persistente_nodo(elemento, izquierda, derecha, error);
+}
+
+/**
+ * Recibe un nodo, un elemento, un comparador y un puntero a error, y devuelve
+ * la raíz de un sub-árbol nuevo con los elementos del nodo más el recibido.
+ * Copia los nodos del camino y comparte los demás (a los que les agrega una
+ * referencia). Los iguales van a la izquierda, como en abb_insertar.
+*/
+struct nodo_persistente *persistente_insertar(struct nodo_persistente *nodo,
+					      void *elemento,
+					      abb_comparador comparador,
+					      bool *error)
+{
+	if (!nodo)
+		return persistente_nodo(elemento, NULL, NULL, error);
+	if (comparador(nodo->elemento, elemento) >= 0) {
+		struct nodo_persistente *izquierda = persistente_insertar(
+			nodo->izquierda, elemento, comparador, error);
+		if (*error)
+			return NULL;
+		return persistente_balancear(nodo->elemento, izquierda,
+					     persistente_retener(nodo->derecha),
+					     error);
+	}
+	struct nodo_persistente *derecha =
+		persistente_insertar(nodo->derecha, elemento, comparador, error);
+	if (*error)
+		return NULL;
+	return persistente_balancear(nodo->elemento,
+				     persistente_retener(nodo->izquierda),
+				     derecha, error);
+}
+
+/**
+ * Recibe un nodo no NULL y devuelve la raíz de un sub-árbol nuevo sin su
+ * mayor elemento, que guarda en maximo.
+*/
+struct nodo_persistente *persistente_quitar_maximo(
+	struct nodo_persistente *nodo, void **maximo, bool *error)
+{
+	if (!nodo->derecha) {
+		*maximo = nodo->elemento;
+		return persistente_retener(nodo->izquierda);
+	}
+	struct nodo_persistente *derecha =
+		persistente_quitar_maximo(nodo->derecha, maximo, error);
+	if (*error)
+		return NULL;
+	return persistente_balancear(nodo->elemento,
+				     persistente_retener(nodo->izquierda),
+				     derecha, error);
+}
+
+/**
+ * Igual que persistente_insertar, pero devuelve un sub-árbol sin el primer
+ * elemento igual al recibido que encuentre al bajar (que tiene que estar), y
+ * lo guarda en quitado.
+*/
+struct nodo_persistente *persistente_quitar(struct nodo_persistente *nodo,
+					    void *elemento,
+					    abb_comparador comparador,
+					    void **quitado, bool *error)
+{
+	int comparacion = comparador(nodo->elemento, elemento);
+	if (comparacion > 0) {
+		struct nodo_persistente *izquierda =
+			persistente_quitar(nodo->izquierda, elemento,
+					   comparador, quitado, error);
+		if (*error)
+			return NULL;
+		return persistente_balancear(nodo->elemento, izquierda,
+					     persistente_retener(nodo->derecha),
+					     error);
+	}
+	if (comparacion < 0) {
+		struct nodo_persistente *derecha =
+			persistente_quitar(nodo->derecha, elemento, comparador,
+					   quitado, error);
+		if (*error)
+			return NULL;
+		return persistente_balancear(
+			nodo->elemento, persistente_retener(nodo->izquierda),
+			derecha, error);
+	}
+	*quitado = nodo->elemento;
+	if (!nodo->izquierda || !nodo->derecha)
+		return persistente_retener(nodo->izquierda ? nodo->izquierda :
+							     nodo->derecha);
+	void *maximo;
+	struct nodo_persistente *izquierda =
+		persistente_quitar_maximo(nodo->izquierda, &maximo, error);
+	if (*error)
+		return NULL;
+	return persistente_balancear(maximo, izquierda,
+				     persistente_retener(nodo->derecha), error);
+}
+
+/**
+ * Recibe una versión, una raíz y un tamaño, y crea una versión nueva con el
+ * comparador de la recibida. Si no hay memoria suelta la raíz.
+ * Devuelve la versión nueva o NULL en caso de error.
+*/
+abb_version_t *version_nueva(abb_version_t *version,
+			     struct nodo_persistente *raiz, size_t tamanio)
+{
+	abb_version_t *nueva = malloc(sizeof(abb_version_t));
+	if (!nueva) {
+		persistente_soltar(raiz);
+		return NULL;
+	}
+	nueva->raiz = raiz;
+	nueva->comparador = version->comparador;
+	nueva->tamanio = tamanio;
+	atomic_init(&nueva->referencias, 1);
+	return nueva;
+}
+
+abb_version_t *abb_version_crear(abb_comparador comparador)
+{
+	if (!comparador)
+		return NULL;
+	abb_version_t vacia = { .comparador = comparador };
+	return version_nueva(&vacia, NULL, 0);
+}
+
+abb_version_t *abb_version_insertar(abb_version_t *version, void *elemento)
+{
+	if (!version)
+		return NULL;
+	bool error = false;
+	struct nodo_persistente *raiz = persistente_insertar(
+		version->raiz, elemento, version->comparador, &error);
+	if (error)
+		return NULL;
+	return version_nueva(version, raiz, version->tamanio + 1);
+}
+
+abb_version_t *abb_version_quitar(abb_version_t *version, void *elemento,
+				  void **quitado)
+{
+	if (quitado)
+		*quitado = NULL;
+	if (!version)
+		return NULL;
+	/**
+	 * Primero lo busco, así si no está no se copia el camino para nada.
+	*/
+	if (!abb_version_buscar(version, elemento))
+		return abb_version_tomar(version);
+	bool error = false;
+	void *elemento_quitado = NULL;
+	struct nodo_persistente *raiz =
+		persistente_quitar(version->raiz, elemento, version->comparador,
+				   &elemento_quitado, &error);
+	if (error)
+		return NULL;
+	abb_version_t *nueva = version_nueva(version, raiz, version->tamanio - 1);
+	if (nueva && quitado)
+		*quitado = elemento_quitado;
+	return nueva;
+}
+
+void *abb_version_buscar(abb_version_t *version, void *elemento)
+{
+	if (!version)
+		return NULL;
+	struct nodo_persistente *nodo = version->raiz;
+	while (nodo) {
+		int comparacion = version->comparador(nodo->elemento, elemento);
+		if (comparacion == 0)
+			return nodo->elemento;
+		nodo = comparacion > 0 ? nodo->izquierda : nodo->derecha;
+	}
+	return NULL;
+}
+
+size_t abb_version_tamanio(abb_version_t *version)
+{
+	if (!version)
+		return 0;
+	return version->tamanio;
+}
+
+/**
+ * Recibe un nodo, un recorrido, la función con su aux y un contador, y
+ * recorre el sub-árbol invocando la función con cada elemento. Devuelve false
+ * si la función devolvió false.
+*/
+bool persistente_recorrer(struct nodo_persistente *nodo,
+			  abb_recorrido recorrido,
+			  bool (*funcion)(void *, void *), void *aux,
+			  size_t *contador)
+{
+	if (!nodo)
+		return true;
+	if (recorrido == PREORDEN) {
+		(*contador)++;
+		if (!funcion(nodo->elemento, aux))
+			return false;
+	}
+	if (!persistente_recorrer(nodo->izquierda, recorrido, funcion, aux,
+				  contador))
+		return false;
+	if (recorrido == INORDEN) {
+		(*contador)++;
+		if (!funcion(nodo->elemento, aux))
+			return false;
+	}
+	if (!persistente_recorrer(nodo->derecha, recorrido, funcion, aux,
+				  contador))
+		return false;
+	if (recorrido == POSTORDEN) {
+		(*contador)++;
+		return funcion(nodo->elemento, aux);
+	}
+	return true;
+}
+
+size_t abb_version_con_cada_elemento(abb_version_t *version,
+				     abb_recorrido recorrido,
+				     bool (*funcion)(void *, void *),
+				     void *aux)
+{
+	if (!version || !funcion)
+		return 0;
+	size_t contador = 0;
+	persistente_recorrer(version->raiz, recorrido, funcion, aux, &contador);
+	return contador;
+}
+
+abb_version_t *abb_version_tomar(abb_version_t *version)
+{
+	if (version)
+		atomic_fetch_add_explicit(&version->referencias, 1,
+					  memory_order_relaxed);
+	return version;
+}
+
+void abb_version_liberar(abb_version_t *version)
+{
+	if (!version || atomic_fetch_sub_explicit(&version->referencias, 1,
+						  memory_order_acq_rel) != 1)
+		return;
+	persistente_soltar(version->raiz);
+	free(version);
+}
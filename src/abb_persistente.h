@@ -0,0 +1,76 @@
+#ifndef __ABB_PERSISTENTE__H__
+#define __ABB_PERSISTENTE__H__
+
+#include "abb.h"
+
+typedef struct abb_version abb_version_t;
+
+/**
+ * Crea la versión vacía de un arbol persistente: un AVL que nunca se
+ * modifica. Insertar o quitar devuelve una versión nueva, que copia solo los
+ * nodos del camino que cambia (O(log n) nodos) y comparte el resto con la
+ * anterior, que sigue siendo válida y no cambia.
+ *
+ * Cada versión y cada nodo cuentan sus referencias (de forma atómica), así
+ * que se puede leer una versión y liberar otras desde cualquier hilo, aunque
+ * otro esté creando versiones nuevas a partir de ellas.
+ *
+ * Devuelve la versión o NULL en caso de error.
+ */
+abb_version_t *abb_version_crear(abb_comparador comparador);
+
+/**
+ * Devuelve una versión nueva con los elementos de la recibida más el
+ * elemento (admite repetidos). La versión recibida no cambia.
+ *
+ * Devuelve la versión nueva o NULL en caso de error.
+ */
+abb_version_t *abb_version_insertar(abb_version_t *version, void *elemento);
+
+/**
+ * Devuelve una versión nueva con los elementos de la recibida menos uno
+ * igual al elemento, y guarda en quitado (si no es NULL) el elemento quitado,
+ * o NULL si no había ninguno (en ese caso la versión nueva es la misma que
+ * la recibida, con una referencia más). La versión recibida no cambia.
+ *
+ * Devuelve la versión nueva o NULL en caso de error.
+ */
+abb_version_t *abb_version_quitar(abb_version_t *version, void *elemento,
+				  void **quitado);
+
+/**
+ * Busca en la versión un elemento igual al provisto.
+ *
+ * Devuelve el elemento encontrado o NULL si no lo encuentra.
+ */
+void *abb_version_buscar(abb_version_t *version, void *elemento);
+
+/**
+ * Devuelve la cantidad de elementos de la versión, o 0 si es NULL.
+ */
+size_t abb_version_tamanio(abb_version_t *version);
+
+/**
+ * Igual que abb_con_cada_elemento, pero con los elementos de la versión.
+ *
+ * Devuelve la cantidad de veces que fue invocada la función.
+ */
+size_t abb_version_con_cada_elemento(abb_version_t *version,
+				     abb_recorrido recorrido,
+				     bool (*funcion)(void *, void *),
+				     void *aux);
+
+/**
+ * Toma una foto de la versión en O(1): agrega una referencia y la devuelve.
+ * La foto se libera con abb_version_liberar, como cualquier versión.
+ */
+abb_version_t *abb_version_tomar(abb_version_t *version);
+
+/**
+ * Quita una referencia a la versión. Si era la última, la libera junto con
+ * los nodos que no comparta con otras versiones. No libera los elementos,
+ * que pueden estar en otras versiones.
+ */
+void abb_version_liberar(abb_version_t *version);
+
+#endif // __ABB_PERSISTENTE__H__
@@ -0,0 +1,187 @@
+#include "abb_pool.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define POOL_ALINEACION 16
+#define POOL_CAPACIDAD_INICIAL 32
+#define POOL_CAPACIDAD_MAXIMA 4096
+
+/**
+ * Recibe un tamaño y lo redondea hacia arriba al múltiplo de alineacion más
+ * cercano.
+*/
+size_t pool_redondear(size_t tamanio, size_t alineacion)
+{
+	return (tamanio + alineacion - 1) / alineacion * alineacion;
+}
+
+struct abb_pool *abb_pool_crear(size_t tamanio_objeto)
+{
+	return abb_pool_crear_alineado(tamanio_objeto, POOL_ALINEACION);
+}
+
+struct abb_pool *abb_pool_crear_alineado(size_t tamanio_objeto,
+					 size_t alineacion)
+{
+	if (tamanio_objeto < sizeof(void *))
+		tamanio_objeto = sizeof(void *);
+	if (alineacion < sizeof(void *))
+		alineacion = sizeof(void *);
+	struct abb_pool *pool = calloc(1, sizeof(struct abb_pool));
+	if (!pool)
+		return NULL;
+	pool->tamanio_objeto = pool_redondear(tamanio_objeto, alineacion);
+	pool->alineacion = alineacion;
+	pool->capacidad_siguiente = POOL_CAPACIDAD_INICIAL;
+	atomic_init(&pool->referencias, 1);
+	return pool;
+}
+
+/**
+ * Recibe un pool y una capacidad, y reserva un bloque con lugar para esa
+ * cantidad de objetos. La cabecera del bloque y los objetos se reservan en
+ * una única llamada (a calloc, o a aligned_alloc si el pool pide una
+ * alineación mayor a la que garantiza calloc).
+ * Devuelve el bloque creado (sin enlazar al pool) o NULL en caso de error.
+*/
+struct abb_pool_bloque *pool_crear_bloque(struct abb_pool *pool,
+					  size_t capacidad)
+{
+	size_t cabecera = pool_redondear(sizeof(struct abb_pool_bloque),
+					 pool->alineacion);
+	if (capacidad > (SIZE_MAX - cabecera) / pool->tamanio_objeto)
+		return NULL;
+	size_t bytes = cabecera + capacidad * pool->tamanio_objeto;
+	struct abb_pool_bloque *bloque = NULL;
+	if (pool->alineacion <= POOL_ALINEACION) {
+		bloque = calloc(1, bytes);
+	} else {
+		bloque = aligned_alloc(pool->alineacion,
+				       pool_redondear(bytes, pool->alineacion));
+		if (bloque)
+			memset(bloque, 0, bytes);
+	}
+	if (!bloque)
+		return NULL;
+	bloque->capacidad = capacidad;
+	bloque->objetos = (char *)bloque + cabecera;
+	return bloque;
+}
+
+void *abb_pool_obtener(struct abb_pool *pool)
+{
+	if (pool->libres) {
+		void *objeto = pool->libres;
+		pool->libres = *(void **)objeto;
+		memset(objeto, 0, pool->tamanio_objeto);
+		return objeto;
+	}
+	struct abb_pool_bloque *bloque = pool->bloques;
+	if (!bloque || bloque->usados == bloque->capacidad) {
+		bloque = pool_crear_bloque(pool, pool->capacidad_siguiente);
+		if (!bloque)
+			return NULL;
+		if (!pool->bloques)
+			pool->ultimo_bloque = bloque;
+		bloque->siguiente = pool->bloques;
+		pool->bloques = bloque;
+		if (pool->capacidad_siguiente < POOL_CAPACIDAD_MAXIMA)
+			pool->capacidad_siguiente *= 2;
+	}
+	return bloque->objetos + pool->tamanio_objeto * bloque->usados++;
+}
+
+void abb_pool_devolver(struct abb_pool *pool, void *objeto)
+{
+	if (!pool->libres)
+		pool->ultimo_libre = objeto;
+	*(void **)objeto = pool->libres;
+	pool->libres = objeto;
+}
+
+void *abb_pool_obtener_contiguos(struct abb_pool *pool, size_t cantidad)
+{
+	if (cantidad == 0)
+		return NULL;
+	struct abb_pool_bloque *bloque = pool_crear_bloque(pool, cantidad);
+	if (!bloque)
+		return NULL;
+	bloque->usados = cantidad;
+	/**
+	 * Lo enlazo después del primer bloque para que las próximas llamadas a
+	 * abb_pool_obtener sigan usando el lugar libre que le quede a este.
+	*/
+	if (pool->bloques) {
+		bloque->siguiente = pool->bloques->siguiente;
+		pool->bloques->siguiente = bloque;
+		if (pool->ultimo_bloque == pool->bloques)
+			pool->ultimo_bloque = bloque;
+	} else {
+		pool->bloques = bloque;
+		pool->ultimo_bloque = bloque;
+	}
+	return bloque->objetos;
+}
+
+size_t abb_pool_memoria(struct abb_pool *pool)
+{
+	size_t cabecera = pool_redondear(sizeof(struct abb_pool_bloque),
+					 pool->alineacion);
+	size_t bytes = 0;
+	for (struct abb_pool_bloque *bloque = pool->bloques; bloque;
+	     bloque = bloque->siguiente)
+		bytes += cabecera + bloque->capacidad * pool->tamanio_objeto;
+	return bytes;
+}
+
+struct abb_pool *abb_pool_compartir(struct abb_pool *pool)
+{
+	atomic_fetch_add_explicit(&pool->referencias, 1, memory_order_relaxed);
+	return pool;
+}
+
+bool abb_pool_absorber(struct abb_pool *destino, struct abb_pool *origen)
+{
+	if (destino == origen ||
+	    atomic_load_explicit(&origen->referencias, memory_order_acquire) !=
+		    1 ||
+	    destino->tamanio_objeto != origen->tamanio_objeto ||
+	    destino->alineacion != origen->alineacion)
+		return false;
+	/**
+	 * Los bloques y los libres de origen van al final de los de destino,
+	 * así abb_pool_obtener sigue usando primero el lugar que le quede al
+	 * primer bloque de destino.
+	*/
+	if (origen->bloques) {
+		if (destino->bloques)
+			destino->ultimo_bloque->siguiente = origen->bloques;
+		else
+			destino->bloques = origen->bloques;
+		destino->ultimo_bloque = origen->ultimo_bloque;
+	}
+	if (origen->libres) {
+		if (destino->libres)
+			*(void **)destino->ultimo_libre = origen->libres;
+		else
+			destino->libres = origen->libres;
+		destino->ultimo_libre = origen->ultimo_libre;
+	}
+	free(origen);
+	return true;
+}
+
+void abb_pool_destruir(struct abb_pool *pool)
+{
+	if (!pool || atomic_fetch_sub_explicit(&pool->referencias, 1,
+					       memory_order_acq_rel) > 1)
+		return;
+	struct abb_pool_bloque *bloque = pool->bloques;
+	while (bloque) {
+		struct abb_pool_bloque *siguiente = bloque->siguiente;
+		free(bloque);
+		bloque = siguiente;
+	}
+	free(pool);
+}
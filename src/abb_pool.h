@@ -0,0 +1,107 @@
+#ifndef ABB_POOL_H_
+#define ABB_POOL_H_
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * Pool de objetos de un mismo tamaño. Reserva la memoria en bloques cuya
+ * capacidad va creciendo (en potencias de dos, hasta un máximo), y reutiliza
+ * los objetos devueltos mediante una lista de libres intrusiva: cada objeto
+ * libre guarda en sus primeros bytes un puntero al siguiente libre.
+ *
+ * El pool no es seguro para usar desde varios hilos a la vez, salvo el
+ * contador de referencias, que es atómico: dos dueños de un pool compartido
+ * lo pueden soltar con abb_pool_destruir desde hilos distintos.
+ */
+struct abb_pool_bloque {
+	struct abb_pool_bloque *siguiente;
+	size_t capacidad;
+	size_t usados;
+	char *objetos;
+};
+
+struct abb_pool {
+	size_t tamanio_objeto;
+	size_t alineacion;
+	size_t capacidad_siguiente;
+	atomic_size_t referencias;
+	struct abb_pool_bloque *bloques;
+	struct abb_pool_bloque *ultimo_bloque;
+	void *libres;
+	void *ultimo_libre;
+};
+
+/**
+ * Crea un pool de objetos de tamaño tamanio_objeto (que se redondea hacia
+ * arriba para que alcance para un puntero y mantenga la alineación).
+ *
+ * Devuelve el pool o NULL en caso de error.
+ */
+struct abb_pool *abb_pool_crear(size_t tamanio_objeto);
+
+/**
+ * Igual que abb_pool_crear, pero cada objeto queda alineado a alineacion
+ * bytes (que debe ser una potencia de dos, y a la que se redondea el tamaño
+ * de los objetos). Sirve para que cada objeto ocupe justo una o más líneas de
+ * cache.
+ *
+ * Devuelve el pool o NULL en caso de error.
+ */
+struct abb_pool *abb_pool_crear_alineado(size_t tamanio_objeto,
+					 size_t alineacion);
+
+/**
+ * Devuelve un objeto del pool con su memoria en cero, o NULL si no se pudo
+ * reservar memoria.
+ */
+void *abb_pool_obtener(struct abb_pool *pool);
+
+/**
+ * Devuelve al pool un objeto obtenido con abb_pool_obtener, para que pueda
+ * ser reutilizado.
+ */
+void abb_pool_devolver(struct abb_pool *pool, void *objeto);
+
+/**
+ * Reserva un bloque con lugar para al menos cantidad objetos contiguos y
+ * devuelve un puntero al primero, o NULL en caso de error. Los objetos se
+ * liberan junto con el pool, o de a uno con abb_pool_devolver.
+ */
+void *abb_pool_obtener_contiguos(struct abb_pool *pool, size_t cantidad);
+
+/**
+ * Devuelve la cantidad de bytes que reservó el pool en todos sus bloques
+ * (cabeceras, objetos en uso y objetos libres), sin contar el struct del pool.
+ * Tarda O(cantidad de bloques).
+ */
+size_t abb_pool_memoria(struct abb_pool *pool);
+
+/**
+ * Agrega una referencia al pool, para que lo usen dos dueños (por ejemplo,
+ * dos arboles que se reparten los nodos de uno). Cada dueño tiene que
+ * llamar a abb_pool_destruir, y el pool se libera con la última llamada.
+ *
+ * Devuelve el pool recibido.
+ */
+struct abb_pool *abb_pool_compartir(struct abb_pool *pool);
+
+/**
+ * Pasa todos los bloques y objetos libres de origen al final de los de
+ * destino, y libera origen, en O(1). Los dos pools tienen que tener el mismo
+ * tamaño de objeto y alineación, y origen no puede estar compartido.
+ *
+ * Devuelve false (sin modificar ninguno de los dos) si no se cumple alguna
+ * de esas condiciones.
+ */
+bool abb_pool_absorber(struct abb_pool *destino, struct abb_pool *origen);
+
+/**
+ * Quita una referencia al pool. Si era la última, libera todos los bloques
+ * del pool (y con ellos todos los objetos que se hayan obtenido) y el pool en
+ * sí. Tarda O(cantidad de bloques).
+ */
+void abb_pool_destruir(struct abb_pool *pool);
+
+#endif // ABB_POOL_H_
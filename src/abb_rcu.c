@@ -0,0 +1,427 @@
+#include "abb_rcu.h"
+#include "abb_estructura_privada.h"
+#include "abb_pool.h"
+#include <string.h>
+
+#define RCU_INACTIVO UINT64_MAX
+
+/**
+ * Estado de una escritura: la versión que llevan los nodos que crea, los
+ * nodos reservados que todavía no usó y los nodos publicados que dejó de
+ * usar, que hay que retirar cuando publique la raíz nueva.
+*/
+struct escritura_rcu {
+	abb_rcu_t *rcu;
+	uint64_t version;
+	struct nodo_rcu *reservados;
+	struct nodo_rcu *retirados;
+};
+
+abb_rcu_t *abb_rcu_crear(abb_comparador comparador)
+{
+	if (!comparador)
+		return NULL;
+	abb_rcu_t *rcu = calloc(1, sizeof(abb_rcu_t));
+	if (!rcu)
+		return NULL;
+	rcu->pool = abb_pool_crear(sizeof(struct nodo_rcu));
+	if (!rcu->pool || pthread_mutex_init(&rcu->escritores, NULL) != 0) {
+		abb_pool_destruir(rcu->pool);
+		free(rcu);
+		return NULL;
+	}
+	atomic_init(&rcu->raiz, NULL);
+	atomic_init(&rcu->epoca, 0);
+	atomic_init(&rcu->tamanio, 0);
+	rcu->comparador = comparador;
+	return rcu;
+}
+
+/**
+ * Recibe un nodo y devuelve su altura, o 0 si es NULL.
+*/
+size_t rcu_altura(struct nodo_rcu *nodo)
+{
+	return nodo ? nodo->altura : 0;
+}
+
+/**
+ * Recibe una escritura, un elemento y dos sub-árboles, y arma con uno de los
+ * nodos reservados un nodo nuevo con ese elemento y esos hijos.
+*/
+struct nodo_rcu *rcu_nodo(struct escritura_rcu *escritura, void *elemento,
+			  struct nodo_rcu *izquierda, struct nodo_rcu *derecha)
+{
+	struct nodo_rcu *nodo = escritura->reservados;
+	escritura->reservados = nodo->siguiente;
+	size_t altura_izquierda = rcu_altura(izquierda);
+	size_t altura_derecha = rcu_altura(derecha);
+	nodo->elemento = elemento;
+	nodo->izquierda = izquierda;
+	nodo->derecha = derecha;
+	nodo->altura = (altura_izquierda > altura_derecha ? altura_izquierda :
+							    altura_derecha) +
+		       1;
+	nodo->version = escritura->version;
+	nodo->siguiente = NULL;
+	return nodo;
+}
+
+/**
+ * Recibe una escritura y un nodo que deja de formar parte del arbol. Si lo
+ * creó esta misma escritura ningún lector lo vio, así que vuelve a los
+ * reservados; si no, se retira.
+*/
+void rcu_descartar(struct escritura_rcu *escritura, struct nodo_rcu *nodo)
+{
+	if (nodo->version == escritura->version) {
+		nodo->siguiente = escritura->reservados;
+		escritura->reservados = nodo;
+	} else {
+		nodo->siguiente = escritura->retirados;
+		escritura->retirados = nodo;
+	}
+}
+
+/**
+ * Recibe una escritura, un elemento y dos sub-árboles balanceados cuyas
+ * alturas difieren en 2 como máximo, y arma un sub-árbol balanceado con el
+ * elemento en el medio, aplicando la rotación simple o doble que
+ * corresponda. Como los nodos no se pueden modificar, rotar arma copias de
+ * los nodos que cambian y descarta los originales.
+ * Devuelve la raíz del sub-árbol armado.
+*/
+struct nodo_rcu *rcu_balancear(struct escritura_rcu *escritura,
+			       void *elemento, struct nodo_rcu *izquierda,
+			       struct nodo_rcu *derecha)
+{
+	size_t altura_izquierda = rcu_altura(izquierda);
+	size_t altura_derecha = rcu_altura(derecha);
+	if (altura_izquierda <= altura_derecha + 1 &&
+	    altura_derecha <= altura_izquierda + 1)
+		return rcu_nodo(escritura, elemento, izquierda, derecha);
+	/**
+	 * Copio los nodos que participan de la rotación antes de descartarlos,
+	 * porque si son de esta escritura vuelven a los reservados y los
+	 * próximos rcu_nodo los reutilizan.
+	*/
+	if (altura_izquierda > altura_derecha) {
+		struct nodo_rcu hijo = *izquierda;
+		rcu_descartar(escritura, izquierda);
+		if (rcu_altura(hijo.izquierda) >= rcu_altura(hijo.derecha))
+			return rcu_nodo(escritura, hijo.elemento,
+					hijo.izquierda,
+					rcu_nodo(escritura, elemento,
+						 hijo.derecha, derecha));
+		struct nodo_rcu nieto = *hijo.derecha;
+		rcu_descartar(escritura, hijo.derecha);
+		struct nodo_rcu *nueva_izquierda =
+			rcu_nodo(escritura, hijo.elemento, hijo.izquierda,
+				 nieto.izquierda);
+		struct nodo_rcu *nueva_derecha = rcu_nodo(
+			escritura, elemento, nieto.derecha, derecha);
+		return rcu_nodo(escritura, nieto.elemento, nueva_izquierda,
+				nueva_derecha);
+	}
+	struct nodo_rcu hijo = *derecha;
+	rcu_descartar(escritura, derecha);
+	if (rcu_altura(hijo.derecha) >= rcu_altura(hijo.izquierda))
+		return rcu_nodo(escritura, hijo.elemento,
+				rcu_nodo(escritura, elemento, izquierda,
+					 hijo.izquierda),
+				hijo.derecha);
+	struct nodo_rcu nieto = *hijo.izquierda;
+	rcu_descartar(escritura, hijo.izquierda);
+	struct nodo_rcu *nueva_izquierda = rcu_nodo(
+		escritura, elemento, izquierda, nieto.izquierda);
+	struct nodo_rcu *nueva_derecha = rcu_nodo(
+		escritura, hijo.elemento, nieto.derecha, hijo.derecha);
+	return rcu_nodo(escritura, nieto.elemento, nueva_izquierda,
+			nueva_derecha);
+}
+
+/**
+ * Recibe una escritura, la raíz de un sub-árbol y un elemento, y devuelve la
+ * raíz de una copia del sub-árbol con el elemento insertado. Solo se copian
+ * los nodos del camino; el resto se comparte con el sub-árbol original.
+*/
+struct nodo_rcu *rcu_insertar_nodo(struct escritura_rcu *escritura,
+				   struct nodo_rcu *nodo, void *elemento)
+{
+	if (!nodo)
+		return rcu_nodo(escritura, elemento, NULL, NULL);
+	rcu_descartar(escritura, nodo);
+	if (escritura->rcu->comparador(nodo->elemento, elemento) >= 0)
+		return rcu_balancear(escritura, nodo->elemento,
+				     rcu_insertar_nodo(escritura,
+						       nodo->izquierda,
+						       elemento),
+				     nodo->derecha);
+	return rcu_balancear(escritura, nodo->elemento, nodo->izquierda,
+			     rcu_insertar_nodo(escritura, nodo->derecha,
+					       elemento));
+}
+
+/**
+ * Recibe una escritura y la raíz de un sub-árbol no vacío, y devuelve la raíz
+ * de una copia sin su mayor elemento, que guarda en el puntero recibido.
+*/
+struct nodo_rcu *rcu_quitar_maximo(struct escritura_rcu *escritura,
+				   struct nodo_rcu *nodo, void **maximo)
+{
+	rcu_descartar(escritura, nodo);
+	if (!nodo->derecha) {
+		*maximo = nodo->elemento;
+		return nodo->izquierda;
+	}
+	struct nodo_rcu *derecha =
+		rcu_quitar_maximo(escritura, nodo->derecha, maximo);
+	return rcu_balancear(escritura, nodo->elemento, nodo->izquierda,
+			     derecha);
+}
+
+/**
+ * Recibe una escritura, la raíz de un sub-árbol que contiene un elemento
+ * igual al recibido, y devuelve la raíz de una copia sin el primero de esos
+ * elementos, que guarda en el puntero recibido. Si el nodo tiene dos hijos,
+ * lo reemplaza con su predecesor inorden.
+*/
+struct nodo_rcu *rcu_quitar_nodo(struct escritura_rcu *escritura,
+				 struct nodo_rcu *nodo, void *elemento,
+				 void **quitado)
+{
+	rcu_descartar(escritura, nodo);
+	int comparacion = escritura->rcu->comparador(nodo->elemento, elemento);
+	if (comparacion > 0)
+		return rcu_balancear(escritura, nodo->elemento,
+				     rcu_quitar_nodo(escritura,
+						     nodo->izquierda, elemento,
+						     quitado),
+				     nodo->derecha);
+	if (comparacion < 0)
+		return rcu_balancear(escritura, nodo->elemento,
+				     nodo->izquierda,
+				     rcu_quitar_nodo(escritura, nodo->derecha,
+						     elemento, quitado));
+	*quitado = nodo->elemento;
+	if (!nodo->izquierda || !nodo->derecha)
+		return nodo->izquierda ? nodo->izquierda : nodo->derecha;
+	void *predecesor = NULL;
+	struct nodo_rcu *izquierda =
+		rcu_quitar_maximo(escritura, nodo->izquierda, &predecesor);
+	return rcu_balancear(escritura, predecesor, izquierda, nodo->derecha);
+}
+
+/**
+ * Recibe un arbol y una lista de nodos enlazados por siguiente, y los
+ * devuelve al pool.
+*/
+void rcu_liberar_lista(abb_rcu_t *rcu, struct nodo_rcu *nodo)
+{
+	while (nodo) {
+		struct nodo_rcu *siguiente = nodo->siguiente;
+		abb_pool_devolver(rcu->pool, nodo);
+		nodo = siguiente;
+	}
+}
+
+/**
+ * Recibe un arbol y, si todos los lectores que están buscando empezaron en
+ * la época actual, la avanza. Los nodos retirados dos épocas atrás ya no
+ * pueden estar siendo leídos: los lectores activos empezaron después de que
+ * se publicara la raíz que los dejó afuera. Así que se liberan, y su lista
+ * queda para los que se retiren en la época nueva.
+*/
+void rcu_intentar_avanzar(abb_rcu_t *rcu)
+{
+	uint_fast64_t epoca = atomic_load(&rcu->epoca);
+	for (struct abb_rcu_lector *lector = rcu->lectores; lector;
+	     lector = lector->siguiente) {
+		uint_fast64_t epoca_lector = atomic_load(&lector->epoca);
+		if (epoca_lector != RCU_INACTIVO && epoca_lector != epoca)
+			return;
+	}
+	atomic_store(&rcu->epoca, epoca + 1);
+	size_t vencidos = (epoca + 2) % RCU_EPOCAS;
+	rcu_liberar_lista(rcu, rcu->retirados[vencidos]);
+	rcu->retirados[vencidos] = NULL;
+}
+
+/**
+ * Recibe un arbol y una escritura, toma el mutex de escritores y reserva
+ * todos los nodos que la escritura puede llegar a crear (como mucho 3 por
+ * nivel, si en cada uno hay una rotación doble), así después no puede
+ * fallar a la mitad. Devuelve false si no hay memoria, y en ese caso suelta
+ * el mutex.
+*/
+bool rcu_empezar_escritura(abb_rcu_t *rcu, struct escritura_rcu *escritura)
+{
+	pthread_mutex_lock(&rcu->escritores);
+	*escritura = (struct escritura_rcu){ .rcu = rcu,
+					     .version = ++rcu->version };
+	struct nodo_rcu *raiz =
+		atomic_load_explicit(&rcu->raiz, memory_order_relaxed);
+	size_t necesarios = 3 * (rcu_altura(raiz) + 1);
+	for (size_t i = 0; i < necesarios; i++) {
+		struct nodo_rcu *nodo = abb_pool_obtener(rcu->pool);
+		if (!nodo) {
+			rcu_liberar_lista(rcu, escritura->reservados);
+			pthread_mutex_unlock(&rcu->escritores);
+			return false;
+		}
+		nodo->siguiente = escritura->reservados;
+		escritura->reservados = nodo;
+	}
+	return true;
+}
+
+/**
+ * Recibe un arbol, una escritura y la raíz nueva que armó. Publica la raíz,
+ * retira los nodos que quedaron afuera en la época actual, intenta avanzar
+ * la época, devuelve al pool los nodos reservados que no se usaron y suelta
+ * el mutex de escritores.
+*/
+void rcu_terminar_escritura(abb_rcu_t *rcu, struct escritura_rcu *escritura,
+			    struct nodo_rcu *raiz)
+{
+	atomic_store(&rcu->raiz, raiz);
+	if (escritura->retirados) {
+		struct nodo_rcu *ultimo = escritura->retirados;
+		while (ultimo->siguiente)
+			ultimo = ultimo->siguiente;
+		size_t epoca = atomic_load(&rcu->epoca) % RCU_EPOCAS;
+		ultimo->siguiente = rcu->retirados[epoca];
+		rcu->retirados[epoca] = escritura->retirados;
+	}
+	rcu_intentar_avanzar(rcu);
+	rcu_liberar_lista(rcu, escritura->reservados);
+	pthread_mutex_unlock(&rcu->escritores);
+}
+
+/**
+ * Recibe la raíz de un arbol, un elemento y un abb_comparador, y devuelve el
+ * primer elemento igual al recibido, o NULL si no hay ninguno.
+*/
+void *rcu_buscar_nodo(struct nodo_rcu *nodo, void *elemento,
+		      abb_comparador comparador)
+{
+	while (nodo) {
+		int comparacion = comparador(nodo->elemento, elemento);
+		if (comparacion == 0)
+			return nodo->elemento;
+		nodo = comparacion < 0 ? nodo->derecha : nodo->izquierda;
+	}
+	return NULL;
+}
+
+bool abb_rcu_insertar(abb_rcu_t *rcu, void *elemento)
+{
+	struct escritura_rcu escritura;
+	if (!rcu || !rcu_empezar_escritura(rcu, &escritura))
+		return false;
+	struct nodo_rcu *raiz =
+		atomic_load_explicit(&rcu->raiz, memory_order_relaxed);
+	raiz = rcu_insertar_nodo(&escritura, raiz, elemento);
+	atomic_fetch_add_explicit(&rcu->tamanio, 1, memory_order_relaxed);
+	rcu_terminar_escritura(rcu, &escritura, raiz);
+	return true;
+}
+
+void *abb_rcu_quitar(abb_rcu_t *rcu, void *elemento)
+{
+	struct escritura_rcu escritura;
+	if (!rcu || !rcu_empezar_escritura(rcu, &escritura))
+		return NULL;
+	struct nodo_rcu *raiz =
+		atomic_load_explicit(&rcu->raiz, memory_order_relaxed);
+	void *quitado = NULL;
+	if (rcu_buscar_nodo(raiz, elemento, rcu->comparador)) {
+		raiz = rcu_quitar_nodo(&escritura, raiz, elemento, &quitado);
+		atomic_fetch_sub_explicit(&rcu->tamanio, 1,
+					  memory_order_relaxed);
+	}
+	rcu_terminar_escritura(rcu, &escritura, raiz);
+	return quitado;
+}
+
+size_t abb_rcu_tamanio(abb_rcu_t *rcu)
+{
+	if (!rcu)
+		return 0;
+	return atomic_load_explicit(&rcu->tamanio, memory_order_relaxed);
+}
+
+abb_rcu_lector_t *abb_rcu_lector_crear(abb_rcu_t *rcu)
+{
+	if (!rcu)
+		return NULL;
+	abb_rcu_lector_t *lector = aligned_alloc(CONCURRENTE_LINEA_CACHE,
+						 sizeof(abb_rcu_lector_t));
+	if (!lector)
+		return NULL;
+	atomic_init(&lector->epoca, RCU_INACTIVO);
+	lector->rcu = rcu;
+	pthread_mutex_lock(&rcu->escritores);
+	lector->siguiente = rcu->lectores;
+	rcu->lectores = lector;
+	pthread_mutex_unlock(&rcu->escritores);
+	return lector;
+}
+
+/**
+ * Busca sin tomar ningún lock. Anotar la época y leer la raíz son
+ * secuencialmente consistentes, para que un escritor que mira la época del
+ * lector después de publicar una raíz no lo pueda dar por inactivo mientras
+ * lee una raíz anterior; el resto de la búsqueda son lecturas comunes, ya que
+ * los nodos publicados no cambian.
+*/
+void *abb_rcu_buscar(abb_rcu_lector_t *lector, void *elemento)
+{
+	if (!lector)
+		return NULL;
+	abb_rcu_t *rcu = lector->rcu;
+	atomic_store(&lector->epoca, atomic_load(&rcu->epoca));
+	void *encontrado =
+		rcu_buscar_nodo(atomic_load(&rcu->raiz), elemento,
+				rcu->comparador);
+	atomic_store_explicit(&lector->epoca, RCU_INACTIVO,
+			      memory_order_release);
+	return encontrado;
+}
+
+void abb_rcu_lector_destruir(abb_rcu_lector_t *lector)
+{
+	if (!lector)
+		return;
+	abb_rcu_t *rcu = lector->rcu;
+	pthread_mutex_lock(&rcu->escritores);
+	abb_rcu_lector_t **anterior = &rcu->lectores;
+	while (*anterior != lector)
+		anterior = &(*anterior)->siguiente;
+	*anterior = lector->siguiente;
+	pthread_mutex_unlock(&rcu->escritores);
+	free(lector);
+}
+
+/**
+ * Recibe la raíz de un arbol y un destructor, y lo invoca con cada elemento.
+*/
+void rcu_destruir_elementos(struct nodo_rcu *nodo, void (*destructor)(void *))
+{
+	if (!nodo)
+		return;
+	rcu_destruir_elementos(nodo->izquierda, destructor);
+	destructor(nodo->elemento);
+	rcu_destruir_elementos(nodo->derecha, destructor);
+}
+
+void abb_rcu_destruir(abb_rcu_t *rcu, void (*destructor)(void *))
+{
+	if (!rcu)
+		return;
+	if (destructor)
+		rcu_destruir_elementos(atomic_load(&rcu->raiz), destructor);
+	pthread_mutex_destroy(&rcu->escritores);
+	abb_pool_destruir(rcu->pool);
+	free(rcu);
+}
@@ -0,0 +1,75 @@
+#ifndef __ABB_RCU__H__
+#define __ABB_RCU__H__
+
+#include "abb.h"
+
+typedef struct abb_rcu abb_rcu_t;
+typedef struct abb_rcu_lector abb_rcu_lector_t;
+
+/**
+ * Crea un arbol balanceado (AVL) para compartir entre hilos, en el que las
+ * búsquedas nunca esperan, ni siquiera mientras se modifica el arbol (RCU,
+ * read-copy-update). Los nodos publicados no se modifican nunca: un escritor
+ * copia los nodos del camino que cambia, arma así una raíz nueva que comparte
+ * el resto de los nodos con la anterior, y la publica de una sola vez. Una
+ * búsqueda ve el arbol entero antes o después de cada escritura.
+ *
+ * Los nodos reemplazados se liberan recién cuando ningún lector puede estar
+ * leyéndolos (reclamación por épocas): cada lector anota la época en la que
+ * empieza a buscar, y la época solo avanza cuando todos los lectores activos
+ * llegaron a la actual. Los escritores se excluyen entre sí con un mutex.
+ *
+ * Hace falta compilar con -pthread.
+ *
+ * Devuelve el arbol o NULL en caso de error.
+ */
+abb_rcu_t *abb_rcu_crear(abb_comparador comparador);
+
+/**
+ * Inserta un elemento en el arbol (admite repetidos).
+ *
+ * Devuelve true si lo pudo insertar o false en caso de error, y en ese caso
+ * el arbol no cambia.
+ */
+bool abb_rcu_insertar(abb_rcu_t *rcu, void *elemento);
+
+/**
+ * Quita del arbol un elemento igual al recibido y lo devuelve, o devuelve
+ * NULL si no lo encuentra. Una búsqueda que empezó antes puede seguir
+ * devolviendo el elemento quitado, así que no conviene liberarlo sin saber
+ * que esas búsquedas terminaron.
+ */
+void *abb_rcu_quitar(abb_rcu_t *rcu, void *elemento);
+
+/**
+ * Devuelve la cantidad de elementos del arbol, o 0 si es NULL.
+ */
+size_t abb_rcu_tamanio(abb_rcu_t *rcu);
+
+/**
+ * Registra un lector del arbol. Cada hilo que busca necesita su propio
+ * lector, que no puede compartir con otros hilos.
+ *
+ * Devuelve el lector o NULL en caso de error.
+ */
+abb_rcu_lector_t *abb_rcu_lector_crear(abb_rcu_t *rcu);
+
+/**
+ * Busca en el arbol un elemento igual al provisto. No toma ningún lock.
+ *
+ * Devuelve el elemento encontrado o NULL si no lo encuentra.
+ */
+void *abb_rcu_buscar(abb_rcu_lector_t *lector, void *elemento);
+
+/**
+ * Da de baja un lector.
+ */
+void abb_rcu_lector_destruir(abb_rcu_lector_t *lector);
+
+/**
+ * Destruye el arbol, invocando el destructor con cada elemento si no es
+ * NULL. Todos los lectores tienen que haber sido destruidos antes.
+ */
+void abb_rcu_destruir(abb_rcu_t *rcu, void (*destructor)(void *));
+
+#endif // __ABB_RCU__H__
@@ -0,0 +1,296 @@
+#ifndef __ABB_TIPADO__H__
+#define __ABB_TIPADO__H__
+
+#include "abb_pool.h"
+#include <stdbool.h>
+#include <stdlib.h>
+
+/**
+ * Arboles especializados por tipo de clave. ABB_DEFINIR(nombre, tipo_clave,
+ * cmp) define un arbol balanceado (AVL) cuyos nodos guardan la clave misma en
+ * vez de un void pointer, y que compara con cmp(a, b) directamente en vez de
+ * llamar a un abb_comparador, así el compilador puede expandir la comparación
+ * en cada nivel. cmp recibe dos tipo_clave y devuelve un int con el mismo
+ * significado que un abb_comparador; puede ser una función o una macro.
+ *
+ * Por ejemplo, ABB_DEFINIR(abb_i64, int64_t, ABB_COMPARAR_NUMEROS) define el
+ * tipo abb_i64_t y las funciones abb_i64_crear, abb_i64_insertar,
+ * abb_i64_buscar, abb_i64_quitar, abb_i64_tamanio, abb_i64_con_cada_elemento
+ * y abb_i64_destruir. El arbol de abb.h sigue siendo la versión genérica,
+ * con elementos void pointer.
+ *
+ * Todas las funciones son static inline, así que se puede usar ABB_DEFINIR
+ * en un header sin generar símbolos repetidos.
+ */
+
+/**
+ * Compara dos números de cualquier tipo sin riesgo de overflow.
+ */
+#define ABB_COMPARAR_NUMEROS(a, b) (((a) > (b)) - ((a) < (b)))
+
+/**
+ * Cota de la altura de un AVL con menos de 2^64 nodos (1.44 * 64).
+ */
+#define ABB_TIPADO_ALTURA_MAXIMA 96
+
+#define ABB_DEFINIR(nombre, tipo_clave, cmp)                                  \
+	typedef struct nombre##_nodo {                                        \
+		tipo_clave clave;                                             \
+		struct nombre##_nodo *izquierda;                              \
+		struct nombre##_nodo *derecha;                                \
+		size_t altura;                                                \
+	} nombre##_nodo_t;                                                    \
+                                                                              \
+	typedef struct nombre {                                               \
+		nombre##_nodo_t *raiz;                                        \
+		size_t tamanio;                                               \
+		struct abb_pool *pool;                                        \
+	} nombre##_t;                                                         \
+                                                                              \
+	/**                                                                   \
+	 * Crea un arbol vacío. Devuelve NULL en caso de error.               \
+	 */                                                                   \
+	static inline nombre##_t *nombre##_crear(void)                        \
+	{                                                                     \
+		nombre##_t *arbol = calloc(1, sizeof(nombre##_t));            \
+		if (!arbol)                                                   \
+			return NULL;                                          \
+		arbol->pool = abb_pool_crear(sizeof(nombre##_nodo_t));        \
+		if (!arbol->pool) {                                           \
+			free(arbol);                                          \
+			return NULL;                                          \
+		}                                                             \
+		return arbol;                                                 \
+	}                                                                     \
+                                                                              \
+	static inline size_t nombre##_nodo_altura(nombre##_nodo_t *nodo)      \
+	{                                                                     \
+		return nodo ? nodo->altura : 0;                               \
+	}                                                                     \
+                                                                              \
+	static inline void nombre##_nodo_actualizar(nombre##_nodo_t *nodo)    \
+	{                                                                     \
+		size_t altura_izquierda =                                     \
+			nombre##_nodo_altura(nodo->izquierda);                \
+		size_t altura_derecha = nombre##_nodo_altura(nodo->derecha);  \
+		nodo->altura = (altura_izquierda > altura_derecha ?           \
+					altura_izquierda :                    \
+					altura_derecha) +                     \
+			       1;                                             \
+	}                                                                     \
+                                                                              \
+	static inline nombre##_nodo_t *nombre##_rotar_a_derecha(              \
+		nombre##_nodo_t *nodo)                                        \
+	{                                                                     \
+		nombre##_nodo_t *nueva_raiz = nodo->izquierda;                \
+		nodo->izquierda = nueva_raiz->derecha;                        \
+		nueva_raiz->derecha = nodo;                                   \
+		nombre##_nodo_actualizar(nodo);                               \
+		nombre##_nodo_actualizar(nueva_raiz);                         \
+		return nueva_raiz;                                            \
+	}                                                                     \
+                                                                              \
+	static inline nombre##_nodo_t *nombre##_rotar_a_izquierda(            \
+		nombre##_nodo_t *nodo)                                        \
+	{                                                                     \
+		nombre##_nodo_t *nueva_raiz = nodo->derecha;                  \
+		nodo->derecha = nueva_raiz->izquierda;                        \
+		nueva_raiz->izquierda = nodo;                                 \
+		nombre##_nodo_actualizar(nodo);                               \
+		nombre##_nodo_actualizar(nueva_raiz);                         \
+		return nueva_raiz;                                            \
+	}                                                                     \
+                                                                              \
+	static inline nombre##_nodo_t *nombre##_balancear(                    \
+		nombre##_nodo_t *nodo)                                        \
+	{                                                                     \
+		size_t altura_izquierda =                                     \
+			nombre##_nodo_altura(nodo->izquierda);                \
+		size_t altura_derecha = nombre##_nodo_altura(nodo->derecha);  \
+		if (altura_izquierda > altura_derecha + 1) {                  \
+			if (nombre##_nodo_altura(nodo->izquierda->derecha) >  \
+			    nombre##_nodo_altura(nodo->izquierda->izquierda)) \
+				nodo->izquierda = nombre##_rotar_a_izquierda( \
+					nodo->izquierda);                     \
+			return nombre##_rotar_a_derecha(nodo);                \
+		}                                                             \
+		if (altura_derecha > altura_izquierda + 1) {                  \
+			if (nombre##_nodo_altura(nodo->derecha->izquierda) >  \
+			    nombre##_nodo_altura(nodo->derecha->derecha))     \
+				nodo->derecha = nombre##_rotar_a_derecha(     \
+					nodo->derecha);                       \
+			return nombre##_rotar_a_izquierda(nodo);              \
+		}                                                             \
+		nombre##_nodo_actualizar(nodo);                               \
+		return nodo;                                                  \
+	}                                                                     \
+                                                                              \
+	static inline nombre##_nodo_t *nombre##_insertar_nodo(                \
+		nombre##_nodo_t *nodo_actual, nombre##_nodo_t *nuevo_nodo)    \
+	{                                                                     \
+		if (!nodo_actual)                                             \
+			return nuevo_nodo;                                    \
+		if (cmp(nodo_actual->clave, nuevo_nodo->clave) >= 0)          \
+			nodo_actual->izquierda = nombre##_insertar_nodo(      \
+				nodo_actual->izquierda, nuevo_nodo);          \
+		else                                                          \
+			nodo_actual->derecha = nombre##_insertar_nodo(        \
+				nodo_actual->derecha, nuevo_nodo);            \
+		return nombre##_balancear(nodo_actual);                       \
+	}                                                                     \
+                                                                              \
+	/**                                                                   \
+	 * Inserta una clave en el arbol (admite repetidas). Devuelve false   \
+	 * en caso de error.                                                  \
+	 */                                                                   \
+	static inline bool nombre##_insertar(nombre##_t *arbol,               \
+					     tipo_clave clave)                \
+	{                                                                     \
+		if (!arbol)                                                   \
+			return false;                                         \
+		nombre##_nodo_t *nuevo_nodo = abb_pool_obtener(arbol->pool);  \
+		if (!nuevo_nodo)                                              \
+			return false;                                         \
+		nuevo_nodo->clave = clave;                                    \
+		nuevo_nodo->altura = 1;                                       \
+		arbol->raiz = nombre##_insertar_nodo(arbol->raiz, nuevo_nodo); \
+		arbol->tamanio++;                                             \
+		return true;                                                  \
+	}                                                                     \
+                                                                              \
+	/**                                                                   \
+	 * Devuelve un puntero a la primera clave del arbol igual a la        \
+	 * recibida, o NULL si no hay ninguna. El puntero deja de ser válido  \
+	 * al modificar el arbol.                                             \
+	 */                                                                   \
+	static inline tipo_clave *nombre##_buscar(nombre##_t *arbol,          \
+						  tipo_clave clave)           \
+	{                                                                     \
+		if (!arbol)                                                   \
+			return NULL;                                          \
+		nombre##_nodo_t *nodo_actual = arbol->raiz;                   \
+		while (nodo_actual) {                                         \
+			int comparacion = cmp(nodo_actual->clave, clave);     \
+			if (comparacion == 0)                                 \
+				return &nodo_actual->clave;                   \
+			nodo_actual = comparacion < 0 ?                       \
+					      nodo_actual->derecha :          \
+					      nodo_actual->izquierda;         \
+		}                                                             \
+		return NULL;                                                  \
+	}                                                                     \
+                                                                              \
+	static inline nombre##_nodo_t *nombre##_quitar_maximo(                \
+		nombre##_t *arbol, nombre##_nodo_t *nodo_actual,              \
+		tipo_clave *clave_maxima)                                     \
+	{                                                                     \
+		if (!nodo_actual->derecha) {                                  \
+			nombre##_nodo_t *hijo_izquierdo =                     \
+				nodo_actual->izquierda;                       \
+			*clave_maxima = nodo_actual->clave;                   \
+			abb_pool_devolver(arbol->pool, nodo_actual);          \
+			return hijo_izquierdo;                                \
+		}                                                             \
+		nodo_actual->derecha = nombre##_quitar_maximo(                \
+			arbol, nodo_actual->derecha, clave_maxima);           \
+		return nombre##_balancear(nodo_actual);                       \
+	}                                                                     \
+                                                                              \
+	static inline nombre##_nodo_t *nombre##_quitar_nodo(                  \
+		nombre##_t *arbol, nombre##_nodo_t *nodo_actual,              \
+		tipo_clave clave, bool *encontrado)                           \
+	{                                                                     \
+		if (!nodo_actual)                                             \
+			return NULL;                                          \
+		int comparacion = cmp(nodo_actual->clave, clave);             \
+		if (comparacion > 0) {                                        \
+			nodo_actual->izquierda = nombre##_quitar_nodo(        \
+				arbol, nodo_actual->izquierda, clave,         \
+				encontrado);                                  \
+		} else if (comparacion < 0) {                                 \
+			nodo_actual->derecha = nombre##_quitar_nodo(          \
+				arbol, nodo_actual->derecha, clave,           \
+				encontrado);                                  \
+		} else {                                                      \
+			*encontrado = true;                                   \
+			if (!nodo_actual->izquierda ||                        \
+			    !nodo_actual->derecha) {                          \
+				nombre##_nodo_t *hijo =                       \
+					nodo_actual->izquierda ?              \
+						nodo_actual->izquierda :      \
+						nodo_actual->derecha;         \
+				abb_pool_devolver(arbol->pool, nodo_actual);  \
+				return hijo;                                  \
+			}                                                     \
+			nodo_actual->izquierda = nombre##_quitar_maximo(      \
+				arbol, nodo_actual->izquierda,                \
+				&nodo_actual->clave);                         \
+		}                                                             \
+		return nombre##_balancear(nodo_actual);                       \
+	}                                                                     \
+                                                                              \
+	/**                                                                   \
+	 * Quita del arbol una clave igual a la recibida. Devuelve true si    \
+	 * la encontró.                                                       \
+	 */                                                                   \
+	static inline bool nombre##_quitar(nombre##_t *arbol,                 \
+					   tipo_clave clave)                  \
+	{                                                                     \
+		if (!arbol)                                                   \
+			return false;                                         \
+		bool encontrado = false;                                      \
+		arbol->raiz = nombre##_quitar_nodo(arbol, arbol->raiz, clave, \
+						   &encontrado);              \
+		if (encontrado)                                               \
+			arbol->tamanio--;                                     \
+		return encontrado;                                            \
+	}                                                                     \
+                                                                              \
+	/**                                                                   \
+	 * Devuelve la cantidad de claves del arbol, o 0 si es NULL.          \
+	 */                                                                   \
+	static inline size_t nombre##_tamanio(nombre##_t *arbol)              \
+	{                                                                     \
+		return arbol ? arbol->tamanio : 0;                            \
+	}                                                                     \
+                                                                              \
+	/**                                                                   \
+	 * Invoca la función con un puntero a cada clave del arbol, de menor  \
+	 * a mayor, hasta que devuelva false. Devuelve la cantidad de veces   \
+	 * que fue invocada.                                                  \
+	 */                                                                   \
+	static inline size_t nombre##_con_cada_elemento(                      \
+		nombre##_t *arbol, bool (*funcion)(tipo_clave *, void *),     \
+		void *aux)                                                    \
+	{                                                                     \
+		if (!arbol || !funcion)                                       \
+			return 0;                                             \
+		nombre##_nodo_t *pila[ABB_TIPADO_ALTURA_MAXIMA];              \
+		size_t tope = 0, contador = 0;                                \
+		nombre##_nodo_t *nodo_actual = arbol->raiz;                   \
+		while (nodo_actual || tope > 0) {                             \
+			while (nodo_actual) {                                 \
+				pila[tope++] = nodo_actual;                   \
+				nodo_actual = nodo_actual->izquierda;         \
+			}                                                     \
+			nodo_actual = pila[--tope];                           \
+			contador++;                                           \
+			if (!funcion(&nodo_actual->clave, aux))               \
+				break;                                        \
+			nodo_actual = nodo_actual->derecha;                   \
+		}                                                             \
+		return contador;                                              \
+	}                                                                     \
+                                                                              \
+	/**                                                                   \
+	 * Destruye el arbol. Los nodos se liberan junto con el pool.         \
+	 */                                                                   \
+	static inline void nombre##_destruir(nombre##_t *arbol)               \
+	{                                                                     \
+		if (!arbol)                                                   \
+			return;                                               \
+		abb_pool_destruir(arbol->pool);                               \
+		free(arbol);                                                  \
+	}
+
+#endif // __ABB_TIPADO__H__